@@ -0,0 +1,356 @@
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "aio.h"
+
+typedef struct tUring
+{
+    int fd;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    _Atomic unsigned *sq_head;
+    _Atomic unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    _Atomic unsigned *cq_head;
+    _Atomic unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+} tUring;
+
+typedef struct tAioDone
+{
+    uint32_t tag;
+    int result;
+} tAioDone;
+
+static int g_backend = -1;  // Backend in use, -1 when not started.
+static uint8_t g_in_flight = 0;
+static tAioDrain g_drain = NULL;  // Receives the completions collected by aio_destroy().
+
+static tUring g_uring;
+static uint32_t g_expected[AIO_QUEUE_DEPTH];  // Bytes an io_uring read of the tag has to return.
+static int g_inline[AIO_QUEUE_DEPTH];         // Result of a read done at submission, or 1 for a real read.
+
+static pthread_t g_workers[AIO_WORKERS];
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_submitted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_completed = PTHREAD_COND_INITIALIZER;
+static tAioRead g_pending[AIO_QUEUE_DEPTH];
+static uint8_t g_pending_head = 0;
+static uint8_t g_pending_cnt = 0;
+static tAioDone g_done[AIO_QUEUE_DEPTH];
+static uint8_t g_done_head = 0;
+static uint8_t g_done_cnt = 0;
+static uint8_t g_stop = 0;
+
+static int uring_init()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, AIO_QUEUE_DEPTH, &params);
+    if (fd < 0)
+        return -1;
+
+    tUring *ring = &g_uring;
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = fd;
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cq_ring_size > ring->sq_ring_size)
+            ring->sq_ring_size = ring->cq_ring_size;
+        ring->cq_ring_size = 0;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+        IORING_OFF_SQ_RING);
+    ring->cq_ring = ring->sq_ring;
+    if (ring->sq_ring != MAP_FAILED && ring->cq_ring_size != 0)
+    {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+            IORING_OFF_CQ_RING);
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        if (ring->sqes != MAP_FAILED)
+            munmap(ring->sqes, ring->sqes_size);
+        if (ring->cq_ring_size != 0 && ring->cq_ring != MAP_FAILED)
+            munmap(ring->cq_ring, ring->cq_ring_size);
+        if (ring->sq_ring != MAP_FAILED)
+            munmap(ring->sq_ring, ring->sq_ring_size);
+        close(fd);
+        return -1;
+    }
+
+    uint8_t *sq = (uint8_t *)ring->sq_ring;
+    uint8_t *cq = (uint8_t *)ring->cq_ring;
+    ring->sq_head = (_Atomic unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (_Atomic unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (_Atomic unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (_Atomic unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+static void uring_destroy()
+{
+    tUring *ring = &g_uring;
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring_size != 0)
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+static int uring_submit(const tAioRead *read)
+{
+    tUring *ring = &g_uring;
+    const unsigned tail = atomic_load_explicit(ring->sq_tail, memory_order_relaxed);
+    const unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = read->tag;
+
+    int fd = -1;
+    uint64_t offset = 0;
+    if (read->backing->page_location != NULL &&
+        read->backing->page_location(read->store, read->page_id, read->page_size, &fd, &offset) == 0)
+    {
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->off = offset;
+        sqe->addr = (uint64_t)(uintptr_t)read->frame;
+        sqe->len = read->page_size;
+        g_expected[read->tag] = read->page_size;
+        g_inline[read->tag] = 1;
+    }
+    else
+    {
+        // No file behind the page, the read is done now and only its completion goes through the ring.
+        sqe->opcode = IORING_OP_NOP;
+        g_inline[read->tag] = read->backing->read_page(read->store, read->page_id, read->frame, read->page_size);
+    }
+
+    ring->sq_array[index] = index;
+    atomic_store_explicit(ring->sq_tail, tail + 1, memory_order_release);
+    // Once the tail is published any later enter would submit the read, so transient errors are retried.
+    // EBUSY cannot last: at most AIO_QUEUE_DEPTH reads are in flight, fewer than the completion queue holds.
+    long ret;
+    do
+    {
+        ret = syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+    } while (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+
+    if (ret == 1 || atomic_load_explicit(ring->sq_head, memory_order_acquire) != tail)
+        return 0;
+
+    // The kernel did not take the read, withdraw it so that no later enter reads into the frame.
+    atomic_store_explicit(ring->sq_tail, tail, memory_order_release);
+    return -1;
+}
+
+static int uring_reap(uint32_t *tags, int *results, int max, uint8_t wait)
+{
+    tUring *ring = &g_uring;
+    unsigned head = atomic_load_explicit(ring->cq_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+    if (head == tail && wait)
+    {
+        syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        tail = atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+    }
+
+    int cnt = 0;
+    for (; head != tail && cnt < max; head++, cnt++)
+    {
+        const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        const uint32_t tag = (uint32_t)cqe->user_data;
+        tags[cnt] = tag;
+        if (g_inline[tag] != 1)
+            results[cnt] = (g_inline[tag] == 0) ? 0 : -1;
+        else
+            results[cnt] = (cqe->res == (int)g_expected[tag]) ? 0 : -1;
+    }
+    atomic_store_explicit(ring->cq_head, head, memory_order_release);
+    return cnt;
+}
+
+static void *worker(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&g_lock);
+    while (1)
+    {
+        while (g_pending_cnt == 0 && g_stop == 0)
+            pthread_cond_wait(&g_submitted, &g_lock);
+
+        if (g_pending_cnt == 0)
+            break;
+
+        const tAioRead read = g_pending[g_pending_head];
+        g_pending_head = (g_pending_head + 1) % AIO_QUEUE_DEPTH;
+        g_pending_cnt--;
+        pthread_mutex_unlock(&g_lock);
+
+        int result = read.backing->read_page(read.store, read.page_id, read.frame, read.page_size);
+
+        pthread_mutex_lock(&g_lock);
+        tAioDone *done = &g_done[(g_done_head + g_done_cnt) % AIO_QUEUE_DEPTH];
+        done->tag = read.tag;
+        done->result = (result == 0) ? 0 : -1;
+        g_done_cnt++;
+        pthread_cond_signal(&g_completed);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return NULL;
+}
+
+static int threads_init()
+{
+    g_stop = 0;
+    g_pending_head = g_pending_cnt = 0;
+    g_done_head = g_done_cnt = 0;
+    for (uint8_t id = 0; id < AIO_WORKERS; id++)
+    {
+        if (pthread_create(&g_workers[id], NULL, worker, NULL) != 0)
+        {
+            pthread_mutex_lock(&g_lock);
+            g_stop = 1;
+            pthread_cond_broadcast(&g_submitted);
+            pthread_mutex_unlock(&g_lock);
+            while (id > 0)
+                pthread_join(g_workers[--id], NULL);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void threads_destroy()
+{
+    pthread_mutex_lock(&g_lock);
+    g_stop = 1;
+    pthread_cond_broadcast(&g_submitted);
+    pthread_mutex_unlock(&g_lock);
+    for (uint8_t id = 0; id < AIO_WORKERS; id++)
+    {
+        pthread_join(g_workers[id], NULL);
+    }
+}
+
+static int threads_submit(const tAioRead *read)
+{
+    pthread_mutex_lock(&g_lock);
+    g_pending[(g_pending_head + g_pending_cnt) % AIO_QUEUE_DEPTH] = *read;
+    g_pending_cnt++;
+    pthread_cond_signal(&g_submitted);
+    pthread_mutex_unlock(&g_lock);
+    return 0;
+}
+
+static int threads_reap(uint32_t *tags, int *results, int max, uint8_t wait)
+{
+    pthread_mutex_lock(&g_lock);
+    while (wait && g_done_cnt == 0)
+        pthread_cond_wait(&g_completed, &g_lock);
+
+    int cnt = 0;
+    for (; g_done_cnt > 0 && cnt < max; cnt++)
+    {
+        tags[cnt] = g_done[g_done_head].tag;
+        results[cnt] = g_done[g_done_head].result;
+        g_done_head = (g_done_head + 1) % AIO_QUEUE_DEPTH;
+        g_done_cnt--;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return cnt;
+}
+
+int aio_init(uint8_t backend)
+{
+    if (g_backend != -1)
+        return -1;
+
+    if ((backend == AIO_AUTO || backend == AIO_URING) && uring_init() == 0)
+        g_backend = AIO_URING;
+    else if ((backend == AIO_AUTO || backend == AIO_THREADS) && threads_init() == 0)
+        g_backend = AIO_THREADS;
+
+    g_in_flight = 0;
+    return g_backend;
+}
+
+void aio_destroy()
+{
+    if (g_backend == -1)
+        return;
+
+    uint32_t tags[AIO_QUEUE_DEPTH];
+    int results[AIO_QUEUE_DEPTH];
+    while (g_in_flight > 0)
+    {
+        const int cnt = aio_reap(tags, results, AIO_QUEUE_DEPTH, 1);
+        for (int id = 0; g_drain != NULL && id < cnt; id++)
+        {
+            g_drain(tags[id], results[id]);
+        }
+    }
+
+    if (g_backend == AIO_URING)
+        uring_destroy();
+    else
+        threads_destroy();
+    g_backend = -1;
+}
+
+void aio_set_drain(tAioDrain drain)
+{
+    g_drain = drain;
+}
+
+int aio_submit(const tAioRead *read)
+{
+    if (g_backend == -1 || read == NULL || read->tag >= AIO_QUEUE_DEPTH || g_in_flight >= AIO_QUEUE_DEPTH)
+        return -1;
+
+    int ret = (g_backend == AIO_URING) ? uring_submit(read) : threads_submit(read);
+    if (ret == 0)
+        g_in_flight++;
+    return ret;
+}
+
+int aio_ready()
+{
+    return g_backend != -1 && g_in_flight < AIO_QUEUE_DEPTH;
+}
+
+int aio_reap(uint32_t *tags, int *results, int max, uint8_t wait)
+{
+    if (g_backend == -1)
+        return -1;
+
+    if (g_in_flight == 0)
+        return 0;
+
+    int cnt = (g_backend == AIO_URING) ? uring_reap(tags, results, max, wait) : threads_reap(tags, results, max, wait);
+    g_in_flight -= cnt;
+    return cnt;
+}
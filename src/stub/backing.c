@@ -0,0 +1,138 @@
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "backing.h"
+
+static int memory_read_page(void *store, uint16_t page_id, uint8_t *frame, uint16_t page_size)
+{
+    memcpy(frame, (uint8_t *)store + (page_id * page_size), page_size);
+    return 0;
+}
+
+static int memory_write_page(void *store, uint16_t page_id, const uint8_t *frame, uint16_t page_size)
+{
+    memcpy((uint8_t *)store + (page_id * page_size), frame, page_size);
+    return 0;
+}
+
+const tBackingOps memory_backing_ops = {
+    .read_page = memory_read_page,
+    .write_page = memory_write_page,
+};
+
+static int unbound_read_page(void *store, uint16_t page_id, uint8_t *frame, uint16_t page_size)
+{
+    (void)store;
+    (void)page_id;
+    (void)frame;
+    (void)page_size;
+    return -1;
+}
+
+static int unbound_write_page(void *store, uint16_t page_id, const uint8_t *frame, uint16_t page_size)
+{
+    (void)store;
+    (void)page_id;
+    (void)frame;
+    (void)page_size;
+    return -1;
+}
+
+const tBackingOps unbound_backing_ops = {
+    .read_page = unbound_read_page,
+    .write_page = unbound_write_page,
+};
+
+static int file_read_page(void *store, uint16_t page_id, uint8_t *frame, uint16_t page_size)
+{
+    const tFileBacking *file = (const tFileBacking *)store;
+    if (file->map == NULL || (uint32_t)(page_id + 1) * page_size > file->size)
+        return -1;
+
+    memcpy(frame, file->map + (page_id * page_size), page_size);
+    return 0;
+}
+
+static int file_write_page(void *store, uint16_t page_id, const uint8_t *frame, uint16_t page_size)
+{
+    tFileBacking *file = (tFileBacking *)store;
+    if (file->map == NULL || (uint32_t)(page_id + 1) * page_size > file->size)
+        return -1;
+
+    memcpy(file->map + (page_id * page_size), frame, page_size);
+    return 0;
+}
+
+static int file_page_location(void *store, uint16_t page_id, uint16_t page_size, int *fd, uint64_t *offset)
+{
+    const tFileBacking *file = (const tFileBacking *)store;
+    if (file->map == NULL || (uint32_t)(page_id + 1) * page_size > file->size)
+        return -1;
+
+    *fd = file->fd;
+    *offset = (uint64_t)page_id * page_size;
+    return 0;
+}
+
+const tBackingOps file_backing_ops = {
+    .read_page = file_read_page,
+    .write_page = file_write_page,
+    .page_location = file_page_location,
+};
+
+int file_backing_open(tFileBacking *file, const char *path, uint32_t size)
+{
+    if (file == NULL || path == NULL || size == 0)
+        return -1;
+
+    file->fd = -1;
+    file->map = NULL;
+    file->size = 0;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return -2;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (st.st_size < (off_t)size && ftruncate(fd, size) != 0))
+    {
+        close(fd);
+        return -2;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        close(fd);
+        return -2;
+    }
+
+    file->fd = fd;
+    file->map = (uint8_t *)map;
+    file->size = size;
+    return 0;
+}
+
+int file_backing_sync(tFileBacking *file)
+{
+    if (file == NULL || file->map == NULL)
+        return -1;
+
+    return (msync(file->map, file->size, MS_SYNC) == 0) ? 0 : -1;
+}
+
+void file_backing_close(tFileBacking *file)
+{
+    if (file == NULL || file->map == NULL)
+        return;
+
+    munmap(file->map, file->size);
+    close(file->fd);
+    file->fd = -1;
+    file->map = NULL;
+    file->size = 0;
+}
@@ -0,0 +1,320 @@
+#include <stdatomic.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "bitmap.h"
+
+// Loads the 64 bits starting at bit 64 * word, bits past the end read as set.
+static uint64_t load_word(const uint8_t *bitmap, uint32_t bits, uint32_t word)
+{
+    const uint32_t first = word * 64;
+    uint64_t value = 0;
+    if (bits - first >= 64)
+    {
+        memcpy(&value, bitmap + word * 8, sizeof(value));
+        return value;
+    }
+
+    const uint32_t valid = bits - first;
+    memcpy(&value, bitmap + word * 8, (valid + 7) / 8);
+    return value | (~0ull << valid);
+}
+
+void bitmap_set_range(uint8_t *bitmap, uint32_t first, uint32_t count)
+{
+    for (; count > 0 && first % 8 != 0; first++, count--)
+        bitmap[first / 8] |= (0x01 << (first % 8));
+
+    memset(bitmap + first / 8, 0xff, count / 8);
+    first += count / 8 * 8;
+    count %= 8;
+
+    for (; count > 0; first++, count--)
+        bitmap[first / 8] |= (0x01 << (first % 8));
+}
+
+void bitmap_clear_range(uint8_t *bitmap, uint32_t first, uint32_t count)
+{
+    for (; count > 0 && first % 8 != 0; first++, count--)
+        bitmap[first / 8] &= ~(0x01 << (first % 8));
+
+    memset(bitmap + first / 8, 0x00, count / 8);
+    first += count / 8 * 8;
+    count %= 8;
+
+    for (; count > 0; first++, count--)
+        bitmap[first / 8] &= ~(0x01 << (first % 8));
+}
+
+uint32_t bitmap_count(const uint8_t *bitmap, uint32_t bits)
+{
+    uint32_t count = 0;
+    const uint32_t words = (bits + 63) / 64;
+    for (uint32_t word = 0; word < words; word++)
+    {
+        count += __builtin_popcountll(load_word(bitmap, bits, word));
+    }
+    // Bits past the end were loaded as set.
+    return count - (words * 64 - bits);
+}
+
+// Finds a run of clear bits as bitmap_find_clear_run(). With a summary, full words are skipped through it.
+static int32_t find_clear_run(const uint8_t *bitmap, const uint8_t *summary, uint32_t bits, uint32_t start,
+    uint32_t length)
+{
+    if (length == 0 || start >= bits)
+        return -1;
+
+    const uint32_t words = (bits + 63) / 64;
+
+    uint32_t run = 0;
+    uint32_t run_start = start;
+    uint32_t bit = start;
+    while (bit < bits)
+    {
+        if (bit % 64 != 0)
+        {
+            // Bit by bit up to the next word.
+            if (bitmap_test(bitmap, bit))
+                run = 0;
+            else if (run++ == 0)
+                run_start = bit;
+
+            if (run == length)
+                return run_start;
+            bit++;
+            continue;
+        }
+
+        if (summary != NULL && run == 0)
+        {
+            // Jumps to the next word that is not full.
+            const int32_t word = find_clear_run(summary, NULL, words, bit / 64, 1);
+            if (word < 0)
+                break;
+            bit = word * 64;
+        }
+
+#ifdef __SSE2__
+        // Skips fully used 128-bit blocks while no run is open.
+        while (run == 0 && bits - bit >= 128 &&
+               _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(bitmap + bit / 8)),
+                   _mm_set1_epi8((char)0xff))) == 0xffff)
+        {
+            bit += 128;
+        }
+        if (bit >= bits)
+            break;
+#endif
+
+        const uint64_t used = load_word(bitmap, bits, bit / 64);
+        if (used == ~0ull)
+        {
+            run = 0;
+            bit += 64;
+            continue;
+        }
+        if (used == 0)
+        {
+            if (run == 0)
+                run_start = bit;
+            run += 64;
+            if (run >= length)
+                return run_start;
+            bit += 64;
+            continue;
+        }
+
+        // Mixed word: runs of clear bits are found with trailing-zero counts.
+        uint64_t rest = used;
+        uint32_t offset = 0;
+        while (offset < 64)
+        {
+            const uint32_t clear = (rest == 0) ? 64 - offset : (uint32_t)__builtin_ctzll(rest);
+            if (clear > 0)
+            {
+                if (run == 0)
+                    run_start = bit + offset;
+                run += clear;
+                if (run >= length)
+                    return run_start;
+                offset += clear;
+                rest = (clear == 64) ? 0 : rest >> clear;
+                continue;
+            }
+            const uint32_t set = (~rest == 0) ? 64 - offset : (uint32_t)__builtin_ctzll(~rest);
+            run = 0;
+            offset += set;
+            rest = (set == 64) ? 0 : rest >> set;
+        }
+        bit += 64;
+    }
+    return -1;
+}
+
+int32_t bitmap_find_clear_run(const uint8_t *bitmap, uint32_t bits, uint32_t start, uint32_t length)
+{
+    return find_clear_run(bitmap, NULL, bits, start, length);
+}
+
+// Returns the first set bit at or after bit start, or bits if there is none.
+static uint32_t find_set(const uint8_t *bitmap, uint32_t bits, uint32_t start)
+{
+    uint32_t word = start / 64;
+    uint64_t used = load_word(bitmap, bits, word) & (~0ull << (start % 64));
+    while (used == 0 && (word + 1) * 64 < bits)
+    {
+        used = load_word(bitmap, bits, ++word);
+    }
+    if (used == 0)
+        return bits;
+
+    const uint32_t bit = word * 64 + __builtin_ctzll(used);
+    return (bit < bits) ? bit : bits;
+}
+
+int32_t bitmap_next_clear_run(const uint8_t *bitmap, uint32_t bits, uint32_t start, uint32_t *length)
+{
+    return bitmap_summary_next_clear_run(bitmap, NULL, bits, start, length);
+}
+
+int32_t bitmap_summary_next_clear_run(const uint8_t *bitmap, const uint8_t *summary, uint32_t bits, uint32_t start,
+    uint32_t *length)
+{
+    const int32_t first = find_clear_run(bitmap, summary, bits, start, 1);
+    if (first < 0)
+        return -1;
+
+    *length = find_set(bitmap, bits, first) - first;
+    return first;
+}
+
+uint32_t bitmap_largest_clear_run(const uint8_t *bitmap, uint32_t bits)
+{
+    uint32_t largest = 0;
+    uint32_t run = 0;
+    const uint32_t words = (bits + 63) / 64;
+    for (uint32_t word = 0; word < words; word++)
+    {
+        uint64_t rest = load_word(bitmap, bits, word);
+        if (rest == ~0ull)
+        {
+            run = 0;
+            continue;
+        }
+
+        uint32_t offset = 0;
+        while (offset < 64)
+        {
+            const uint32_t clear = (rest == 0) ? 64 - offset : (uint32_t)__builtin_ctzll(rest);
+            if (clear > 0)
+            {
+                run += clear;
+                if (run > largest)
+                    largest = run;
+                offset += clear;
+                rest = (clear == 64) ? 0 : rest >> clear;
+                continue;
+            }
+            const uint32_t set = (~rest == 0) ? 64 - offset : (uint32_t)__builtin_ctzll(~rest);
+            run = 0;
+            offset += set;
+            rest = (set == 64) ? 0 : rest >> set;
+        }
+    }
+    return largest;
+}
+
+void bitmap_summary_update(const uint8_t *bitmap, uint8_t *summary, uint32_t bits, uint32_t first, uint32_t count)
+{
+    if (count == 0)
+        return;
+
+    const uint32_t last = (first + count - 1) / 64;
+    for (uint32_t word = first / 64; word <= last; word++)
+    {
+        if (load_word(bitmap, bits, word) == ~0ull)
+            summary[word / 8] |= (0x01 << (word % 8));
+        else
+            summary[word / 8] &= ~(0x01 << (word % 8));
+    }
+}
+
+int32_t bitmap_summary_find_clear_run(const uint8_t *bitmap, const uint8_t *summary, uint32_t bits, uint32_t start,
+    uint32_t length)
+{
+    return find_clear_run(bitmap, summary, bits, start, length);
+}
+
+// Mask of the bits of byte byte that lie in [first, first + count).
+static uint8_t byte_mask(uint32_t byte, uint32_t first, uint32_t count)
+{
+    const uint32_t low = (first > byte * 8) ? first - byte * 8 : 0;
+    const uint32_t high = (first + count < byte * 8 + 8) ? first + count - byte * 8 : 8;
+    return (uint8_t)((0xff << low) & (0xff >> (8 - high)));
+}
+
+int32_t bitmap_atomic_claim(uint8_t *bitmap, uint32_t bits, uint32_t start)
+{
+    int32_t bit = start;
+    while (bit >= 0 && (bit = find_clear_run(bitmap, NULL, bits, bit, 1)) >= 0)
+    {
+        // The search only points at a candidate byte, a compare-and-swap claims it.
+        const uint32_t byte = bit / 8;
+        _Atomic uint8_t *target = (_Atomic uint8_t *)(bitmap + byte);
+        const uint8_t mask = byte_mask(byte, bit, bits - bit);
+        uint8_t value = atomic_load_explicit(target, memory_order_relaxed);
+        uint8_t clear = 0;
+        while ((clear = ~value & mask) != 0)
+        {
+            const uint8_t chosen = clear & -clear;
+            if (atomic_compare_exchange_weak_explicit(target, &value, value | chosen, memory_order_acquire,
+                    memory_order_relaxed))
+                return byte * 8 + __builtin_ctz(chosen);
+        }
+        bit = ((byte + 1) * 8 < bits) ? (int32_t)(byte + 1) * 8 : -1;
+    }
+    return -1;
+}
+
+int bitmap_atomic_set_range(uint8_t *bitmap, uint32_t first, uint32_t count)
+{
+    if (count == 0)
+        return 0;
+
+    const uint32_t last = (first + count - 1) / 8;
+    for (uint32_t byte = first / 8; byte <= last; byte++)
+    {
+        _Atomic uint8_t *target = (_Atomic uint8_t *)(bitmap + byte);
+        const uint8_t mask = byte_mask(byte, first, count);
+        uint8_t value = atomic_load_explicit(target, memory_order_relaxed);
+        do
+        {
+            if (value & mask)
+            {
+                // Gives back the bytes claimed so far.
+                if (byte > first / 8)
+                    bitmap_atomic_clear_range(bitmap, first, byte * 8 - first);
+                return -1;
+            }
+        } while (!atomic_compare_exchange_weak_explicit(target, &value, value | mask, memory_order_acquire,
+            memory_order_relaxed));
+    }
+    return 0;
+}
+
+void bitmap_atomic_clear_range(uint8_t *bitmap, uint32_t first, uint32_t count)
+{
+    if (count == 0)
+        return;
+
+    const uint32_t last = (first + count - 1) / 8;
+    for (uint32_t byte = first / 8; byte <= last; byte++)
+    {
+        atomic_fetch_and_explicit((_Atomic uint8_t *)(bitmap + byte), (uint8_t)~byte_mask(byte, first, count),
+            memory_order_release);
+    }
+}
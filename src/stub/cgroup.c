@@ -0,0 +1,245 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "cgroup.h"
+#include "ram.h"
+#include "task.h"
+
+static tCgroup g_groups[CGROUP_MAX] = {{.parent = -1}};
+static uint8_t g_used[CGROUP_MAX] = {0x1};        // Groups in use, the root group always is.
+static uint8_t g_task_group[TASK_TABLE_SIZE];     // Group of the task slots.
+static tFrameId g_task_frames[TASK_TABLE_SIZE];   // Frames charged to the task slots.
+
+static tCgroup *find_group(int group)
+{
+    if (group < 0 || group >= CGROUP_MAX || !g_used[group])
+        return NULL;
+
+    return &g_groups[group];
+}
+
+// Frames the group holds in its parent.
+static tFrameId held(const tCgroup *group, tFrameId committed)
+{
+    return (committed > group->reservation) ? committed : group->reservation;
+}
+
+// Checks whether frames more can be committed in the group and its ancestors.
+// Returns NULL, or the first group whose limit would be exceeded.
+static tCgroup *check_commit(tCgroup *group, tFrameId frames)
+{
+    for (; group != NULL && frames != 0; group = find_group(group->parent))
+    {
+        if (group->limit != 0 && group->committed + frames > group->limit)
+            return group;
+
+        frames = held(group, group->committed + frames) - held(group, group->committed);
+    }
+    return NULL;
+}
+
+// Adds frames to committed of the group and what that changes to its ancestors, and frames to usage of all of them.
+static void commit(tCgroup *group, tFrameId committed, tFrameId usage)
+{
+    for (; group != NULL; group = find_group(group->parent))
+    {
+        const tFrameId before = held(group, group->committed);
+        group->committed += committed;
+        group->usage += usage;
+        committed = held(group, group->committed) - before;
+    }
+}
+
+// Removes frames from committed of the group and what that changes to its ancestors, and frames from usage of all.
+static void uncommit(tCgroup *group, tFrameId committed, tFrameId usage)
+{
+    for (; group != NULL; group = find_group(group->parent))
+    {
+        const tFrameId before = held(group, group->committed);
+        group->committed -= committed;
+        group->usage -= usage;
+        committed = before - held(group, group->committed);
+    }
+}
+
+static int valid_task(int pid)
+{
+    return pid >= 0 && pid < TASK_TABLE_SIZE && get_task_struct(pid) != NULL;
+}
+
+int cgroup_create(int parent, tFrameId limit, tFrameId reservation)
+{
+    tCgroup *up = find_group(parent);
+    if (up == NULL)
+        return -2;
+
+    int id = 1;
+    while (id < CGROUP_MAX && g_used[id])
+        id++;
+    if (id == CGROUP_MAX)
+        return -1;
+
+    if ((limit != 0 && reservation > limit) || check_commit(up, reservation) != NULL)
+        return -3;
+
+    commit(up, reservation, 0);
+    up->children++;
+    g_groups[id] = (tCgroup){.parent = parent, .depth = up->depth + 1, .limit = limit, .reservation = reservation};
+    g_used[id] = 0x1;
+    return id;
+}
+
+int cgroup_destroy(int group)
+{
+    tCgroup *cg = find_group(group);
+    if (cg == NULL || group == CGROUP_ROOT)
+        return -1;
+
+    if (cg->tasks != 0 || cg->children != 0)
+        return -2;
+
+    tCgroup *up = find_group(cg->parent);
+    uncommit(up, cg->reservation, 0);
+    up->children--;
+    g_used[group] = 0x0;
+    g_groups[group] = (tCgroup){.parent = -1};
+    return 0;
+}
+
+int cgroup_set_limit(int group, tFrameId limit)
+{
+    tCgroup *cg = find_group(group);
+    if (cg == NULL)
+        return -1;
+
+    if (limit != 0 && (cg->committed > limit || cg->reservation > limit))
+        return -2;
+
+    cg->limit = limit;
+    return 0;
+}
+
+int cgroup_attach(int pid, int group)
+{
+    tCgroup *to = find_group(group);
+    if (to == NULL || !valid_task(pid))
+        return -1;
+
+    tCgroup *from = &g_groups[g_task_group[pid]];
+    if (to == from)
+        return 0;
+
+    const tFrameId frames = g_task_frames[pid];
+    uncommit(from, frames, frames);
+    if (check_commit(to, frames) != NULL)
+    {
+        commit(from, frames, frames);
+        return -2;
+    }
+
+    commit(to, frames, frames);
+    if (from != &g_groups[CGROUP_ROOT])
+        from->tasks--;
+    if (to != &g_groups[CGROUP_ROOT])
+        to->tasks++;
+    g_task_group[pid] = group;
+    return 0;
+}
+
+int cgroup_of(int pid)
+{
+    return valid_task(pid) ? g_task_group[pid] : -1;
+}
+
+const tCgroup *cgroup_get(int group)
+{
+    return find_group(group);
+}
+
+tFrameId cgroup_usage(int group)
+{
+    const tCgroup *cg = find_group(group);
+    return (cg != NULL) ? cg->usage : 0;
+}
+
+tFrameId cgroup_task_usage(int pid)
+{
+    return valid_task(pid) ? g_task_frames[pid] : 0;
+}
+
+tFrameId cgroup_headroom(int pid)
+{
+    if (!valid_task(pid))
+        return 0;
+
+    const tRam *ram = get_ram_state();
+    tFrameId headroom = (ram != NULL) ? ram->size / ram->page_size : 0;
+    // Frames the reservations below the current group absorb before a charge reaches it.
+    tFrameId absorbed = 0;
+    for (const tCgroup *cg = &g_groups[g_task_group[pid]]; cg != NULL; cg = find_group(cg->parent))
+    {
+        if (cg->limit != 0)
+        {
+            const tFrameId room = cg->limit - cg->committed + absorbed;
+            if (room < headroom)
+                headroom = room;
+        }
+        if (cg->reservation > cg->committed)
+            absorbed += cg->reservation - cg->committed;
+    }
+    return headroom;
+}
+
+int cgroup_charge(int pid, tFrameId frames)
+{
+    if (!valid_task(pid))
+        return -1;
+
+    tCgroup *cg = &g_groups[g_task_group[pid]];
+    tCgroup *full = check_commit(cg, frames);
+    if (full != NULL)
+    {
+        full->limit_hits++;
+        return -2;
+    }
+
+    commit(cg, frames, frames);
+    g_task_frames[pid] += frames;
+    return 0;
+}
+
+void cgroup_uncharge(int pid, tFrameId frames)
+{
+    if (pid < 0 || pid >= TASK_TABLE_SIZE)
+        return;
+
+    // Never below zero, even if a caller frees more frames than were charged.
+    if (frames > g_task_frames[pid])
+        frames = g_task_frames[pid];
+
+    uncommit(&g_groups[g_task_group[pid]], frames, frames);
+    g_task_frames[pid] -= frames;
+}
+
+void cgroup_exit(int pid)
+{
+    if (pid < 0 || pid >= TASK_TABLE_SIZE)
+        return;
+
+    cgroup_uncharge(pid, g_task_frames[pid]);
+    if (g_task_group[pid] != CGROUP_ROOT)
+        g_groups[g_task_group[pid]].tasks--;
+    g_task_group[pid] = CGROUP_ROOT;
+}
+
+void cgroup_reset()
+{
+    memset(g_used, 0, sizeof(g_used));
+    memset(g_task_group, CGROUP_ROOT, sizeof(g_task_group));
+    memset(g_task_frames, 0, sizeof(g_task_frames));
+    for (uint8_t id = 0; id < CGROUP_MAX; id++)
+    {
+        g_groups[id] = (tCgroup){.parent = -1};
+    }
+    g_used[CGROUP_ROOT] = 0x1;
+}
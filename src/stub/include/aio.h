@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "backing.h"
+
+#define AIO_QUEUE_DEPTH 16  // Maximum number of reads in flight.
+#define AIO_WORKERS 4       // Host threads of the thread pool backend.
+
+#define AIO_AUTO 0     // io_uring when the kernel supports it, the thread pool otherwise.
+#define AIO_URING 1    // io_uring. Stores without a file descriptor are read at submission.
+#define AIO_THREADS 2  // Pool of AIO_WORKERS host threads calling read_page().
+
+// Asynchronous read of one page from a backing store into a frame.
+typedef struct tAioRead
+{
+    const tBackingOps *backing;  // Operations of the store.
+    void *store;                 // Store handle.
+    uint16_t page_id;            // Page to read.
+    uint16_t page_size;          // Size of the page.
+    uint8_t *frame;              // Destination in RAM.
+    uint32_t tag;                // Returned with the completion, below AIO_QUEUE_DEPTH.
+} tAioRead;
+
+// Receives a completion collected by aio_destroy(), see aio_set_drain().
+typedef void (*tAioDrain)(uint32_t tag, int result);
+
+// Starts the asynchronous read engine.
+//   backend - One of AIO_*.
+//   Returns:  n  - Backend in use, AIO_URING or AIO_THREADS.
+//            -1  - Requested backend not available or already started.
+int aio_init(uint8_t backend);
+
+// Stops the engine. Waits for the reads in flight and hands their completions to the drain function,
+// see aio_set_drain(). Without one they are dropped.
+void aio_destroy();
+
+// Sets the function aio_destroy() hands the completions of the reads in flight to, so that their owner can
+// release what the reads held. The setting survives aio_destroy() and aio_init().
+//   drain - Called once per completion with the tag and result as returned by aio_reap(). If NULL, dropped.
+void aio_set_drain(tAioDrain drain);
+
+// Queues a read. The caller keeps at most AIO_QUEUE_DEPTH reads in flight.
+//   Returns:  0  - Success.
+//            -1  - Engine not started or submission failed. The read was not taken and never touches the frame.
+int aio_submit(const tAioRead *read);
+
+// Returns nonzero when aio_submit() takes a read now: the engine is started and fewer than AIO_QUEUE_DEPTH
+// reads are in flight.
+int aio_ready();
+
+// Collects finished reads.
+//   tags    - Filled with tags of the finished reads.
+//   results - Filled with 0 for a successful read or -1.
+//   max     - Capacity of tags and results.
+//   wait    - If nonzero, blocks until at least one read finishes.
+//   Returns:  n  - Number of collected reads.
+//            -1  - Engine not started.
+int aio_reap(uint32_t *tags, int *results, int max, uint8_t wait);
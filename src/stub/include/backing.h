@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+// Backing store of a task's virtual address space. The pager loads pages from it and writes modified pages back.
+// Every operation gets the store handle given to create_task_backed().
+typedef struct tBackingOps
+{
+    // Copies page page_id of the store into frame.
+    //   Returns:  0  - Success.
+    //            -1  - Page outside of the store or I/O error.
+    int (*read_page)(void *store, uint16_t page_id, uint8_t *frame, uint16_t page_size);
+
+    // Copies frame into page page_id of the store.
+    //   Returns:  0  - Success.
+    //            -1  - Page outside of the store or I/O error.
+    int (*write_page)(void *store, uint16_t page_id, const uint8_t *frame, uint16_t page_size);
+
+    // Optional. Locates page page_id in a file, so it can be read without calling read_page (see aio.h).
+    //   Returns:  0  - Success, fd and offset are filled in.
+    //            -1  - Page outside of the store.
+    int (*page_location)(void *store, uint16_t page_id, uint16_t page_size, int *fd, uint64_t *offset);
+} tBackingOps;
+
+// Store handle is a pointer to caller memory holding the whole address space, used by create_task().
+extern const tBackingOps memory_backing_ops;
+
+// Store handle is a pointer to an open tFileBacking.
+extern const tBackingOps file_backing_ops;
+
+// Store handle is ignored and every operation fails. Tasks of an attached RAM image use it
+// until they are bound to their store again (see ram_image_attach() and task_set_backing()).
+extern const tBackingOps unbound_backing_ops;
+
+// Address space kept in a file mapped to the host memory. Content survives the process.
+typedef struct tFileBacking
+{
+    int fd;        // Descriptor of the opened file.
+    uint8_t *map;  // Shared mapping of the file.
+    uint32_t size; // Size of the mapping.
+} tFileBacking;
+
+// Opens or creates the file and maps it. A shorter file is extended with zeros to size bytes.
+//   file - Structure to fill in.
+//   path - Path of the file.
+//   size - Size of the address space in bytes.
+//   Returns:  0  - Success.
+//            -1  - Invalid parameters.
+//            -2  - File cannot be opened, extended or mapped.
+int file_backing_open(tFileBacking *file, const char *path, uint32_t size);
+
+// Flushes written pages to the file.
+//   Returns:  0  - Success.
+//            -1  - Not opened or I/O error.
+int file_backing_sync(tFileBacking *file);
+
+// Unmaps and closes the file.
+void file_backing_close(tFileBacking *file);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+// Bitmap utilities. Bit n of a bitmap is bit n % 8 of byte n / 8.
+// The operations work on 64-bit words where possible and never touch bytes past the last
+// byte holding one of the bits given by the caller.
+
+// Returns nonzero when the bit is set.
+static inline int bitmap_test(const uint8_t *bitmap, uint32_t bit)
+{
+    return (bitmap[bit / 8] >> (bit % 8)) & 0x1;
+}
+
+// Sets count bits starting at bit first.
+void bitmap_set_range(uint8_t *bitmap, uint32_t first, uint32_t count);
+
+// Clears count bits starting at bit first.
+void bitmap_clear_range(uint8_t *bitmap, uint32_t first, uint32_t count);
+
+// Counts the set bits among the first bits bits.
+uint32_t bitmap_count(const uint8_t *bitmap, uint32_t bits);
+
+// Finds the first run of length clear bits that starts at or after bit start, among the first bits bits.
+// Returns:
+//    n  - First bit of the run.
+//   -1  - No such run.
+int32_t bitmap_find_clear_run(const uint8_t *bitmap, uint32_t bits, uint32_t start, uint32_t length);
+
+// Finds the next run of clear bits that starts at or after bit start, among the first bits bits.
+// Returns:
+//    n  - First bit of the run, length receives the number of clear bits in the run.
+//   -1  - No clear bit left.
+int32_t bitmap_next_clear_run(const uint8_t *bitmap, uint32_t bits, uint32_t start, uint32_t *length);
+
+// Returns the length of the longest run of clear bits among the first bits bits.
+uint32_t bitmap_largest_clear_run(const uint8_t *bitmap, uint32_t bits);
+
+// Two-level bitmap: bit w of the summary is set when the 64-bit word w of the bitmap has all bits set.
+// Searches skip such words without reading them, so their cost depends on the free space, not the size.
+// A zeroed summary is valid for a zeroed bitmap.
+
+// Number of bytes of the summary of a bitmap of bits bits.
+#define BITMAP_SUMMARY_BYTES(bits) (((bits) + 64 * 8 - 1) / (64 * 8))
+
+// Updates the summary bits of the words holding bits first .. first + count - 1, after they were changed.
+void bitmap_summary_update(const uint8_t *bitmap, uint8_t *summary, uint32_t bits, uint32_t first, uint32_t count);
+
+// Same as bitmap_find_clear_run(), skipping full words with the summary. The summary may be nullptr.
+int32_t bitmap_summary_find_clear_run(const uint8_t *bitmap, const uint8_t *summary, uint32_t bits, uint32_t start,
+    uint32_t length);
+
+// Same as bitmap_next_clear_run(), skipping full words with the summary. The summary may be nullptr.
+int32_t bitmap_summary_next_clear_run(const uint8_t *bitmap, const uint8_t *summary, uint32_t bits, uint32_t start,
+    uint32_t *length);
+
+// Atomic variants for a bitmap shared by threads without a lock. Every byte is updated with a C11
+// compare-and-swap or fetch-and, so concurrent calls never lose an update of another bit of the byte.
+// Plain functions may read the bitmap meanwhile, their result is a hint only.
+
+// Sets the first clear bit at or after bit start, among the first bits bits.
+// Returns:
+//    n  - The bit that was set.
+//   -1  - No clear bit left.
+int32_t bitmap_atomic_claim(uint8_t *bitmap, uint32_t bits, uint32_t start);
+
+// Sets count bits starting at bit first if all of them are clear, otherwise leaves the bitmap as it was.
+// Returns:
+//    0  - Success.
+//   -1  - A bit is set already.
+int bitmap_atomic_set_range(uint8_t *bitmap, uint32_t first, uint32_t count);
+
+// Clears count bits starting at bit first.
+void bitmap_atomic_clear_range(uint8_t *bitmap, uint32_t first, uint32_t count);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+#define CGROUP_MAX 8   // Number of task groups including the root group.
+#define CGROUP_ROOT 0  // Group of all tasks not attached to another group, it always exists.
+
+// Task groups account the frames held by their tasks and limit them hierarchically.
+// Every task belongs to one group, a new task to CGROUP_ROOT. Groups form a tree below the root group.
+// The frames a task holds are charged to its group and all of the group's ancestors:
+//   - usage counts the frames held by the tasks of the group and of all groups below it.
+//   - committed counts the frames held by the tasks of the group itself, plus for every child group
+//     the bigger of its committed frames and its reservation. A reservation is thereby held for the
+//     child group in all ancestors even while the child group does not use it.
+//   - limit caps committed. A charge that would exceed the limit of the group or of any ancestor fails.
+// The counters are cached in the groups, reading them is O(1), charging is O(depth of the group).
+// page_fault() and friends charge the frames they take for a task, frames freed by the pager or by
+// destroy_task() are uncharged. A fault of a task at the limit of its group evicts a page of the task,
+// as when max_frames of the task is reached.
+// The groups live in host memory. init_taskMgr(), attach_taskMgr() and destroy_taskMgr() reset them;
+// attach_taskMgr() then charges the frames every task of the attached task manager holds to the root group.
+typedef struct tCgroup
+{
+    int8_t parent;         // Parent group, -1 for the root group and for unused groups.
+    uint8_t depth;         // Number of ancestors.
+    uint8_t tasks;         // Tasks attached to the group, not counted for the root group.
+    uint8_t children;      // Groups whose parent is the group.
+    tFrameId limit;        // Maximum of committed frames. If 0, unlimited.
+    tFrameId reservation;  // Frames held for the group in the ancestors.
+    tFrameId usage;        // Frames held by the tasks of the group and of the groups below it.
+    tFrameId committed;    // Frames held by the tasks of the group plus what the child groups hold or reserve.
+    uint32_t limit_hits;   // Charges refused because of the limit of the group.
+} tCgroup;
+
+// Creates a task group.
+//   parent       - Parent group.
+//   limit        - Maximum of frames committed in the group. If 0, unlimited.
+//   reservation  - Frames held for the group in the ancestors, has to fit into their limits.
+// Returns:
+//   >=0  - Identifier of the new group.
+//    -1  - No unused group left.
+//    -2  - Parent group not found.
+//    -3  - Reservation exceeds the limit, or the headroom of an ancestor.
+int cgroup_create(int parent, tFrameId limit, tFrameId reservation);
+
+// Destroys a task group. The root group cannot be destroyed.
+// Returns:
+//    0  - Success.
+//   -1  - Group not found.
+//   -2  - Tasks or groups are still attached to the group.
+int cgroup_destroy(int group);
+
+// Changes the limit of a group, the root group included.
+//   limit  - Maximum of committed frames. If 0, unlimited.
+// Returns:
+//    0  - Success.
+//   -1  - Group not found.
+//   -2  - More frames are committed in the group, or the reservation of the group is bigger.
+int cgroup_set_limit(int group, tFrameId limit);
+
+// Moves a task into a group together with the frames charged to it.
+// Returns:
+//    0  - Success.
+//   -1  - Task or group not found.
+//   -2  - The frames of the task do not fit into the new group, the task stays in its group.
+int cgroup_attach(int pid, int group);
+
+// Returns the group of a task, or -1 when the task is not found.
+int cgroup_of(int pid);
+
+// Returns the state of a group, or NULL when the group is not found.
+const tCgroup *cgroup_get(int group);
+
+// Returns the frames held by the tasks of a group and the groups below it, or 0 when the group is not found.
+tFrameId cgroup_usage(int group);
+
+// Returns the frames charged to a task.
+tFrameId cgroup_task_usage(int pid);
+
+// Returns how many frames may still be charged to a task before a limit of its groups is reached.
+// Without any limit on the way to the root group, returns the number of frames of the RAM.
+tFrameId cgroup_headroom(int pid);
+
+// Charges frames to a task, its group and all ancestors of the group.
+// Returns:
+//    0  - Success.
+//   -1  - Task not found.
+//   -2  - A limit would be exceeded, nothing is charged. limit_hits of the refusing group is counted.
+int cgroup_charge(int pid, tFrameId frames);
+
+// Uncharges frames from a task, at most the frames charged to it.
+void cgroup_uncharge(int pid, tFrameId frames);
+
+// Uncharges all frames of a task and returns it to the root group. Called by destroy_task().
+void cgroup_exit(int pid);
+
+// Destroys all groups, detaches all tasks and clears the root group. The limit of the root group is removed.
+void cgroup_reset();
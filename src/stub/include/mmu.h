@@ -5,9 +5,30 @@
 #include "types.h"
 
 // Sets a new active page table for the MMU (Memory Management Unit).
+// When the page table belongs to a task, load_data() and store_data() count the accesses to its pages
+// on other nodes than the home node of the task, see get_task_remote_hits() and pager_migrate().
 //   page_table - Pointer to the physical address of the page table.
 void set_page_table(tPageTableEntry *page_table);
 
+// Sets the node of RAM the CPU executing the active page table belongs to, 0 by default (see ram_set_nodes()).
+// load_data() and store_data() count accesses to frames of other nodes as remote.
+//   node - Node of the CPU, usually the home node of the task (see set_home_node()).
+void set_mmu_node(uint8_t node);
+
+// Counters of load_data() and store_data(), accumulated since the start or the last mmu_reset_stats().
+typedef struct tMmuStats
+{
+    uint32_t local_accesses;   // Accesses to frames of the node set by set_mmu_node().
+    uint32_t remote_accesses;  // Accesses to frames of other nodes.
+    uint64_t access_cost;      // Local accesses plus the weights of the nodes of the remote accesses.
+} tMmuStats;
+
+// Returns the access counters.
+const tMmuStats *mmu_get_stats();
+
+// Resets the access counters to zero.
+void mmu_reset_stats();
+
 // Calculates the physical address corresponding to a virtual address.
 //   Returns:  0  - Success; fills physical_address with the address relative to the start of RAM.
 //            -1  - Page fault.
@@ -15,7 +36,7 @@ void set_page_table(tPageTableEntry *page_table);
 //            -3  - physical_address is nullptr.
 //            -4  - No page table present.
 //            -5  - RAM not initialized.
-int get_physical_address(uint16_t virtual_address, uint16_t *physical_address);
+int get_physical_address(tVirtAddr virtual_address, tRamSize *physical_address);
 
 // Instruction execution and Data processing API functions of the MMU.
 //   virtual_address - Address of the data in the virtual address space.
@@ -28,8 +49,8 @@ int get_physical_address(uint16_t virtual_address, uint16_t *physical_address);
 //            -4  - No page table present.
 
 // Loads RAM content at the calculated physical address into data.
-int fetch_instruction(uint16_t virtual_address, uint8_t *data);
-int load_data(uint16_t virtual_address, uint8_t *data);
+int fetch_instruction(tVirtAddr virtual_address, uint8_t *data);
+int load_data(tVirtAddr virtual_address, uint8_t *data);
 
 // Stores data to RAM at the calculated physical address.
-int store_data(uint16_t virtual_address, uint8_t data);
+int store_data(tVirtAddr virtual_address, uint8_t data);
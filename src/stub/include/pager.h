@@ -2,15 +2,56 @@
 
 #include <stdint.h>
 
+#include "types.h"
+
+#define PAGER_POLICY_NRU 0    // Not Recently Used, default.
+#define PAGER_POLICY_AGING 1  // Aging, approximation of Least Recently Used.
+
+#define PAGER_FLUSH_BATCH 4   // Maximum number of modified pages written back by one pager_tick().
+
+#define PAGER_MAX_LARGE_ORDER 3  // Largest order of a large page, limited by tPageTableEntry::order.
+
+#define PAGER_MIGRATE_THRESHOLD 4  // Remote accesses that make a page a candidate for pager_migrate().
+
+#define PAGER_LOCK_LIMIT 4  // Pages a new task may lock with lock_pages(), see set_lock_limit().
+
 // The paging algorithm works with the m_bit and r_bit fields of the page table entry.
 // The algorithm has the following properties:
-//   - Behavior as described for the NRU (Not Recently Used) algorithm (4 classes).
+//   - Behavior as described for the NRU (Not Recently Used) algorithm (4 classes),
+//     or for the aging algorithm when selected by set_replacement_policy().
 //   - Local scope, i.e., it may select as a victim only frames owned by the task.
 //   - Respects the task's max_frames setting if configured.
+//   - Respects the frame limits of the task's group, see cgroup.h.
+//   - Never selects pages locked by lock_pages() as victims.
+//   - Pages are loaded from and written back to the task's address space through its backing store (backing.h).
 //   - During page_fault execution, all modified pages of the task are first written to the task's address space.
+//   - During page_fault execution, the r_bit of all the task's pages is shifted into their aging counters.
 //   - During page_fault execution, the r_bit and m_bit of all the task's pages are cleared.
+// In clock mode (see pager_set_clock()) the last three steps are done by pager_tick() instead, and page_fault
+// only selects a victim, writes it back if it is modified, and loads the page.
+
+// Counters of the pager, accumulated since the start or the last pager_reset_stats().
+typedef struct tPagerStats
+{
+    uint32_t faults;             // Pages loaded by page_fault() and page_fault_batch().
+    uint32_t clean_victims;      // Evictions of pages that did not need a write-back.
+    uint32_t dirty_victims;      // Evictions of modified pages, written back on the fault path.
+    uint32_t flushed_pages;      // Modified pages written back ahead of time by pager_tick().
+    uint32_t reclaim_scans;      // Victim searches across all tasks done by pager_reclaim().
+    uint32_t reclaimed_pages;    // Pages evicted by pager_reclaim().
+    uint32_t compacted_pages;    // Pages moved to a lower frame by pager_compact().
+    uint32_t large_pages;        // Large pages mapped by page_fault().
+    uint32_t large_fallbacks;    // Faults that mapped a base page because no run of free frames was large enough.
+    uint32_t remote_frames;      // Frames faults took outside of the home node of the task, see set_home_node().
+    uint32_t migrated_pages;     // Pages moved to the home node of their task by pager_migrate().
+    uint64_t migrated_bytes;     // Bytes copied by pager_migrate().
+    uint32_t direct_reclaims;    // Faults that found no free frame and had to evict a page themselves.
+    uint64_t direct_reclaim_ns;  // Total duration of the faults counted in direct_reclaims.
+} tPagerStats;
 
 // Loads the page content from the task's address space into RAM.
+// When the task uses large pages (see set_large_pages()), the whole large page around the address is loaded
+// into consecutive frames by this one fault.
 //   pid              - Task identifier.
 //   virtual_address  - Address of data with missing frame in the RAM.
 //   Returns:  0  - Success
@@ -18,4 +59,197 @@
 //            -2  - Page already in RAM
 //            -3  - Out of resources
 //            -4  - Segmentation fault
-int page_fault(int pid, uint16_t virtual_address);
+//            -5  - Backing store failed to read the page or to write back the victim
+//            -6  - Page is in transit
+int page_fault(int pid, tVirtAddr virtual_address);
+
+// Loads the pages of several addresses of one task at once.
+// Works like number calls of page_fault(), but the victims for all pages are selected in one pass,
+// free frames are reserved in one pass over the bitmap (see falloc_scattered()), and the reference
+// bits are written back and cleared only once. Addresses of pages that are present or in transit,
+// and repeated addresses, are skipped. Pages are loaded in page order.
+// When the task cannot get a frame for every page, only the first pages are loaded.
+// A batch that had to evict for lack of free frames counts as one direct reclaim.
+//   pid                - Task identifier.
+//   virtual_addresses  - Addresses of data with missing frames in the RAM.
+//   number             - Number of addresses.
+//   Returns:  n  - Number of loaded pages.
+//            -1  - Task not found
+//            -3  - Out of resources, no page was loaded
+//            -4  - Segmentation fault on any of the addresses, no page was loaded
+//            -5  - Backing store failed, no page was loaded
+int page_fault_batch(int pid, const tVirtAddr *virtual_addresses, uint8_t number);
+
+// Asynchronous variant of page_fault(). The asynchronous read engine has to be started with aio_init().
+// Finds a frame for the page the same way as page_fault(), sets t_bit of the page and queues the read.
+// The page becomes present (p_bit set, t_bit cleared) in pager_complete() once the read finishes.
+// Up to AIO_QUEUE_DEPTH faults of any tasks can be in transit at the same time.
+// Faults still in transit when aio_destroy() stops the engine are completed by it like by pager_complete().
+//   Returns:  0  - Read queued
+//            -1 .. -6 - As page_fault()
+//            -7  - Engine not started or no free queue slot. Nothing is evicted and the page stays absent.
+int page_fault_async(int pid, tVirtAddr virtual_address);
+
+// Completes the asynchronous page faults whose reads finished.
+// A page whose read failed loses its frame and is not present, t_bit is cleared in both cases.
+//   wait     - If nonzero and a fault is in transit, blocks until at least one read finishes.
+//   Returns:  n  - Number of completed faults.
+//            -1  - Engine not started.
+int pager_complete(uint8_t wait);
+
+// Selects the page replacement policy of a task.
+// The aging policy keeps an 8-bit counter per page. On every fault (and clock tick) the counters
+// are shifted right and r_bit is put into the MSB. The page with the lowest counter is evicted.
+//   pid     - Task identifier.
+//   policy  - One of PAGER_POLICY_*.
+//   Returns:  0  - Success
+//            -1  - Task not found
+//            -2  - Unknown policy
+int set_replacement_policy(int pid, uint8_t policy);
+
+// Makes page_fault() map large pages for the task. A large page is a naturally aligned group of 2^order pages
+// mapped to 2^order consecutive frames with one falloc() call. All its pages get order set in their page table
+// entries and keep their own frame_id, so the MMU translates them with the same single lookup as base pages.
+// A fault falls back to a base page when:
+//   - Any page of the group is inaccessible, present or in transit.
+//   - The group does not fit below max_frames, or no run of free frames is large enough.
+// Evicting a page splits its large page into base pages, pager_compact() does not move pages of large pages.
+//   pid    - Task identifier.
+//   order  - Pages per large page as a power of two, up to PAGER_MAX_LARGE_ORDER. If 0, only base pages (default).
+//   Returns:  0  - Success
+//            -1  - Task not found
+//            -2  - Order too large for the page table or for PAGER_MAX_LARGE_ORDER
+int set_large_pages(int pid, uint8_t order);
+
+// Sets the node of RAM the task runs on (see ram_set_nodes()). page_fault() and page_fault_batch() take frames
+// from the home node first and from the following nodes, wrapping around, only when it has no free frame.
+// pager_compact() moves pages only within their node.
+//   pid   - Task identifier.
+//   node  - Home node of the task, 0 by default.
+//   Returns:  0  - Success
+//            -1  - Task not found
+//            -2  - No such node
+int set_home_node(int pid, uint8_t node);
+
+// Locks the pages of an address range in RAM, so that accesses to them never fault.
+// Pages that are not present are loaded first, like by page_fault(). A locked page gets l_bit set and keeps its
+// frame until it is unlocked or the task is destroyed: it is never selected as a victim, neither by page faults
+// of the task nor by pager_reclaim(), and pager_compact() and pager_migrate() do not move it.
+// The task may lock up to lock_limit pages (see set_lock_limit()). With max_frames set, at least one frame
+// is left unlocked for the faults of the other pages.
+//   pid              - Task identifier.
+//   virtual_address  - Start of the range.
+//   length           - Length of the range in bytes. If 0, nothing is locked.
+//   Returns:  0  - Success
+//            -1  - Task not found
+//            -2  - The range has more unlocked pages than the task may still lock
+//            -3  - Out of resources, see page_fault()
+//            -4  - Segmentation fault, the range leaves the address space or has an inaccessible page
+//            -5  - Backing store failed to read a page or to write back a victim
+//            -6  - A page of the range is in transit
+// On errors -3 and -5 the pages locked by the call are unlocked again, the loaded pages stay present.
+int lock_pages(int pid, tVirtAddr virtual_address, tVirtAddr length);
+
+// Unlocks the pages of an address range locked by lock_pages(). Pages that are not locked are skipped.
+//   Returns:  0  - Success
+//            -1  - Task not found
+//            -4  - Segmentation fault, the range leaves the address space
+int unlock_pages(int pid, tVirtAddr virtual_address, tVirtAddr length);
+
+// Sets how many pages of the task lock_pages() may lock, PAGER_LOCK_LIMIT by default.
+//   pid    - Task identifier.
+//   pages  - Maximum number of locked pages, up to PAGE_TABLE_SIZE.
+//   Returns:  0  - Success
+//            -1  - Task not found
+//            -2  - More than PAGE_TABLE_SIZE pages, or fewer than the task has locked
+int set_lock_limit(int pid, uint8_t pages);
+
+// Counts the locked pages of a task.
+//   Returns:  n  - Number of pages.
+//            -1  - Task not found
+int pager_locked_pages(int pid);
+
+// Counts the present pages of a task that are mapped by large pages.
+//   Returns:  n  - Number of pages.
+//            -1  - Task not found
+int pager_large_coverage(int pid);
+
+// Enables or disables the clock mode, disabled by default.
+// In clock mode the reference information survives page faults until the next pager_tick().
+//   enabled - Nonzero enables the clock mode.
+void pager_set_clock(uint8_t enabled);
+
+// Clock tick, meant to be called periodically like a timer interrupt.
+// This function:
+//   - Shifts r_bit of all present pages of all tasks into their aging counters.
+//   - Samples and clears r_bit of all present pages, see wss_tick().
+//   - Writes back up to PAGER_FLUSH_BATCH modified pages and clears their m_bit,
+//     continuing with the next batch where the previous tick stopped.
+//     Only while free frames are below the flush watermark, if one is set.
+//   - Runs pager_reclaim() when fewer than wmark_low frames are free (see ram_set_watermarks()).
+//   - Migrates up to the migration budget of pages, see pager_set_migration().
+//   - Moves up to the compaction budget of pages, see pager_set_compaction().
+// Returns:
+//    0  - Success.
+//   -1  - RAM or task manager not initialized.
+int pager_tick();
+
+// Evicts the coldest pages across all tasks until at least wmark_high frames are free
+// (see ram_set_watermarks()), so that page faults find a free frame without evicting.
+// Pages referenced since the last aging are evicted last, otherwise the lowest aging counter goes first
+// and clean pages before modified ones. Modified pages are written back, locked pages are skipped.
+// Frames cached per thread (see ram_set_magazines()) are returned to the bitmap first.
+// Can be run by a host thread when the caller serializes it with page_fault() and the MMU accesses.
+// Returns:
+//    n  - Number of evicted pages.
+//   -1  - RAM or task manager not initialized.
+int pager_reclaim();
+
+// Compacts RAM incrementally: moves pages present in RAM from the highest occupied frames into the
+// lowest free frames, so that free frames coalesce into long runs at the end of RAM and multi-frame
+// falloc() requests keep succeeding.
+// A page is moved by copying its frame and updating frame_id in its page table entry. The MMU reads
+// frame_id on every access, so active page tables stay valid. Frames that are not owned by a present
+// page (tRam, the task manager, other falloc() users), pages in transit, locked pages and large pages are never
+// moved.
+// With several nodes (see ram_set_nodes()) every node is compacted on its own, node 0 first.
+//   budget - Maximum number of pages to move.
+// Returns:
+//    n  - Number of moved pages, less than budget when no free frame is left below an occupied one.
+//   -1  - RAM or task manager not initialized.
+int pager_compact(uint16_t budget);
+
+// Sets the number of pages pager_tick() moves with pager_compact(). If 0, ticks do not compact (default).
+void pager_set_compaction(uint16_t budget);
+
+// Moves pages that their task accesses from another node to the home node of the task (see set_home_node()).
+// The MMU counts the accesses to such pages (see set_page_table() and get_task_remote_hits()). Pages with at
+// least PAGER_MIGRATE_THRESHOLD of them are candidates, the most accessed page moves first. A page is moved
+// by copying its frame and updating frame_id in its page table entry, like pager_compact().
+// Pages in transit, locked pages and large pages are not moved, nor pages whose home node has no free frame.
+// Afterwards all counters are halved, so that the next call acts on recent accesses.
+//   budget - Maximum number of pages to move, the migration rate when called periodically.
+// Returns:
+//    n  - Number of moved pages.
+//   -1  - RAM or task manager not initialized.
+int pager_migrate(uint16_t budget);
+
+// Sets the number of pages pager_tick() moves with pager_migrate(). If 0, ticks do not migrate (default).
+void pager_set_migration(uint16_t budget);
+
+// Sets the free-frame watermark of the tick-driven write-back.
+// Modified pages are written back ahead of eviction only while fewer than frames frames are free,
+// so the victims of the following faults are likely to be clean.
+//   frames - Watermark in frames. If 0, every tick writes back (default).
+void pager_set_flush_watermark(tFrameId frames);
+
+// Returns the pager counters.
+const tPagerStats *pager_get_stats();
+
+// Resets the pager counters to zero.
+void pager_reset_stats();
+
+struct tTaskStruct;
+
+// Shifts r_bit of all present pages of the task into their aging counters. Does not clear r_bit.
+void pager_age(struct tTaskStruct *task);
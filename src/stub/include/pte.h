@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+// Flags of all entries of a page table, bit n of every mask stands for page_table[n].
+typedef struct tPteScan
+{
+    tPageMask accessible;  // rwx is not 000.
+    tPageMask present;     // p_bit set.
+    tPageMask referenced;  // r_bit set.
+    tPageMask modified;    // m_bit set.
+    tPageMask transit;     // t_bit set.
+    tPageMask locked;      // l_bit set.
+} tPteScan;
+
+// Collects the flags of the PAGE_TABLE_SIZE entries of a page table into masks.
+// The flag bits share the first two bytes of every entry, so the entries are scanned in chunks of 8
+// with vector shifts and sign-bit masks: one load per chunk on AVX2, two on SSE2. Entries left over
+// by the chunks, and all entries elsewhere and in the RAM_WIDE configuration, take a scalar loop.
+//   page_table - Page table to scan.
+//   scan       - Receives the masks.
+void pte_scan(const tPageTableEntry *page_table, tPteScan *scan);
+
+// Returns the present pages of NRU class cls (0 - not referenced and clean .. 3 - referenced and modified).
+static inline tPageMask pte_nru_class(const tPteScan *scan, uint8_t cls)
+{
+    const tPageMask referenced = (cls & 0x2) ? scan->referenced : (tPageMask)~scan->referenced;
+    const tPageMask modified = (cls & 0x1) ? scan->modified : (tPageMask)~scan->modified;
+    return scan->present & referenced & modified;
+}
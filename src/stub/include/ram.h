@@ -2,11 +2,29 @@
 
 #include <stdint.h>
 
+#include "types.h"
+
+#define RAM_ALLOC_FIRST_FIT 0  // Lowest run of free frames, default.
+#define RAM_ALLOC_NEXT_FIT 1   // First run at or after the end of the previous allocation, wrapping around.
+#define RAM_ALLOC_BEST_FIT 2   // Smallest run of free frames that is large enough.
+
+#define RAM_MAGAZINES 16        // Threads that can cache free frames at once, see ram_set_magazines().
+#define RAM_MAGAZINE_SIZE 16    // Frames one thread can cache.
+#define RAM_MAGAZINE_BATCH 8    // Frames moved between a cache and the bitmap at once.
+
+#define RAM_MAX_NODES 4         // Nodes RAM can be split into, see ram_set_nodes().
+
 typedef struct tRam
 {
-    uint16_t size;     // Configured size of RAM.
-    uint8_t page_size; // Configured size of page.
-    uint8_t *bitmap;   // Pointer to a RAM usage bitmap. Stored in RAM too.
+    tRamSize size;     // Configured size of RAM.
+    tPageSize page_size; // Configured size of page.
+    uint8_t alloc_policy; // Policy of falloc(), one of RAM_ALLOC_*.
+    tFrameId rover;    // Frame after the last falloc() allocation, where the next-fit search starts.
+    tFrameId wmark_low;  // Reclaim starts when fewer frames are free. If 0, no proactive reclaim.
+    tFrameId wmark_high; // Reclaim stops when this many frames are free.
+    tRamSize bitmap;   // Offset of the RAM usage bitmap from the start of RAM. Stored in RAM too.
+    tRamSize summary;  // Offset of the summary of the bitmap, one bit per fully used 64-frame word (see bitmap.h).
+                       // 0 if RAM has no more than 64 frames, such a bitmap needs no summary.
 } tRam;
 
 // Initializes the RAM model. The library can use only this memory for task data,
@@ -24,14 +42,37 @@ typedef struct tRam
 //   -2   - Page size is zero, not a power of two, or larger than memory size.
 //   -3   - Memory not zeroed or is nullptr.
 //   -4   - Not enough memory to store tRam structure and bitmap.
-int init_ram(void *memory, uint16_t size, uint8_t page_size);
+int init_ram(void *memory, tRamSize size, tPageSize page_size);
+
+// Same as init_ram(), but trusts the caller that memory is zeroed, f.ex. because it comes from a fresh
+// mmap() or calloc(), and does not read it. Initialization time then does not depend on the size of RAM.
+// Memory that is not zeroed leaves the RAM in an undefined state.
+//
+// Returns:
+//   As init_ram(), -3 only if memory is nullptr.
+int init_ram_trusted(void *memory, tRamSize size, tPageSize page_size);
+
+// Attaches the RAM model to memory that already holds an initialized RAM, f.ex. a copy of the
+// memory of another run (see ram_image_attach()). RAM holds offsets only, so the memory is used as is.
+//
+// Parameters:
+//   memory    - Pointer to the memory holding the RAM.
+//   size      - Total size of the memory.
+//   page_size - Size of one page (frame) in the memory.
+//
+// Returns:
+//    n   - Number of frames in the memory.
+//   -1   - memory is nullptr.
+//   -2   - The RAM stored in memory has a different size or page size, or its bitmap or summary
+//          does not fit into memory behind tRam.
+int attach_ram(void *memory, tRamSize size, tPageSize page_size);
 
 // Destroys the RAM model and releases all associated resources in RAM.
 void destroy_ram();
 
 // Reserves the specified number of consecutive frames in RAM.
 // This is a low-level utility that may be used by the system.
-// Uses the first-fit algorithm.
+// Uses the policy set by ram_set_alloc_policy(), the first-fit algorithm by default.
 //
 // Parameters:
 //   frame_id - Pointer to a variable that receives the ID of the first reserved frame.
@@ -41,7 +82,57 @@ void destroy_ram();
 //    0   - Success.
 //   -1   - Not enough space or RAM is not initialized.
 //   -2   - Invalid parameters.
-int falloc(uint16_t *frame_id, uint16_t number);
+int falloc(tFrameId *frame_id, tFrameId number);
+
+// Reserves the specified number of consecutive frames in one node of RAM, see ram_set_nodes().
+// Uses the policy set by ram_set_alloc_policy() within the node, next-fit continues where the previous
+// allocation in the same node ended. Frames cached by ram_set_magazines() and lock-free claims are not used.
+// Without nodes, same as falloc().
+//
+// Parameters:
+//   frame_id - Pointer to a variable that receives the ID of the first reserved frame.
+//   number   - Number of frames to reserve.
+//   node     - Node to take the frames from.
+//
+// Returns:
+//    0   - Success.
+//   -1   - Not enough space in the node or RAM is not initialized.
+//   -2   - Invalid parameters.
+int falloc_node(tFrameId *frame_id, tFrameId number, uint8_t node);
+
+// Reserves the specified consecutive frames in RAM if all of them are free.
+// This is a low-level utility that may be used by the system, f.ex. to move a page to a chosen frame.
+//
+// Parameters:
+//   frame_id - ID of the first frame to reserve.
+//   number   - Number of frames to reserve.
+//
+// Returns:
+//    0   - Success.
+//   -1   - A frame is reserved already or RAM is not initialized.
+//   -2   - Invalid parameters.
+int falloc_at(tFrameId frame_id, tFrameId number);
+
+// Reserves up to the specified number of frames in RAM, not necessarily consecutive,
+// in a single pass over the bitmap. Frames are taken in ascending order.
+//
+// Parameters:
+//   frame_ids - Array that receives the IDs of the reserved frames.
+//   number    - Number of frames wanted.
+//
+// Returns:
+//    n   - Number of reserved frames, less than number when RAM runs out of free frames.
+//   -1   - RAM is not initialized.
+//   -2   - Invalid parameters.
+int falloc_scattered(tFrameId *frame_ids, tFrameId number);
+
+// Same as falloc_scattered(), taking frames of one node only.
+//
+// Returns:
+//    n   - Number of reserved frames, less than number when the node runs out of free frames.
+//   -1   - RAM is not initialized.
+//   -2   - Invalid parameters.
+int falloc_scattered_node(tFrameId *frame_ids, tFrameId number, uint8_t node);
 
 // Frees a reserved number of consecutive frames in RAM.
 // This is a low-level utility that may be used by the system.
@@ -52,7 +143,144 @@ int falloc(uint16_t *frame_id, uint16_t number);
 // Parameters:
 //   frame_id - ID of the first frame to release.
 //   number   - Number of frames to free.
-void ffree(uint16_t frame_id, uint16_t number);
+void ffree(tFrameId frame_id, tFrameId number);
+
+// Counts the frames in RAM that are not reserved.
+// Frames cached by ram_set_magazines() count as reserved until ram_drain_magazines().
+//
+// Returns:
+//   Number of free frames.
+//   0 if RAM is not initialized.
+tFrameId ram_free_frames();
+
+// Finds the longest run of consecutive free frames, the largest number falloc() can reserve at once.
+//
+// Returns:
+//   Number of frames in the run.
+//   0 if RAM is not initialized.
+tFrameId ram_largest_free_run();
+
+// Selects the policy falloc() uses to find consecutive free frames.
+//
+// Parameters:
+//   policy - One of RAM_ALLOC_*.
+//
+// Returns:
+//    0   - Success.
+//   -1   - RAM is not initialized.
+//   -2   - Unknown policy.
+int ram_set_alloc_policy(uint8_t policy);
+
+// Measures the external fragmentation of the free frames: the share of free frames that lie
+// outside of the largest run of free frames.
+//
+// Returns:
+//   Fragmentation in percent, 0 when all free frames are consecutive or none is free.
+//   0 if RAM is not initialized.
+uint8_t ram_fragmentation();
+
+// Part of RAM close to a group of CPUs, modeled after the nodes of a NUMA machine.
+typedef struct tRamNode
+{
+    tFrameId first;   // First frame of the node.
+    tFrameId frames;  // Number of frames of the node.
+    tFrameId rover;   // Frame after the last falloc_node() allocation in the node.
+    uint8_t weight;   // Cost of an access to the node from another node, an access within a node costs 1.
+} tRamNode;
+
+// Splits RAM into nodes of equal size, node n holds the frames from n * frames / count on.
+// Every node keeps its own allocation rover; the frames of all nodes share the bitmap of RAM.
+// The frames reserved by init_ram() and init_taskMgr() stay in node 0.
+// init_ram() and attach_ram() make all RAM a single node.
+//
+// Parameters:
+//   count   - Number of nodes, a power of two up to RAM_MAX_NODES.
+//   weights - Access cost of every node from other nodes, at least 1. If nullptr, all are 1.
+//
+// Returns:
+//    0   - Success.
+//   -1   - RAM is not initialized.
+//   -2   - Invalid parameters.
+int ram_set_nodes(uint8_t count, const uint8_t *weights);
+
+// Returns the number of nodes, 0 if RAM is not initialized.
+uint8_t ram_node_count();
+
+// Returns the node, or nullptr if there is no such node.
+const tRamNode *ram_get_node(uint8_t node);
+
+// Returns the node holding the frame, or -1 if RAM is not initialized or the frame is outside of RAM.
+int ram_frame_node(tFrameId frame_id);
+
+// Counts the frames of the node that are not reserved, 0 if there is no such node.
+tFrameId ram_node_free_frames(uint8_t node);
+
+// Enables caches of free frames per thread in front of the bitmap. falloc() and ffree() of a
+// single frame use the cache of the calling thread and touch the bitmap, under a lock, only once
+// per RAM_MAGAZINE_BATCH frames. A refill takes the lowest free frames regardless of the policy.
+// falloc() of several frames drains all caches before it fails.
+// Caches are disabled by init_ram(), attach_ram() and destroy_ram().
+//
+// Parameters:
+//   enabled - 0 to disable and drain the caches, any other value to enable them.
+//
+// Returns:
+//    0   - Success.
+//   -1   - RAM is not initialized.
+int ram_set_magazines(uint8_t enabled);
+
+// Switches the bitmap to atomic updates instead of a lock. falloc() of a single frame then claims a frame
+// with a compare-and-swap, searching from the frame the calling thread got last, regardless of the policy.
+// ffree() clears the frames with an atomic and. Allocations of several frames and the other functions
+// still serialize on the lock, they confirm the frames they found with atomics.
+// The summary of the bitmap is zeroed while the mode is on and computed again when it is switched off.
+// Must not run concurrently with other calls. The mode is switched off by init_ram(), attach_ram() and destroy_ram().
+//
+// Parameters:
+//   enabled - 0 to take the lock for all updates, any other value for atomic updates.
+//
+// Returns:
+//    0   - Success.
+//   -1   - RAM is not initialized.
+int ram_set_lock_free(uint8_t enabled);
+
+// Returns the frames cached by all threads to the bitmap.
+void ram_drain_magazines();
+
+// Counts the free frames cached by all threads.
+//
+// Returns:
+//   Number of cached frames.
+tFrameId ram_cached_frames();
+
+// Counters of falloc(), accumulated since init_ram() or the last ram_reset_stats().
+typedef struct tRamStats
+{
+    uint32_t allocations;       // Successful falloc() calls served by the bitmap.
+    uint32_t failures;          // falloc() calls that found no run large enough.
+    uint32_t scanned_frames;    // Frames passed by the searches of falloc().
+    uint32_t magazine_hits;     // falloc() calls served by the cache of a thread.
+    uint32_t magazine_refills;  // Batches of frames moved from the bitmap to a cache.
+    uint32_t lock_free_allocations;  // falloc() calls served by an atomic claim, see ram_set_lock_free().
+} tRamStats;
+
+// Returns the falloc() counters.
+const tRamStats *ram_get_stats();
+
+// Resets the falloc() counters to zero.
+void ram_reset_stats();
+
+// Configures the free-frame watermarks used by the pager's proactive reclaim (see pager_reclaim()).
+//
+// Parameters:
+//   low  - Reclaim is started when fewer frames are free. 0 disables the proactive reclaim.
+//   high - Reclaim evicts pages until this many frames are free.
+//
+// Returns:
+//    0   - Success.
+//   -1   - RAM is not initialized.
+//   -2   - low is bigger than high or high is bigger than the number of frames.
+int ram_set_watermarks(tFrameId low, tFrameId high);
 
 // Returns a pointer to the tRam structure stored in RAM.
 //
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+#define RAM_IMAGE_VERSION 5
+#define RAM_IMAGE_HEADER_SIZE 64  // The RAM follows the header in the file, aligned for tRam and tTaskMgr.
+
+// Header of a RAM image file.
+typedef struct tRamImageHeader
+{
+    uint8_t magic[4];       // "OSPR".
+    uint8_t version;        // RAM_IMAGE_VERSION.
+    tPageSize page_size;    // Page size of the RAM.
+    tRamSize size;          // Size of the RAM.
+    tRamSize task_mgr;      // Offset of tTaskMgr in RAM, 0 if the task manager was not initialized.
+} tRamImageHeader;
+
+// RAM attached from an image file.
+typedef struct tRamImage
+{
+    uint8_t *map;     // Private mapping of the file.
+    uint32_t length;  // Length of the mapping.
+} tRamImage;
+
+// Writes the whole simulated RAM, including the task manager and all tasks, to a file.
+// RAM holds no host pointers, the image is valid at any address and in any process.
+// Backing stores of the tasks are not part of the image. Frames cached by ram_set_magazines() are returned
+// to the bitmap first, the caches stay enabled.
+//   path - Path of the file, it is replaced.
+//   Returns:  0  - Success.
+//            -1  - RAM not initialized or path is nullptr.
+//            -2  - File cannot be written.
+//            -3  - A page is in transit, complete the asynchronous faults first.
+int ram_image_save(const char *path);
+
+// Maps an image written by ram_image_save() and makes it the simulated RAM, replacing any current one.
+// The mapping is private: changes of the RAM are not written to the file, so one image can start many runs.
+// Tasks of the image have to be bound to their backing stores by task_set_backing() before their pages
+// can be loaded or written back; pages present in RAM can be accessed right away.
+//   image - Receives the mapping, release it with ram_image_detach().
+//   path  - Path of the file.
+//   Returns:  n  - Number of frames in RAM.
+//            -1  - Invalid parameters.
+//            -2  - File cannot be opened or mapped.
+//            -3  - File is not a RAM image of this version or is truncated.
+int ram_image_attach(tRamImage *image, const char *path);
+
+// Destroys the task manager and the RAM model of the image and unmaps the file.
+void ram_image_detach(tRamImage *image);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "backing.h"
+
+#define SNAPSHOT_VERSION 3
+
+// Flags of a page record in the snapshot image.
+#define SNAPSHOT_PAGE_R 0x1
+#define SNAPSHOT_PAGE_W 0x2
+#define SNAPSHOT_PAGE_X 0x4
+#define SNAPSHOT_PAGE_DATA 0x8  // The record is followed by the page content.
+#define SNAPSHOT_PAGE_LOCKED 0x10  // The page is locked by lock_pages().
+
+// Destination of a snapshot image. The image is written in several consecutive chunks.
+typedef struct tSnapshotWriter
+{
+    // Appends size bytes to the image.
+    //   Returns:  0  - Success.
+    //            -1  - Write error.
+    int (*write)(void *ctx, const void *data, uint16_t size);
+    void *ctx;  // Passed to write.
+} tSnapshotWriter;
+
+// Source of a snapshot image, read in the same chunks it was written in.
+typedef struct tSnapshotReader
+{
+    // Reads the next size bytes of the image into data.
+    //   Returns:  0  - Success.
+    //            -1  - Read error or end of the image.
+    int (*read)(void *ctx, void *data, uint16_t size);
+    void *ctx;  // Passed to read.
+} tSnapshotReader;
+
+// Writes a checkpoint of a task. The task is not changed.
+// The image holds single bytes only:
+//   - Header: "OSPS", SNAPSHOT_VERSION, log2 of the page size, max_frames, replacement policy, number of page records,
+//     lock_limit, large_order, home_node.
+//   - One record per page table entry: SNAPSHOT_PAGE_* flags. Modified pages present in RAM have
+//     SNAPSHOT_PAGE_DATA set and are followed by their content.
+// Content of the other pages is not stored, it is found in the task's backing store at the same page.
+//   pid    - Task identifier.
+//   writer - Destination of the image.
+//   Returns:  0  - Success.
+//            -1  - Task not found.
+//            -2  - Invalid parameters.
+//            -3  - Writer failed.
+int snapshot_task(int pid, const tSnapshotWriter *writer);
+
+// Creates a task from an image written by snapshot_task().
+// Pages are restored lazily: no page is present, the pages are loaded by page_fault() on first access.
+// Only the pages locked at the snapshot are loaded and locked again by lock_pages() before the call returns.
+// The content of the pages stored in the image is written to the backing store first, so store has to
+// hold the same address space content as the store of the task when the snapshot was taken.
+//   reader  - Source of the image.
+//   backing - Operations on the store of the new task.
+//   store   - Handle passed to the operations.
+//   Returns:  PID on success.
+//            -1  - Not enough resources to create a new task or to load its locked pages.
+//            -2  - Invalid parameters.
+//            -3  - The system was not initialized.
+//            -4  - Reader failed, or the image has an unknown version, a different page size or a home node
+//                  this RAM does not have.
+//            -5  - Backing store failed to write a page or to read a locked page, the task is not created.
+int restore_task(const tSnapshotReader *reader, const tBackingOps *backing, void *store);
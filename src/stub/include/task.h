@@ -2,18 +2,32 @@
 
 #include <stdint.h>
 
+#include "backing.h"
 #include "types.h"
+#include "wss.h"
 
 #define TASK_TABLE_SIZE 8
 
 typedef struct tTaskStruct
 {
     uint8_t max_frames;   // Limits the maximum number of task pages in RAM. If 0, there is no limit.
+    uint8_t lock_limit;   // Maximum number of pages lock_pages() may lock, see set_lock_limit().
     int pid;              // Process ID of the task.
-    void *address_space;  // Handle to the content of the task's virtual address space.
     tPageTableEntry page_table[PAGE_TABLE_SIZE];  // The task`s page table.
+    tWorkingSet ws;       // Working-set estimation of the task.
+    uint8_t policy;       // Page replacement policy of the task, see PAGER_POLICY_*.
+    uint8_t large_order;  // page_fault() maps large pages of 2^large_order pages. If 0, only base pages.
+    uint8_t home_node;    // Node of RAM page_fault() takes frames from first, see set_home_node().
+    uint8_t age[PAGE_TABLE_SIZE];  // Aging counters of the pages, the MSB is the most recent reference.
 } tTaskStruct;
 
+// Backing store of a task. Kept in host memory outside of RAM, one per task slot, so RAM holds no host pointers.
+typedef struct tTaskBacking
+{
+    const tBackingOps *ops;  // Operations the pager uses to access store.
+    void *store;             // Handle to the content of the task's virtual address space.
+} tTaskBacking;
+
 typedef struct tTaskMgr
 {
     tTaskStruct tasks[TASK_TABLE_SIZE];  // Storage for task data.
@@ -43,23 +57,75 @@ void destroy_taskMgr();
 //   -3  The system was not initialized.
 int create_task(const tPageTableEntry *page_table, uint8_t max_frames, void *address_space);
 
+// Creates a new task in memory whose address space is accessed through a backing store.
+// Same as create_task(), which uses memory_backing_ops with the address_space pointer as the store.
+//   backing - Operations on the store.
+//   store   - Handle passed to the operations.
+// Returns:
+//    PID on success.
+//   -1  Not enough resources to create a new task.
+//   -2  Invalid input parameters.
+//   -3  The system was not initialized.
+int create_task_backed(const tPageTableEntry *page_table, uint8_t max_frames, const tBackingOps *backing,
+    void *store);
+
+// Binds a task to another backing store, f.ex. after the RAM was attached from an image.
+// Pages present in RAM are kept, the store has to hold the same address space content.
+//   backing - Operations on the store.
+//   store   - Handle passed to the operations.
+// Returns:
+//    0  Success.
+//   -1  Task does not exist.
+//   -2  Invalid input parameters.
+int task_set_backing(int pid, const tBackingOps *backing, void *store);
+
 // Destroys a task in memory.
 // This function:
 //   - Cleans and marks the corresponding tTaskStruct entry in the task manager as free (sets PID to -1).
-//   - Releases all frames of the task from RAM.
+//   - Releases all frames of the task from RAM, including frames of pages in transit.
+//     Reads in transit should be completed by pager_complete() first, they still write into the released frames.
 // Returns:
 //    0  Success.
 //   -1  Task does not exist.
 int destroy_task(int pid);
 
+// Attaches the task manager of a RAM restored from an image (see ram_image_attach()).
+// Backing stores are not part of RAM, every task is bound to unbound_backing_ops until task_set_backing()
+// is called. Task groups are not part of RAM either, every task is in the root group with the frames it holds
+// charged (see cgroup.h).
+//   offset - Offset of tTaskMgr from the start of RAM. If 0, no task manager is attached.
+// Returns:
+//    0  - Success.
+//   -1  - RAM not initialized or offset outside of RAM.
+int attach_taskMgr(tRamSize offset);
+
 // Returns a pointer to the tTaskMgr structure in RAM.
 // Returns:
 //   Pointer to tTaskMgr.
 //   nullptr if the task manager is not initialized.
 const tTaskMgr *get_task_mgr();
 
+// Returns the backing store of a task.
+// Returns:
+//   Pointer to the backing store. Operations are unbound_backing_ops for a task without a store.
+//   nullptr if task is not a task of the task manager.
+const tTaskBacking *get_task_backing(const tTaskStruct *task);
+
+// Returns the counters of accesses to pages of a task on other nodes than its home node, one per page.
+// Kept in host memory like the backing store, counted by the MMU and consumed by pager_migrate().
+// Returns:
+//   Pointer to PAGE_TABLE_SIZE saturating counters, zeroed by create_task() and attach_taskMgr().
+//   nullptr if task is not a task of the task manager.
+uint8_t *get_task_remote_hits(const tTaskStruct *task);
+
 // Returns a pointer to the tTaskStruct for the given PID.
 // Returns:
 //   Pointer to the existing task.
 //   nullptr if the task was not found.
 tTaskStruct *get_task_struct(int pid);
+
+// Returns the task in a slot of the task manager without searching, for loops over all slots.
+// Returns:
+//   Pointer to the task.
+//   nullptr if the slot is free or not below TASK_TABLE_SIZE, or the task manager is not initialized.
+tTaskStruct *get_task_slot(uint8_t slot);
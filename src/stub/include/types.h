@@ -2,7 +2,26 @@
 
 #include <stdint.h>
 
+// Number of pages of a task, up to 64. Override f.ex. with CONFIG="-DPAGE_TABLE_SIZE=32" (see the Makefile).
+#ifndef PAGE_TABLE_SIZE
 #define PAGE_TABLE_SIZE 8
+#endif
+
+// Widths of the RAM model. The default configuration limits RAM to 32 KiB and pages to 128 bytes.
+// Building with RAM_WIDE (see the wide target of the Makefile) allows RAM up to 2 GiB and pages up to 32 KiB.
+#ifdef RAM_WIDE
+typedef uint32_t tRamSize;   // Size of RAM and offsets of data in RAM.
+typedef uint16_t tPageSize;  // Size of a page.
+typedef uint32_t tFrameId;   // Frame id, or a number of frames.
+typedef uint32_t tVirtAddr;  // Address in the virtual address space of a task.
+#define RAM_MAX_PAGE_SIZE 32768
+#else
+typedef uint16_t tRamSize;
+typedef uint8_t tPageSize;
+typedef uint16_t tFrameId;
+typedef uint16_t tVirtAddr;
+#define RAM_MAX_PAGE_SIZE 128
+#endif
 
 typedef struct tPageTableEntry
 {
@@ -14,5 +33,31 @@ typedef struct tPageTableEntry
     uint8_t p_bit : 1;  // Page is present in RAM.
     uint8_t r_bit : 1;  // Page has been referenced.
     uint8_t m_bit : 1;  // Page has been modified.
-    uint16_t frame_id;  // Assigned frame in RAM if p_bit is set.
+    uint8_t t_bit : 1;  // Page is in transit, being loaded into frame_id by page_fault_async().
+    uint8_t order : 2;  // Page is part of a large page of 2^order pages in consecutive frames, see set_large_pages().
+    uint8_t l_bit : 1;  // Page is locked in RAM and keeps its frame, see lock_pages().
+    tFrameId frame_id;  // Assigned frame in RAM if p_bit is set.
 } tPageTableEntry;
+
+// Set of pages of one page table, bit n stands for page_table[n]. As narrow as PAGE_TABLE_SIZE allows.
+#if PAGE_TABLE_SIZE <= 8
+typedef uint8_t tPageMask;
+#elif PAGE_TABLE_SIZE <= 16
+typedef uint16_t tPageMask;
+#elif PAGE_TABLE_SIZE <= 32
+typedef uint32_t tPageMask;
+#elif PAGE_TABLE_SIZE <= 64
+typedef uint64_t tPageMask;
+#else
+#error "PAGE_TABLE_SIZE is limited to 64 pages"
+#endif
+
+// Mask of page id.
+#define PAGE_MASK_BIT(id) ((tPageMask)1 << (id))
+
+// Mask of count pages from page first on, count from 1 to PAGE_TABLE_SIZE.
+#define PAGE_MASK_RANGE(first, count) ((tPageMask)(((tPageMask)~(tPageMask)0 >> (8 * sizeof(tPageMask) - (count))) << (first)))
+
+// Number of pages in a mask, and the lowest page of a non-empty mask.
+#define PAGE_MASK_COUNT(mask) ((uint8_t)__builtin_popcountll(mask))
+#define PAGE_MASK_FIRST(mask) ((uint8_t)__builtin_ctzll(mask))
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+#define WSS_WINDOW 8  // Number of ticks the working set is measured over.
+
+// Working-set tracking state kept per task.
+// Referenced pages are sampled from r_bit whenever it is cleared: by ticks and by page_fault().
+// A tick (wss_tick() or pager_tick()) closes the current sample, so the estimate covers the last WSS_WINDOW ticks.
+typedef struct tWorkingSet
+{
+    tPageMask history[WSS_WINDOW];  // Pages referenced during each of the last WSS_WINDOW ticks.
+    uint8_t head;                   // Slot of history collecting the current tick.
+    uint8_t estimate;               // Working-set size in pages, updated on every tick.
+    uint8_t faults;                 // Page faults since the last tick.
+    uint8_t pff_low;                // Below this many faults per tick max_frames shrinks towards the estimate.
+    uint8_t pff_high;               // Above this many faults per tick max_frames grows. If 0, tuning is disabled.
+} tWorkingSet;
+
+struct tTaskStruct;
+
+// Closes the current sampling interval of all tasks.
+// Same as pager_tick() without writing back modified pages.
+// This function:
+//   - Records and clears r_bit of all present pages, shifting it into their aging counters first.
+//   - Recomputes the working-set estimate of every task.
+//   - Adjusts max_frames of tasks with tuning enabled, see wss_set_tuning().
+// Returns:
+//    0  - Success.
+//   -1  - Task manager not initialized.
+int wss_tick();
+
+// Enables automatic max_frames tuning for a task.
+// On every tick the task's page-fault frequency (faults per tick) is compared with the bounds:
+//   - above pff_high max_frames grows by one frame, at least up to the estimate,
+//   - below pff_low max_frames shrinks by one frame, but not under the estimate nor the locked pages plus one.
+// A task with max_frames 0 (unlimited) is treated as limited to PAGE_TABLE_SIZE frames.
+//   pid      - Task identifier.
+//   pff_low  - Lower page-fault-frequency bound.
+//   pff_high - Upper page-fault-frequency bound, 0 disables tuning.
+// Returns:
+//    0  - Success.
+//   -1  - Task not found.
+//   -2  - pff_low is bigger than pff_high.
+int wss_set_tuning(int pid, uint8_t pff_low, uint8_t pff_high);
+
+// Returns the working-set size estimate of a task in pages.
+// Returns:
+//    n  - Estimate.
+//   -1  - Task not found.
+int wss_get_estimate(int pid);
+
+// Accounts a page fault of a task. Used by the pager before it clears r_bit of the task's pages.
+//   task       - Faulting task.
+//   page_id    - Page that is being loaded.
+//   referenced - Pages whose r_bit was set.
+void wss_on_fault(struct tTaskStruct *task, uint8_t page_id, tPageMask referenced);
+
+// Records and clears r_bit of the task's present pages and closes its sampling interval. Used by the clock tick.
+void wss_sample(struct tTaskStruct *task);
@@ -1,16 +1,63 @@
 #include <stddef.h>
+#include <string.h>
 
 #include "mmu.h"
 #include "ram.h"
+#include "task.h"
 
 static tPageTableEntry *g_page_table = NULL;
+static tTaskStruct *g_task = NULL;  // Task owning g_page_table, nullptr for other page tables.
+static uint8_t *g_remote_hits = NULL;  // Remote access counters of g_task.
+static uint8_t g_node = 0;
+static tMmuStats g_stats;
 
 void set_page_table(tPageTableEntry *page_table)
 {
     g_page_table = page_table;
+    g_task = NULL;
+    const tTaskMgr *mgr = get_task_mgr();
+    for (uint8_t slot = 0; mgr != NULL && page_table != NULL && slot < TASK_TABLE_SIZE; slot++)
+    {
+        if (mgr->tasks[slot].page_table == page_table)
+            g_task = get_task_slot(slot);
+    }
+    g_remote_hits = (g_task != NULL) ? get_task_remote_hits(g_task) : NULL;
 }
 
-int get_physical_address(uint16_t virtual_address, uint16_t *physical_address)
+void set_mmu_node(uint8_t node)
+{
+    g_node = node;
+}
+
+const tMmuStats *mmu_get_stats()
+{
+    return &g_stats;
+}
+
+void mmu_reset_stats()
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+// Counts an access to the page as local or remote.
+static void count_access(tVirtAddr id)
+{
+    const int node = ram_frame_node(g_page_table[id].frame_id);
+    if (g_task != NULL && node >= 0 && node != g_task->home_node && g_remote_hits[id] != UINT8_MAX)
+        g_remote_hits[id]++;
+
+    if (node == g_node || node < 0)
+    {
+        g_stats.local_accesses++;
+        g_stats.access_cost++;
+        return;
+    }
+
+    g_stats.remote_accesses++;
+    g_stats.access_cost += ram_get_node(node)->weight;
+}
+
+int get_physical_address(tVirtAddr virtual_address, tRamSize *physical_address)
 {
     if (g_page_table == NULL)
         return -4;
@@ -19,8 +66,8 @@ int get_physical_address(uint16_t virtual_address, uint16_t *physical_address)
     if (ram == NULL)
         return -5;
 
-    uint16_t offset_mask = ram->page_size - 1;
-    uint16_t id = virtual_address / ram->page_size;
+    tVirtAddr offset_mask = ram->page_size - 1;
+    tVirtAddr id = virtual_address / ram->page_size;
 
     if (physical_address == NULL)
         return -3;
@@ -31,19 +78,19 @@ int get_physical_address(uint16_t virtual_address, uint16_t *physical_address)
     if (g_page_table[id].p_bit == 0)
         return -1;
 
-    *physical_address = g_page_table[id].frame_id * ram->page_size + (virtual_address & offset_mask);
+    *physical_address = (tRamSize)g_page_table[id].frame_id * ram->page_size + (virtual_address & offset_mask);
     return 0;
 }
 
-int fetch_instruction(uint16_t virtual_address, uint8_t *data)
+int fetch_instruction(tVirtAddr virtual_address, uint8_t *data)
 {
-    uint16_t phy = 0;
+    tRamSize phy = 0;
     int ret = get_physical_address(virtual_address, &phy);
     if (ret < -1)
         return ret;
 
     const tRam * ram = get_ram_state();
-    uint16_t id = virtual_address / ram->page_size;
+    tVirtAddr id = virtual_address / ram->page_size;
     if (g_page_table[id].x == 0x0)
         return -3;
 
@@ -55,15 +102,15 @@ int fetch_instruction(uint16_t virtual_address, uint8_t *data)
     return 0;
 }
 
-int load_data(uint16_t virtual_address, uint8_t *data)
+int load_data(tVirtAddr virtual_address, uint8_t *data)
 {
-    uint16_t phy = 0;
+    tRamSize phy = 0;
     int ret = get_physical_address(virtual_address, &phy);
     if (ret < -1)
         return ret;
 
     const tRam * ram = get_ram_state();
-    uint16_t id = virtual_address / ram->page_size;
+    tVirtAddr id = virtual_address / ram->page_size;
     if (g_page_table[id].r == 0x0)
         return -3;
 
@@ -71,19 +118,20 @@ int load_data(uint16_t virtual_address, uint8_t *data)
         return ret;
 
     g_page_table[id].r_bit = 0x1;
+    count_access(id);
     *data = ((uint8_t *)ram)[phy];
     return 0;
 }
 
-int store_data(uint16_t virtual_address, uint8_t data)
+int store_data(tVirtAddr virtual_address, uint8_t data)
 {
-    uint16_t phy = 0;
+    tRamSize phy = 0;
     int ret = get_physical_address(virtual_address, &phy);
     if (ret < -1)
         return ret;
 
     const tRam * ram = get_ram_state();
-    uint16_t id = virtual_address / ram->page_size;
+    tVirtAddr id = virtual_address / ram->page_size;
     if (g_page_table[id].w == 0x0)
         return -3;
 
@@ -92,6 +140,7 @@ int store_data(uint16_t virtual_address, uint8_t data)
 
     g_page_table[id].m_bit = 0x1;
     g_page_table[id].r_bit = 0x1;
+    count_access(id);
     ((uint8_t *)ram)[phy] = data;
     return 0;
 }
@@ -1,82 +1,1034 @@
 #include <string.h>
+#include <time.h>
 
+#include "aio.h"
+#include "bitmap.h"
+#include "cgroup.h"
 #include "pager.h"
+#include "pte.h"
 #include "ram.h"
 #include "task.h"
 #include "types.h"
+#include "wss.h"
 
+static uint8_t g_clock = 0;         // r_bit and m_bit are maintained by pager_tick() instead of page_fault().
+static uint8_t g_flush_cursor = 0;  // Task slot where the next write-back batch starts.
+static tFrameId g_flush_watermark = 0;  // Ticks write back only while fewer frames are free. If 0, always.
+static uint16_t g_compact_budget = 0;   // Pages moved by every tick. If 0, ticks do not compact.
+static uint16_t g_migrate_budget = 0;   // Pages migrated by every tick. If 0, ticks do not migrate.
+static tPagerStats g_stats;
 
-int page_fault(int pid, uint16_t virtual_address)
+// Eviction order of the present pages of a task, the page with the lowest key goes first.
+// Called before the r_bit and m_bit are cleared.
+typedef uint16_t (*tVictimKey)(const tTaskStruct *task, uint8_t page_id);
+
+static uint16_t victim_key_nru(const tTaskStruct *task, uint8_t page_id)
+{
+    // The four NRU classes: not referenced and clean first, referenced and modified last.
+    const tPageTableEntry *entry = &task->page_table[page_id];
+    return (entry->r_bit << 1) | entry->m_bit;
+}
+
+static uint16_t victim_key_aging(const tTaskStruct *task, uint8_t page_id)
+{
+    // Among pages of equal age a clean one is cheaper to evict.
+    return (task->age[page_id] << 1) | task->page_table[page_id].m_bit;
+}
+
+static const tVictimKey g_victim_key[] = {
+    [PAGER_POLICY_NRU] = victim_key_nru,
+    [PAGER_POLICY_AGING] = victim_key_aging,
+};
+
+#define NUM_POLICIES (sizeof(g_victim_key) / sizeof(g_victim_key[0]))
+
+// Picks up to number victims among the present, unlocked pages of the task, in eviction order.
+// Pages with equal keys are taken in page table order. Returns the number of victims.
+static uint8_t select_victims(const tTaskStruct *task, uint8_t number, uint8_t *victims)
+{
+    if (task->policy == PAGER_POLICY_NRU)
+    {
+        // The NRU classes come straight from the flag masks, lowest class and page first.
+        tPteScan scan;
+        pte_scan(task->page_table, &scan);
+        uint8_t cnt = 0;
+        for (uint8_t cls = 0; cls < 4 && cnt < number; cls++)
+        {
+            const tPageMask evictable = pte_nru_class(&scan, cls) & ~scan.locked;
+            for (tPageMask pages = evictable; pages != 0 && cnt < number; pages &= pages - 1)
+            {
+                victims[cnt++] = PAGE_MASK_FIRST(pages);
+            }
+        }
+        return cnt;
+    }
+
+    uint16_t keys[PAGE_TABLE_SIZE];
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        const tPageTableEntry *entry = &task->page_table[id];
+        keys[id] = (entry->p_bit && !entry->l_bit) ? g_victim_key[task->policy](task, id) : UINT16_MAX;
+    }
+
+    uint8_t cnt = 0;
+    for (; cnt < number; cnt++)
+    {
+        uint8_t victim_id = PAGE_TABLE_SIZE;
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            if (keys[id] != UINT16_MAX && (victim_id == PAGE_TABLE_SIZE || keys[id] < keys[victim_id]))
+                victim_id = id;
+        }
+        if (victim_id == PAGE_TABLE_SIZE)
+            break;
+
+        victims[cnt] = victim_id;
+        keys[victim_id] = UINT16_MAX;
+    }
+    return cnt;
+}
+
+// Counts the evicted victims by their state.
+static void count_victim(const tTaskStruct *task, uint8_t victim_id)
+{
+    if (task->page_table[victim_id].m_bit == 0x1)
+        g_stats.dirty_victims++;
+    else
+        g_stats.clean_victims++;
+}
+
+// Writes a present page to the backing store and clears its m_bit. Returns 0 or -1 on a store error.
+static int write_back(tTaskStruct *task, uint8_t page_id)
+{
+    const tRam *ram = get_ram_state();
+    const tPageSize size = ram->page_size;
+    tPageTableEntry *entry = &task->page_table[page_id];
+    const uint8_t *frame = (const uint8_t *)ram + (entry->frame_id * size);
+    const tTaskBacking *backing = get_task_backing(task);
+    if (backing->ops->write_page(backing->store, page_id, frame, size) != 0)
+        return -1;
+
+    entry->m_bit = 0x0;
+    return 0;
+}
+
+// Turns the large page containing the page into base pages, which keep their frames.
+static void split_large(tTaskStruct *task, uint8_t page_id)
+{
+    const uint8_t pages = 0x01 << task->page_table[page_id].order;
+    const uint8_t first = page_id & ~(pages - 1);
+    for (uint8_t id = first; id < first + pages; id++)
+    {
+        task->page_table[id].order = 0;
+    }
+}
+
+// Unmaps a present page, writing it back first if it is modified. Fills frame_id with the frame the page occupied.
+// A large page containing the page is split first.
+// Returns 0 or -1 when the write-back failed, the page then stays mapped.
+static int unmap(tTaskStruct *task, uint8_t page_id, tFrameId *frame_id)
+{
+    tPageTableEntry *entry = &task->page_table[page_id];
+    if (entry->m_bit == 0x1 && write_back(task, page_id) != 0)
+        return -1;
+
+    if (entry->order != 0)
+        split_large(task, page_id);
+
+    *frame_id = entry->frame_id;
+    entry->r_bit = 0x0;
+    entry->frame_id = 0;
+    entry->p_bit = 0x0;
+    get_task_remote_hits(task)[page_id] = 0;
+    return 0;
+}
+
+// Moves a present page into the reserved frame to and frees its old frame.
+static void move_page(tPageTableEntry *entry, tFrameId to)
+{
+    const tRam *ram = get_ram_state();
+    uint8_t *base = (uint8_t *)ram;
+    memcpy(base + to * ram->page_size, base + entry->frame_id * ram->page_size, ram->page_size);
+    ffree(entry->frame_id, 1);
+    entry->frame_id = to;
+}
+
+static uint64_t elapsed_ns(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000000000u + now.tv_nsec - start->tv_nsec;
+}
+
+// Writes back the next batch of modified pages.
+static void flush()
+{
+    if (g_flush_watermark != 0 && ram_free_frames() >= g_flush_watermark)
+        return;
+
+    uint8_t budget = PAGER_FLUSH_BATCH;
+    for (uint8_t cnt = 0; cnt < TASK_TABLE_SIZE && budget > 0; cnt++)
+    {
+        const uint8_t slot = (g_flush_cursor + cnt) % TASK_TABLE_SIZE;
+        tTaskStruct *task = get_task_slot(slot);
+        if (task == NULL)
+            continue;
+
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE && budget > 0; id++)
+        {
+            const tPageTableEntry *entry = &task->page_table[id];
+            if (entry->p_bit == 0x1 && entry->m_bit == 0x1 && write_back(task, id) == 0)
+            {
+                g_stats.flushed_pages++;
+                budget--;
+            }
+        }
+        if (budget == 0)
+            g_flush_cursor = slot;
+    }
+}
+
+void pager_age(struct tTaskStruct *task)
+{
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        const tPageTableEntry *entry = &task->page_table[id];
+        if (entry->p_bit == 0x1)
+        {
+            task->age[id] = (task->age[id] >> 1) | (entry->r_bit << 7);
+        }
+    }
+}
+
+int set_large_pages(int pid, uint8_t order)
+{
+    tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    if (order > PAGER_MAX_LARGE_ORDER || (0x01 << order) > PAGE_TABLE_SIZE)
+        return -2;
+
+    task->large_order = order;
+    return 0;
+}
+
+int set_home_node(int pid, uint8_t node)
+{
+    tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    if (node >= ram_node_count())
+        return -2;
+
+    task->home_node = node;
+    return 0;
+}
+
+// Finds the pages of an address range of length bytes. Returns 0, or -4 when the range leaves the address space.
+static int page_range(tVirtAddr virtual_address, tVirtAddr length, uint8_t *first, uint8_t *last)
+{
+    const tPageSize size = get_ram_state()->page_size;
+    const uint64_t end = (uint64_t)virtual_address + length;
+    if (end > (uint64_t)PAGE_TABLE_SIZE * size)
+        return -4;
+
+    *first = virtual_address / size;
+    *last = (end - 1) / size;
+    return 0;
+}
+
+int lock_pages(int pid, tVirtAddr virtual_address, tVirtAddr length)
 {
     const tRam *ram = get_ram_state();
     tTaskStruct *task = get_task_struct(pid);
     if (ram == NULL || task == NULL)
         return -1;
 
-    const uint8_t size = ram->page_size;
-    const uint16_t page_id = virtual_address / size;
-    if (page_id >= PAGE_TABLE_SIZE)
+    uint8_t first = 0;
+    uint8_t last = 0;
+    if (length == 0)
+        return 0;
+    if (page_range(virtual_address, length, &first, &last) != 0)
         return -4;
 
-    tPageTableEntry *entry = &task->page_table[page_id];
-    if (entry->r == 0x0 && entry->w == 0x0 && entry->x == 0x0)
+    tPteScan scan;
+    pte_scan(task->page_table, &scan);
+    const tPageMask range = PAGE_MASK_RANGE(first, last - first + 1);
+    if ((scan.accessible & range) != range)
         return -4;
 
-    if (entry->p_bit == 0x1)
+    if ((scan.transit & range) != 0)
+        return -6;
+
+    const uint8_t locked = PAGE_MASK_COUNT(scan.locked | range);
+    if (locked > task->lock_limit || (task->max_frames != 0 && locked >= task->max_frames))
         return -2;
 
-    uint8_t cnt = 0;
-    uint8_t score = 0;
-    uint8_t victim_id = 0;
-    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    tPageMask added = 0;
+    for (uint8_t id = first; id <= last; id++)
     {
         tPageTableEntry *entry = &task->page_table[id];
-        if (entry->p_bit == 0x0)
+        if (entry->l_bit == 0x1)
+            continue;
+
+        // The pages locked so far are no victims of the fault.
+        const int ret = (entry->p_bit == 0x0) ? page_fault(pid, id * ram->page_size) : 0;
+        if (ret != 0)
+        {
+            for (; added != 0; added &= added - 1)
+            {
+                task->page_table[PAGE_MASK_FIRST(added)].l_bit = 0x0;
+            }
+            return ret;
+        }
+        entry->l_bit = 0x1;
+        added |= PAGE_MASK_BIT(id);
+    }
+    return 0;
+}
+
+int unlock_pages(int pid, tVirtAddr virtual_address, tVirtAddr length)
+{
+    tTaskStruct *task = get_task_struct(pid);
+    if (get_ram_state() == NULL || task == NULL)
+        return -1;
+
+    uint8_t first = 0;
+    uint8_t last = 0;
+    if (length == 0)
+        return 0;
+    if (page_range(virtual_address, length, &first, &last) != 0)
+        return -4;
+
+    for (uint8_t id = first; id <= last; id++)
+    {
+        task->page_table[id].l_bit = 0x0;
+    }
+    return 0;
+}
+
+int set_lock_limit(int pid, uint8_t pages)
+{
+    tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    if (pages > PAGE_TABLE_SIZE || pages < pager_locked_pages(pid))
+        return -2;
+
+    task->lock_limit = pages;
+    return 0;
+}
+
+int pager_locked_pages(int pid)
+{
+    const tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    tPteScan scan;
+    pte_scan(task->page_table, &scan);
+    return PAGE_MASK_COUNT(scan.locked);
+}
+
+int pager_large_coverage(int pid)
+{
+    const tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    int pages = 0;
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        const tPageTableEntry *entry = &task->page_table[id];
+        if (entry->p_bit == 0x1 && entry->order != 0)
+            pages++;
+    }
+    return pages;
+}
+
+int set_replacement_policy(int pid, uint8_t policy)
+{
+    tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    if (policy >= NUM_POLICIES)
+        return -2;
+
+    task->policy = policy;
+    return 0;
+}
+
+void pager_set_clock(uint8_t enabled)
+{
+    g_clock = (enabled != 0) ? 0x1 : 0x0;
+}
+
+int pager_tick()
+{
+    const tTaskMgr *mgr = get_task_mgr();
+    if (get_ram_state() == NULL || mgr == NULL)
+        return -1;
+
+    for (uint8_t id = 0; id < TASK_TABLE_SIZE; id++)
+    {
+        tTaskStruct *task = get_task_slot(id);
+        if (task == NULL)
             continue;
 
-        cnt++;
-        if (score < 4 && entry->r_bit == 0x0 && entry->m_bit == 0x0)
+        pager_age(task);
+        wss_sample(task);
+    }
+    flush();
+
+    const tRam *ram = get_ram_state();
+    if (ram->wmark_low != 0 && ram_free_frames() < ram->wmark_low)
+        pager_reclaim();
+
+    if (g_migrate_budget != 0)
+        pager_migrate(g_migrate_budget);
+
+    if (g_compact_budget != 0)
+        pager_compact(g_compact_budget);
+
+    return 0;
+}
+
+// Frees frames of the task and uncharges them from its group.
+static void free_frames(const tTaskStruct *task, tFrameId frame_id, tFrameId number)
+{
+    ffree(frame_id, number);
+    cgroup_uncharge(task->pid, number);
+}
+
+int pager_reclaim()
+{
+    const tRam *ram = get_ram_state();
+    const tTaskMgr *mgr = get_task_mgr();
+    if (ram == NULL || mgr == NULL)
+        return -1;
+
+    // Frames cached by threads are free already.
+    ram_drain_magazines();
+    int reclaimed = 0;
+    while (ram_free_frames() < ram->wmark_high)
+    {
+        g_stats.reclaim_scans++;
+        tTaskStruct *victim = NULL;
+        uint8_t victim_id = 0;
+        uint16_t lowest = UINT16_MAX;
+        for (uint8_t slot = 0; slot < TASK_TABLE_SIZE; slot++)
+        {
+            tTaskStruct *task = get_task_slot(slot);
+            if (task == NULL)
+                continue;
+
+            for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+            {
+                const tPageTableEntry *entry = &task->page_table[id];
+                if (entry->p_bit == 0x0 || entry->l_bit == 0x1)
+                    continue;
+
+                // Referenced since the last aging first, then the age, clean pages are cheaper.
+                const uint16_t key = (entry->r_bit << 9) | (task->age[id] << 1) | entry->m_bit;
+                if (key < lowest)
+                {
+                    lowest = key;
+                    victim = task;
+                    victim_id = id;
+                }
+            }
+        }
+        tFrameId frame_id = 0;
+        if (victim == NULL || unmap(victim, victim_id, &frame_id) != 0)
+            break;
+
+        free_frames(victim, frame_id, 1);
+        reclaimed++;
+    }
+    g_stats.reclaimed_pages += reclaimed;
+    return reclaimed;
+}
+
+// Reserves frames for the task in its home node, spilling over to the following nodes when it is full.
+// The frames are charged to the group of the task.
+// Returns 0, -1 when no run of free frames is large enough, or -2 when the group of the task is at its limit.
+static int alloc_frames(const tTaskStruct *task, tFrameId *frame_id, tFrameId number)
+{
+    if (cgroup_charge(task->pid, number) != 0)
+        return -2;
+
+    const uint8_t nodes = ram_node_count();
+    if (nodes <= 1)
+    {
+        if (falloc(frame_id, number) == 0)
+            return 0;
+
+        cgroup_uncharge(task->pid, number);
+        return -1;
+    }
+
+    for (uint8_t step = 0; step < nodes; step++)
+    {
+        if (falloc_node(frame_id, number, (task->home_node + step) % nodes) == 0)
+        {
+            if (step != 0)
+                g_stats.remote_frames += number;
+            return 0;
+        }
+    }
+    cgroup_uncharge(task->pid, number);
+    return -1;
+}
+
+// Same as alloc_frames() for frames that need not be consecutive. Returns the number of reserved frames.
+// The caller keeps number within cgroup_headroom() of the task.
+static int alloc_scattered(const tTaskStruct *task, tFrameId *frame_ids, tFrameId number)
+{
+    const uint8_t nodes = ram_node_count();
+    tFrameId got = 0;
+    for (uint8_t step = 0; nodes > 1 && step < nodes && got < number; step++)
+    {
+        const int taken = falloc_scattered_node(frame_ids + got, number - got, (task->home_node + step) % nodes);
+        if (taken > 0 && step != 0)
+            g_stats.remote_frames += taken;
+        got += (taken > 0) ? taken : 0;
+    }
+    if (nodes <= 1)
+    {
+        const int taken = falloc_scattered(frame_ids, number);
+        got = (taken > 0) ? taken : 0;
+    }
+    cgroup_charge(task->pid, got);
+    return got;
+}
+
+int pager_compact(uint16_t budget)
+{
+    const tRam *ram = get_ram_state();
+    const tTaskMgr *mgr = get_task_mgr();
+    if (ram == NULL || mgr == NULL)
+        return -1;
+
+    int moved = 0;
+    for (uint8_t node = 0; node < ram_node_count(); node++)
+    {
+        // Pages stay in their node.
+        const tRamNode *ram_node = ram_get_node(node);
+        const tFrameId first = ram_node->first;
+        const tFrameId end = ram_node->first + ram_node->frames;
+        while (moved < budget)
         {
-            score = 4;
-            victim_id = id;
+            // The page in the highest frame moves to the lowest free frame.
+            tPageTableEntry *highest = NULL;
+            for (uint8_t slot = 0; slot < TASK_TABLE_SIZE; slot++)
+            {
+                tTaskStruct *task = get_task_slot(slot);
+                for (uint8_t id = 0; task != NULL && id < PAGE_TABLE_SIZE; id++)
+                {
+                    tPageTableEntry *entry = &task->page_table[id];
+                    if (entry->p_bit == 0x0 || entry->t_bit == 0x1 || entry->l_bit == 0x1 || entry->order != 0 ||
+                        entry->frame_id < first || entry->frame_id >= end)
+                        continue;
+
+                    if (highest == NULL || entry->frame_id > highest->frame_id)
+                        highest = entry;
+                }
+            }
+            if (highest == NULL)
+                break;
+
+            uint8_t *base = (uint8_t *)ram;
+            const uint8_t *summary = (ram->summary != 0) ? base + ram->summary : NULL;
+            const int32_t to = bitmap_summary_find_clear_run(base + ram->bitmap, summary, end, first, 1);
+            if (to < 0 || (tFrameId)to > highest->frame_id || falloc_at(to, 1) != 0)
+                break;
+
+            move_page(highest, to);
+            moved++;
         }
-        if (score < 3 && entry->r_bit == 0x0 && entry->m_bit == 0x1)
+    }
+    g_stats.compacted_pages += moved;
+    return moved;
+}
+
+void pager_set_compaction(uint16_t budget)
+{
+    g_compact_budget = budget;
+}
+
+int pager_migrate(uint16_t budget)
+{
+    const tTaskMgr *mgr = get_task_mgr();
+    if (get_ram_state() == NULL || mgr == NULL)
+        return -1;
+
+    const tPageSize page_size = get_ram_state()->page_size;
+    uint8_t full_nodes = 0;  // Home nodes without a free frame, bit n for node n.
+    int moved = 0;
+    while (moved < budget)
+    {
+        // The page with the most remote accesses moves first.
+        tTaskStruct *hottest = NULL;
+        uint8_t *hottest_hits = NULL;
+        uint8_t hottest_id = 0;
+        for (uint8_t slot = 0; slot < TASK_TABLE_SIZE; slot++)
         {
-            score = 3;
-            victim_id = id;
+            tTaskStruct *task = get_task_slot(slot);
+            if (task == NULL || (full_nodes & (0x01 << task->home_node)))
+                continue;
+
+            uint8_t *hits = get_task_remote_hits(task);
+            for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+            {
+                const tPageTableEntry *entry = &task->page_table[id];
+                if (entry->p_bit == 0x0 || entry->t_bit == 0x1 || entry->l_bit == 0x1 || entry->order != 0 ||
+                    hits[id] < PAGER_MIGRATE_THRESHOLD ||
+                    ram_frame_node(entry->frame_id) == task->home_node)
+                    continue;
+
+                if (hottest == NULL || hits[id] > hottest_hits[hottest_id])
+                {
+                    hottest = task;
+                    hottest_hits = hits;
+                    hottest_id = id;
+                }
+            }
         }
-        if (score < 2 && entry->r_bit == 0x1 && entry->m_bit == 0x0)
+        if (hottest == NULL)
+            break;
+
+        tFrameId to = 0;
+        if (falloc_node(&to, 1, hottest->home_node) != 0)
         {
-            score = 2;
-            victim_id = id;
+            full_nodes |= 0x01 << hottest->home_node;
+            continue;
         }
-        if (score < 1 && entry->r_bit == 0x1 && entry->m_bit == 0x1)
+
+        move_page(&hottest->page_table[hottest_id], to);
+        hottest_hits[hottest_id] = 0;
+        moved++;
+    }
+
+    // Only recent accesses count for the next call.
+    for (uint8_t slot = 0; slot < TASK_TABLE_SIZE; slot++)
+    {
+        uint8_t *hits = get_task_remote_hits(get_task_slot(slot));
+        for (uint8_t id = 0; hits != NULL && id < PAGE_TABLE_SIZE; id++)
         {
-            score = 1;
-            victim_id = id;
+            hits[id] /= 2;
         }
+    }
+    g_stats.migrated_pages += moved;
+    g_stats.migrated_bytes += (uint64_t)moved * page_size;
+    return moved;
+}
+
+void pager_set_migration(uint16_t budget)
+{
+    g_migrate_budget = budget;
+}
+
+void pager_set_flush_watermark(tFrameId frames)
+{
+    g_flush_watermark = frames;
+}
+
+const tPagerStats *pager_get_stats()
+{
+    return &g_stats;
+}
+
+void pager_reset_stats()
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+// Writes back all modified pages of the task and clears their r_bit. Returns the pages whose r_bit was set.
+static tPageMask clear_references(tTaskStruct *task)
+{
+    tPageMask referenced = 0;
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        tPageTableEntry *entry = &task->page_table[id];
+        if (entry->p_bit == 0x0)
+            continue;
+
         if (entry->m_bit == 0x1)
         {
-            memcpy((uint8_t *)task->address_space + (id * size), (uint8_t *)ram + (entry->frame_id * size), size);
+            write_back(task, id);
+        }
+        if (entry->r_bit == 0x1)
+        {
+            referenced |= PAGE_MASK_BIT(id);
         }
         entry->r_bit = 0x0;
-        entry->m_bit = 0x0;
     }
+    return referenced;
+}
+
+// A page fault between finding a frame for the page and loading it.
+typedef struct tFault
+{
+    tTaskStruct *task;
+    int pid;
+    uint8_t page_id;
+    uint8_t direct_reclaim;  // No free frame was found, a victim was evicted.
+    uint8_t victim;          // Page evicted to provide the frame, PAGE_TABLE_SIZE if none was.
+    tPageMask referenced;    // Pages whose r_bit was cleared by the fault.
+    struct timespec start;
+} tFault;
+
+static tFault g_transit[AIO_QUEUE_DEPTH];  // Page faults waiting for their asynchronous read.
+static uint8_t g_transit_busy[AIO_QUEUE_DEPTH];
+
+// Validates the fault and provides a frame for the page, evicting a victim if needed.
+// Returns 0 with frame_id of the page set, or an error code of page_fault().
+static int begin_fault(int pid, tVirtAddr virtual_address, tFault *fault)
+{
+    const tRam *ram = get_ram_state();
+    tTaskStruct *task = get_task_struct(pid);
+    if (ram == NULL || task == NULL)
+        return -1;
+
+    const tPageSize size = ram->page_size;
+    const tVirtAddr page_id = virtual_address / size;
+    if (page_id >= PAGE_TABLE_SIZE)
+        return -4;
+
+    tPageTableEntry *entry = &task->page_table[page_id];
+    if (entry->r == 0x0 && entry->w == 0x0 && entry->x == 0x0)
+        return -4;
+
+    if (entry->p_bit == 0x1)
+        return -2;
 
-    if ((task->max_frames != 0 && cnt == task->max_frames) || falloc(&entry->frame_id, 1) != 0)
+    if (entry->t_bit == 0x1)
+        return -6;
+
+    fault->task = task;
+    fault->pid = pid;
+    fault->page_id = page_id;
+    fault->direct_reclaim = 0;
+    fault->victim = PAGE_TABLE_SIZE;
+    fault->referenced = 0;
+    clock_gettime(CLOCK_MONOTONIC, &fault->start);
+
+    tPteScan scan;
+    pte_scan(task->page_table, &scan);
+    const uint8_t cnt = PAGE_MASK_COUNT(scan.present | scan.transit);
+    if (g_clock == 0x0)
+        pager_age(task);
+
+    uint8_t evict = (task->max_frames != 0 && cnt >= task->max_frames);
+    uint8_t victim_id = 0;
+    if (!evict)
+    {
+        // A task at the limit of its group evicts its own page like one at max_frames.
+        const int ret = alloc_frames(task, &entry->frame_id, 1);
+        evict = (ret != 0);
+        fault->direct_reclaim = (ret == -1);
+    }
+    if (evict)
     {
-        if (cnt == 0)  // this means we have no frames present and falloc failed
+        if (select_victims(task, 1, &victim_id) == 0)  // no unlocked frames present and falloc failed
         {
             return -3;
         }
-        tPageTableEntry *victim = &task->page_table[victim_id];
-        entry->frame_id = victim->frame_id;
-        victim->frame_id = 0;
-        victim->p_bit = 0x0;
+        count_victim(task, victim_id);
+    }
+
+    if (g_clock == 0x0)
+        fault->referenced = clear_references(task);
+
+    if (evict && unmap(task, victim_id, &entry->frame_id) != 0)
+        return -5;
+
+    if (evict)
+        fault->victim = victim_id;
+    return 0;
+}
+
+// Maps the loaded page, or releases its frame when loading failed.
+static void end_fault(tFault *fault, int loaded)
+{
+    tTaskStruct *task = fault->task;
+    tPageTableEntry *entry = &task->page_table[fault->page_id];
+    entry->t_bit = 0x0;
+    if (!loaded)
+    {
+        free_frames(task, entry->frame_id, 1);
+        entry->frame_id = 0;
+        return;
     }
 
     entry->p_bit = 0x1;
-    memcpy((uint8_t *)ram + (entry->frame_id * size), (uint8_t *)task->address_space + (page_id * size), size);
+    task->age[fault->page_id] = 0x80;  // Loading the page counts as a reference.
+    wss_on_fault(task, fault->page_id, fault->referenced);
+    g_stats.faults++;
+    if (fault->direct_reclaim)
+    {
+        g_stats.direct_reclaims++;
+        g_stats.direct_reclaim_ns += elapsed_ns(&fault->start);
+    }
+}
+
+// Takes back a fault that never started loading: the victim gets its frame back, written back and clean,
+// a frame taken from RAM is released.
+static void cancel_fault(tFault *fault)
+{
+    if (fault->victim == PAGE_TABLE_SIZE)
+    {
+        end_fault(fault, 0);
+        return;
+    }
+
+    tPageTableEntry *entry = &fault->task->page_table[fault->page_id];
+    tPageTableEntry *victim = &fault->task->page_table[fault->victim];
+    victim->frame_id = entry->frame_id;
+    victim->p_bit = 0x1;
+    entry->t_bit = 0x0;
+    entry->frame_id = 0;
+}
+
+// Loads the large page containing the page into consecutive frames.
+// Returns 0, -5 on a backing store error, or 1 when the fault has to fall back to a base page.
+static int fault_large(tTaskStruct *task, uint8_t page_id)
+{
+    const uint8_t pages = 0x01 << task->large_order;
+    const uint8_t first = page_id & ~(pages - 1);
+    const tPageMask group = PAGE_MASK_RANGE(first, pages);
+    tPteScan scan;
+    pte_scan(task->page_table, &scan);
+    if ((scan.accessible & group) != group || ((scan.present | scan.transit) & group) != 0)
+        return 1;
+
+    const uint8_t cnt = PAGE_MASK_COUNT(scan.present | scan.transit);
+    tFrameId frame_id = 0;
+    if ((task->max_frames != 0 && cnt + pages > task->max_frames) || alloc_frames(task, &frame_id, pages) != 0)
+    {
+        g_stats.large_fallbacks++;
+        return 1;
+    }
+
+    const tRam *ram = get_ram_state();
+    const tPageSize size = ram->page_size;
+    const tTaskBacking *backing = get_task_backing(task);
+    for (uint8_t id = 0; id < pages; id++)
+    {
+        uint8_t *frame = (uint8_t *)ram + ((frame_id + id) * size);
+        if (backing->ops->read_page(backing->store, first + id, frame, size) != 0)
+        {
+            free_frames(task, frame_id, pages);
+            return -5;
+        }
+    }
+
+    if (g_clock == 0x0)
+        pager_age(task);
+    const tPageMask referenced = (g_clock == 0x0) ? clear_references(task) : 0;
+    for (uint8_t id = 0; id < pages; id++)
+    {
+        tPageTableEntry *entry = &task->page_table[first + id];
+        entry->frame_id = frame_id + id;
+        entry->order = task->large_order;
+        entry->p_bit = 0x1;
+        task->age[first + id] = 0x80;
+    }
+    wss_on_fault(task, page_id, referenced | group);
+    g_stats.faults++;
+    g_stats.large_pages++;
+    return 0;
+}
+
+int page_fault(int pid, tVirtAddr virtual_address)
+{
+    const tRam *ram = get_ram_state();
+    tTaskStruct *task = get_task_struct(pid);
+    if (ram != NULL && task != NULL && task->large_order != 0 && virtual_address / ram->page_size < PAGE_TABLE_SIZE)
+    {
+        const int ret = fault_large(task, virtual_address / ram->page_size);
+        if (ret <= 0)
+            return ret;
+    }
+
+    tFault fault;
+    int ret = begin_fault(pid, virtual_address, &fault);
+    if (ret != 0)
+        return ret;
+
+    uint8_t *frame = (uint8_t *)ram + (task->page_table[fault.page_id].frame_id * ram->page_size);
+    const tTaskBacking *backing = get_task_backing(task);
+    const int loaded = backing->ops->read_page(backing->store, fault.page_id, frame, ram->page_size) == 0;
+    end_fault(&fault, loaded);
+    return loaded ? 0 : -5;
+}
+
+int page_fault_batch(int pid, const tVirtAddr *virtual_addresses, uint8_t number)
+{
+    const tRam *ram = get_ram_state();
+    tTaskStruct *task = get_task_struct(pid);
+    if (ram == NULL || task == NULL)
+        return -1;
+
+    if (virtual_addresses == NULL && number != 0)
+        return -4;
+
+    const tPageSize size = ram->page_size;
+    tPteScan scan;
+    pte_scan(task->page_table, &scan);
+    tPageMask wanted = 0;
+    for (uint8_t cnt = 0; cnt < number; cnt++)
+    {
+        const tVirtAddr page_id = virtual_addresses[cnt] / size;
+        if (page_id >= PAGE_TABLE_SIZE || (scan.accessible & PAGE_MASK_BIT(page_id)) == 0)
+            return -4;
+
+        wanted |= PAGE_MASK_BIT(page_id);
+    }
+    wanted &= ~(scan.present | scan.transit);
+
+    uint8_t pages[PAGE_TABLE_SIZE];
+    uint8_t need = 0;
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        if (wanted & PAGE_MASK_BIT(id))
+            pages[need++] = id;
+    }
+    if (need == 0)
+        return 0;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    const uint8_t cnt = PAGE_MASK_COUNT(scan.present | scan.transit);
+    if (g_clock == 0x0)
+        pager_age(task);
+
+    // Frames the task may still take before it has to evict its own pages.
+    uint8_t allowed = need;
+    if (task->max_frames != 0)
+        allowed = (cnt >= task->max_frames) ? 0 : task->max_frames - cnt;
+    if (allowed > need)
+        allowed = need;
+    const tFrameId headroom = cgroup_headroom(pid);
+    if (allowed > headroom)
+        allowed = headroom;
+
+    tFrameId frame_ids[PAGE_TABLE_SIZE];
+    int got = (allowed > 0) ? alloc_scattered(task, frame_ids, allowed) : 0;
+    const uint8_t direct_reclaim = (got < allowed);
+
+    uint8_t victims[PAGE_TABLE_SIZE];
+    const uint8_t evictions = select_victims(task, need - got, victims);
+    if (got + evictions == 0)
+        return -3;
+
+    for (uint8_t id = 0; id < evictions; id++)
+    {
+        count_victim(task, victims[id]);
+    }
+
+    const tPageMask referenced = (g_clock == 0x0) ? clear_references(task) : 0;
+    int failed = 0;
+    for (uint8_t id = 0; id < evictions; id++)
+    {
+        if (unmap(task, victims[id], &frame_ids[got]) == 0)
+            got++;
+        else
+            failed = 1;
+    }
+
+    const tTaskBacking *backing = get_task_backing(task);
+    int loaded = 0;
+    for (uint8_t id = 0; id < got; id++)
+    {
+        const uint8_t page_id = pages[id];
+        tPageTableEntry *entry = &task->page_table[page_id];
+        uint8_t *frame = (uint8_t *)ram + (frame_ids[id] * size);
+        if (backing->ops->read_page(backing->store, page_id, frame, size) != 0)
+        {
+            free_frames(task, frame_ids[id], 1);
+            failed = 1;
+            continue;
+        }
+
+        entry->frame_id = frame_ids[id];
+        entry->p_bit = 0x1;
+        task->age[page_id] = 0x80;
+        wss_on_fault(task, page_id, referenced);
+        loaded++;
+    }
+
+    g_stats.faults += loaded;
+    if (direct_reclaim)
+    {
+        g_stats.direct_reclaims++;
+        g_stats.direct_reclaim_ns += elapsed_ns(&start);
+    }
+    return (loaded == 0 && failed) ? -5 : loaded;
+}
+
+// Ends the fault waiting in the transit slot tag for its finished read.
+static void complete_fault(uint32_t tag, int result)
+{
+    tFault *fault = &g_transit[tag];
+    g_transit_busy[tag] = 0;
+    // The task may have been destroyed while the page was in transit, its frames are released already.
+    if (get_task_struct(fault->pid) == fault->task && fault->task->page_table[fault->page_id].t_bit == 0x1)
+        end_fault(fault, result == 0);
+}
 
+int page_fault_async(int pid, tVirtAddr virtual_address)
+{
+    uint8_t slot = 0;
+    while (slot < AIO_QUEUE_DEPTH && g_transit_busy[slot])
+        slot++;
+
+    // Nothing is evicted for a read the engine cannot take.
+    if (slot == AIO_QUEUE_DEPTH || !aio_ready())
+        return -7;
+
+    tFault *fault = &g_transit[slot];
+    int ret = begin_fault(pid, virtual_address, fault);
+    if (ret != 0)
+        return ret;
+
+    const tRam *ram = get_ram_state();
+    tTaskStruct *task = fault->task;
+    tPageTableEntry *entry = &task->page_table[fault->page_id];
+    const tTaskBacking *backing = get_task_backing(task);
+    const tAioRead read = {
+        .backing = backing->ops,
+        .store = backing->store,
+        .page_id = fault->page_id,
+        .page_size = ram->page_size,
+        .frame = (uint8_t *)ram + (entry->frame_id * ram->page_size),
+        .tag = slot,
+    };
+    entry->t_bit = 0x1;
+    // Reads still in flight when the engine stops complete through the drain.
+    aio_set_drain(complete_fault);
+    if (aio_submit(&read) != 0)
+    {
+        cancel_fault(fault);
+        return -7;
+    }
+    g_transit_busy[slot] = 1;
     return 0;
 }
+
+int pager_complete(uint8_t wait)
+{
+    uint32_t tags[AIO_QUEUE_DEPTH];
+    int results[AIO_QUEUE_DEPTH];
+    int cnt = aio_reap(tags, results, AIO_QUEUE_DEPTH, wait);
+    for (int id = 0; id < cnt; id++)
+    {
+        complete_fault(tags[id], results[id]);
+    }
+    return cnt;
+}
@@ -0,0 +1,105 @@
+#include <stddef.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "pte.h"
+
+// The vector kernels of pte_scan() take one 32-bit lane per entry. Entries of the wide configuration
+// are 8 bytes and are scanned by the scalar loop.
+#if !defined(RAM_WIDE)
+_Static_assert(sizeof(tPageTableEntry) == 4, "pte_scan expects 4-byte page table entries");
+#endif
+
+// Positions of the flags in the first two bytes of tPageTableEntry, order takes bits 8 and 9.
+#define PTE_R 0
+#define PTE_W 1
+#define PTE_X 2
+#define PTE_P 3
+#define PTE_REF 4
+#define PTE_MOD 5
+#define PTE_TRANSIT 6
+#define PTE_LOCKED 10
+
+// Entries per chunk of the vector kernels of pte_scan().
+#define PTE_CHUNK 8
+
+// Adds the flags of the entries from first on to the masks, one entry at a time.
+static void scan_entries(const tPageTableEntry *page_table, uint8_t first, tPteScan *masks)
+{
+    for (uint8_t id = first; id < PAGE_TABLE_SIZE; id++)
+    {
+        const tPageTableEntry *entry = &page_table[id];
+        const tPageMask bit = PAGE_MASK_BIT(id);
+        masks->accessible |= (entry->r | entry->w | entry->x) ? bit : 0;
+        masks->present |= entry->p_bit ? bit : 0;
+        masks->referenced |= entry->r_bit ? bit : 0;
+        masks->modified |= entry->m_bit ? bit : 0;
+        masks->transit |= entry->t_bit ? bit : 0;
+        masks->locked |= entry->l_bit ? bit : 0;
+    }
+}
+
+#if !defined(RAM_WIDE) && defined(__AVX2__)
+
+// Moves flag bit of every 32-bit lane to the sign bit and gathers the signs as the pages from id on.
+#define LANE_MASK(v, bit, id)                                                                                      \
+    ((tPageMask)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32((v), 31 - (bit)))) << (id))
+
+void pte_scan(const tPageTableEntry *page_table, tPteScan *scan)
+{
+    tPteScan masks = {0};
+    uint8_t id = 0;
+    for (; id + PTE_CHUNK <= PAGE_TABLE_SIZE; id += PTE_CHUNK)
+    {
+        const __m256i entries = _mm256_loadu_si256((const __m256i *)(page_table + id));
+        masks.accessible |= LANE_MASK(entries, PTE_R, id) | LANE_MASK(entries, PTE_W, id) |
+                            LANE_MASK(entries, PTE_X, id);
+        masks.present |= LANE_MASK(entries, PTE_P, id);
+        masks.referenced |= LANE_MASK(entries, PTE_REF, id);
+        masks.modified |= LANE_MASK(entries, PTE_MOD, id);
+        masks.transit |= LANE_MASK(entries, PTE_TRANSIT, id);
+        masks.locked |= LANE_MASK(entries, PTE_LOCKED, id);
+    }
+    scan_entries(page_table, id, &masks);
+    *scan = masks;
+}
+
+#elif !defined(RAM_WIDE) && defined(__SSE2__)
+
+#define LANE_MASK(lo, hi, bit, id)                                                                                 \
+    ((tPageMask)(_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32((lo), 31 - (bit)))) |                            \
+                 (_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32((hi), 31 - (bit)))) << 4))                      \
+     << (id))
+
+void pte_scan(const tPageTableEntry *page_table, tPteScan *scan)
+{
+    tPteScan masks = {0};
+    uint8_t id = 0;
+    for (; id + PTE_CHUNK <= PAGE_TABLE_SIZE; id += PTE_CHUNK)
+    {
+        const __m128i lo = _mm_loadu_si128((const __m128i *)(page_table + id));
+        const __m128i hi = _mm_loadu_si128((const __m128i *)(page_table + id) + 1);
+        masks.accessible |= LANE_MASK(lo, hi, PTE_R, id) | LANE_MASK(lo, hi, PTE_W, id) |
+                            LANE_MASK(lo, hi, PTE_X, id);
+        masks.present |= LANE_MASK(lo, hi, PTE_P, id);
+        masks.referenced |= LANE_MASK(lo, hi, PTE_REF, id);
+        masks.modified |= LANE_MASK(lo, hi, PTE_MOD, id);
+        masks.transit |= LANE_MASK(lo, hi, PTE_TRANSIT, id);
+        masks.locked |= LANE_MASK(lo, hi, PTE_LOCKED, id);
+    }
+    scan_entries(page_table, id, &masks);
+    *scan = masks;
+}
+
+#else
+
+void pte_scan(const tPageTableEntry *page_table, tPteScan *scan)
+{
+    tPteScan masks = {0};
+    scan_entries(page_table, 0, &masks);
+    *scan = masks;
+}
+
+#endif
@@ -1,35 +1,119 @@
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 
+#include "bitmap.h"
 #include "ram.h"
 
+// Free frames cached for one thread. The owner and drains lock it with busy, then take g_lock if needed.
+typedef struct tMagazine
+{
+    _Alignas(64) atomic_flag busy;  // Own cache line, so that threads do not slow each other down.
+    uint8_t used;          // The slot belongs to a thread. Changed with g_lock held.
+    uint8_t count;         // Number of frames in frames, the last one is handed out next.
+    atomic_uint_least32_t hits;  // Allocations served from the magazine.
+    tFrameId frames[RAM_MAGAZINE_SIZE];
+} tMagazine;
+
 static tRam *g_ram = NULL;
+static tRamStats g_stats;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;  // Serializes access to the bitmap and g_stats.
+static tMagazine g_magazines[RAM_MAGAZINES];
+static uint8_t g_magazines_enabled = 0;
+static pthread_key_t g_magazine_key;     // Returns the magazine of an exiting thread, see release_magazine().
+static pthread_once_t g_magazine_once = PTHREAD_ONCE_INIT;
+static _Thread_local tMagazine *g_own_magazine = NULL;
+static uint8_t g_lock_free = 0;          // Bitmap updated with atomics, see ram_set_lock_free().
+static atomic_uint_least32_t g_lock_free_allocations;
+static _Thread_local tFrameId g_own_hint = 0;  // Where the next lock-free falloc() of the thread searches.
+static tRamNode g_nodes[RAM_MAX_NODES];  // Only g_nodes[0] is used and covers all RAM until ram_set_nodes().
+static uint8_t g_node_count = 0;
 
 #define NUM_RAM_FRAMES g_ram->size / g_ram->page_size
+#define BITMAP ((uint8_t *)g_ram + g_ram->bitmap)
+// The summary is not maintained in lock-free mode, it stays zeroed and searches read every word.
+#define SUMMARY ((g_ram->summary != 0 && !g_lock_free) ? (uint8_t *)g_ram + g_ram->summary : NULL)
 #define NUM_FRAMES(bytes) ((bytes) / g_ram->page_size) + (((bytes) % g_ram->page_size) ? 1 : 0)
 
+// Reserves frames found free by a search. Returns -1 if a lock-free falloc() took one of them meanwhile.
+static int mark_used(tFrameId frame_id, tFrameId number)
+{
+    if (g_lock_free)
+        return bitmap_atomic_set_range(BITMAP, frame_id, number);
+
+    bitmap_set_range(BITMAP, frame_id, number);
+    if (g_ram->summary != 0)
+        bitmap_summary_update(BITMAP, SUMMARY, NUM_RAM_FRAMES, frame_id, number);
+    return 0;
+}
+
+static void mark_free(tFrameId frame_id, tFrameId number)
+{
+    if (g_lock_free)
+    {
+        bitmap_atomic_clear_range(BITMAP, frame_id, number);
+        return;
+    }
+
+    bitmap_clear_range(BITMAP, frame_id, number);
+    if (g_ram->summary != 0)
+        bitmap_summary_update(BITMAP, SUMMARY, NUM_RAM_FRAMES, frame_id, number);
+}
+
 uint8_t *init_bitmap()
 {
     if (NUM_FRAMES(sizeof(tRam)) > NUM_RAM_FRAMES)
         return NULL;
 
-    // number of bytes of tRam data with bitmap
-    uint16_t bytes = sizeof(tRam) + ((NUM_RAM_FRAMES >= 8) ? (NUM_RAM_FRAMES / 8) : 1);
-    uint16_t frames = NUM_FRAMES(bytes);
+    // number of bytes of tRam data with bitmap and its summary
+    const tRamSize bitmap_bytes = (NUM_RAM_FRAMES >= 8) ? (NUM_RAM_FRAMES / 8) : 1;
+    const tRamSize summary_bytes = (NUM_RAM_FRAMES > 64) ? BITMAP_SUMMARY_BYTES(NUM_RAM_FRAMES) : 0;
+    tRamSize bytes = sizeof(tRam) + bitmap_bytes + summary_bytes;
+    tFrameId frames = NUM_FRAMES(bytes);
 
     if (frames > NUM_RAM_FRAMES)
         return NULL;
 
-    g_ram->bitmap = (uint8_t *)(g_ram + 1);
-    for (uint16_t frame_id = 0; frame_id < frames; frame_id++)
+    // Memory is zeroed, only the words of the reserved frames need their summary bits.
+    g_ram->bitmap = sizeof(tRam);
+    g_ram->summary = (summary_bytes != 0) ? sizeof(tRam) + bitmap_bytes : 0;
+    mark_used(0, frames);
+    return BITMAP;
+}
+
+#define ZERO_BLOCK 64  // Bytes tested at once by is_zeroed().
+
+// Tests whether memory holds zeros only. The words of a block are OR-ed together without branches,
+// which the compiler vectorizes, and only the result of every block is tested.
+static int is_zeroed(const uint8_t *memory, tRamSize size)
+{
+    tRamSize pos = 0;
+    for (; size - pos >= ZERO_BLOCK; pos += ZERO_BLOCK)
     {
-        g_ram->bitmap[frame_id / 8] |= (0x01 << (frame_id % 8));
+        uint64_t bits = 0;
+        for (uint8_t word = 0; word < ZERO_BLOCK / sizeof(uint64_t); word++)
+        {
+            uint64_t value;
+            memcpy(&value, memory + pos + word * sizeof(uint64_t), sizeof(value));
+            bits |= value;
+        }
+        if (bits != 0)
+            return 0;
     }
-    return g_ram->bitmap;
+    for (; pos < size; pos++)
+    {
+        if (memory[pos] != 0)
+            return 0;
+    }
+    return 1;
 }
 
-int init_ram(void *memory, uint16_t size, uint8_t page_size)
+static void reset_magazines();
+static void reset_nodes();
+
+static int init(void *memory, tRamSize size, tPageSize page_size, int trusted)
 {
     if (NULL == memory)
         return -3;
@@ -44,15 +128,16 @@ int init_ram(void *memory, uint16_t size, uint8_t page_size)
         return -2;
     }
 
-    for (uint16_t pos = 0; pos < size; pos++)
-    {
-        if (((char *)memory)[pos] != 0)
-            return -3;
-    }
+    if (!trusted && !is_zeroed((const uint8_t *)memory, size))
+        return -3;
 
+    reset_magazines();
+    g_lock_free = 0;
     g_ram = (tRam *)memory;
     g_ram->size = size;
     g_ram->page_size = page_size;
+    reset_nodes();
+    ram_reset_stats();
     if (init_bitmap())
     {
         return size / page_size;
@@ -64,65 +149,618 @@ int init_ram(void *memory, uint16_t size, uint8_t page_size)
     return -4;
 }
 
+int init_ram(void *memory, tRamSize size, tPageSize page_size)
+{
+    return init(memory, size, page_size, 0);
+}
+
+int init_ram_trusted(void *memory, tRamSize size, tPageSize page_size)
+{
+    return init(memory, size, page_size, 1);
+}
+
+// Tests whether the region of bytes at offset lies in RAM behind tRam and does not overlap [other, other_end).
+static int region_valid(const tRam *ram, tRamSize offset, uint64_t bytes, uint64_t other, uint64_t other_end)
+{
+    const uint64_t end = (uint64_t)offset + bytes;
+    return offset >= sizeof(tRam) && end <= ram->size && (end <= other || offset >= other_end);
+}
+
+// Tests whether the bitmap and its summary as recorded in tRam fit the RAM, as init_bitmap() lays them out.
+static int layout_valid(const tRam *ram)
+{
+    const tFrameId frames = ram->size / ram->page_size;
+    const uint64_t bitmap_bytes = (frames >= 8) ? (frames / 8) : 1;
+    const uint64_t summary_bytes = (frames > 64) ? BITMAP_SUMMARY_BYTES(frames) : 0;
+    if (!region_valid(ram, ram->bitmap, bitmap_bytes, 0, 0))
+        return 0;
+
+    if (summary_bytes == 0)
+        return ram->summary == 0;
+
+    return region_valid(ram, ram->summary, summary_bytes, ram->bitmap, ram->bitmap + bitmap_bytes);
+}
+
+int attach_ram(void *memory, tRamSize size, tPageSize page_size)
+{
+    if (NULL == memory)
+        return -1;
+
+    tRam *ram = (tRam *)memory;
+    if (ram->size != size || ram->page_size != page_size || size == 0 || page_size == 0 || !layout_valid(ram))
+        return -2;
+
+    reset_magazines();
+    g_lock_free = 0;
+    g_ram = ram;
+    reset_nodes();
+    return size / page_size;
+}
+
 void destroy_ram()
 {
+    ram_drain_magazines();
+    g_magazines_enabled = 0;
+    if (g_ram != NULL)
+        ram_set_lock_free(0);
+    g_node_count = 0;
     g_ram = NULL;
 }
 
-int falloc(uint16_t *frame_id, uint16_t number)
+// Lowest run of number free frames in [start, end) plus the frames before it that have to be
+// passed, counted in scanned_frames.
+static int32_t find_first_fit(tFrameId start, tFrameId end, tFrameId number)
 {
-    if (g_ram == NULL)
-        return -1;
+    const int32_t found = bitmap_summary_find_clear_run(BITMAP, SUMMARY, end, start, number);
+    g_stats.scanned_frames += (found >= 0) ? (uint32_t)(found + number - start) : (uint32_t)(end - start);
+    return found;
+}
 
-    if (number == 0 || frame_id == NULL)
-        return -1;
+static int32_t find_next_fit(tFrameId first, tFrameId end, tFrameId rover, tFrameId number)
+{
+    rover = (rover >= first && rover < end) ? rover : first;
+    int32_t found = find_first_fit(rover, end, number);
+    if (found < 0 && rover > first)
+    {
+        // Wraps around, runs that cross the rover count as well.
+        const uint32_t wrap_end = (uint32_t)rover + number - 1;
+        found = find_first_fit(first, (wrap_end < end) ? wrap_end : end, number);
+    }
+    return found;
+}
 
-    uint16_t start_frame_id = 0;
-    uint16_t found_number = 0;
-    for (uint16_t id = 0; id < NUM_RAM_FRAMES; id++)
+static int32_t find_best_fit(tFrameId first, tFrameId end, tFrameId number)
+{
+    int32_t best = -1;
+    uint32_t best_length = UINT32_MAX;
+    uint32_t pos = first;
+    uint32_t length = 0;
+    int32_t run;
+    while ((run = bitmap_summary_next_clear_run(BITMAP, SUMMARY, end, pos, &length)) >= 0)
     {
-        if ((g_ram->bitmap[id / 8] & (0x01 << id % 8)) == 0)
+        pos = run + length;
+        if (length >= number && length < best_length)
         {
-            if (found_number == 0)
-                start_frame_id = id;
-
-            found_number++;
-            if (found_number == number)
+            best = run;
+            best_length = length;
+            if (length == number)
                 break;
         }
+    }
+    g_stats.scanned_frames += (run >= 0) ? pos - first : (uint32_t)(end - first);
+    return best;
+}
+
+// Finds and reserves a run of number frames in [first, end) with the policy of falloc().
+// Returns its first frame or -1. Called with g_lock held.
+static int32_t alloc_run(tFrameId first, tFrameId end, tFrameId *rover, tFrameId number)
+{
+    int32_t start_frame_id = -1;
+    do
+    {
+        if (g_ram->alloc_policy == RAM_ALLOC_NEXT_FIT)
+            start_frame_id = find_next_fit(first, end, *rover, number);
+        else if (g_ram->alloc_policy == RAM_ALLOC_BEST_FIT)
+            start_frame_id = find_best_fit(first, end, number);
         else
+            start_frame_id = find_first_fit(first, end, number);
+
+        if (start_frame_id < 0)
+            return -1;
+    } while (mark_used(start_frame_id, number) != 0);
+
+    *rover = (start_frame_id + number < end) ? start_frame_id + number : first;
+    return start_frame_id;
+}
+
+// Reserves up to number free frames in [first, end) in ascending order. Called with g_lock held.
+static tFrameId take_frames(tFrameId *frame_ids, tFrameId number, tFrameId first, tFrameId end)
+{
+    tFrameId found_number = 0;
+    int32_t id = first;
+    while (found_number < number && (id = bitmap_summary_find_clear_run(BITMAP, SUMMARY, end, id, 1)) >= 0)
+    {
+        if (mark_used(id, 1) == 0)
+            frame_ids[found_number++] = id;
+    }
+    return found_number;
+}
+
+static void magazine_lock(tMagazine *mag)
+{
+    while (atomic_flag_test_and_set_explicit(&mag->busy, memory_order_acquire))
+        ;
+}
+
+static void magazine_unlock(tMagazine *mag)
+{
+    atomic_flag_clear_explicit(&mag->busy, memory_order_release);
+}
+
+// Returns the frames of the magazine to the bitmap. Called with the magazine locked.
+static void magazine_flush(tMagazine *mag, uint8_t number)
+{
+    pthread_mutex_lock(&g_lock);
+    for (uint8_t id = 0; id < number; id++)
+    {
+        mark_free(mag->frames[id], 1);
+    }
+    pthread_mutex_unlock(&g_lock);
+    mag->count -= number;
+    memmove(mag->frames, mag->frames + number, mag->count * sizeof(tFrameId));
+}
+
+static void release_magazine(void *value)
+{
+    tMagazine *mag = value;
+    magazine_lock(mag);
+    if (g_ram != NULL)
+        magazine_flush(mag, mag->count);
+    mag->count = 0;
+    magazine_unlock(mag);
+    pthread_mutex_lock(&g_lock);
+    mag->used = 0;
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void create_magazine_key()
+{
+    pthread_key_create(&g_magazine_key, release_magazine);
+}
+
+// Returns the magazine of the calling thread, claiming a free slot on first use. nullptr if all slots are taken.
+static tMagazine *own_magazine()
+{
+    if (g_own_magazine != NULL)
+        return g_own_magazine;
+
+    pthread_once(&g_magazine_once, create_magazine_key);
+    pthread_mutex_lock(&g_lock);
+    for (uint8_t slot = 0; slot < RAM_MAGAZINES && g_own_magazine == NULL; slot++)
+    {
+        if (g_magazines[slot].used == 0)
         {
-            found_number = 0;
+            g_magazines[slot].used = 1;
+            g_own_magazine = &g_magazines[slot];
         }
     }
+    pthread_mutex_unlock(&g_lock);
+    if (g_own_magazine != NULL)
+        pthread_setspecific(g_magazine_key, g_own_magazine);
+    return g_own_magazine;
+}
 
-    if (found_number != number)
-    {
+static int magazine_alloc(tFrameId *frame_id)
+{
+    tMagazine *mag = own_magazine();
+    if (mag == NULL)
         return -1;
+
+    magazine_lock(mag);
+    if (mag->count == 0)
+    {
+        tFrameId batch[RAM_MAGAZINE_BATCH];
+        pthread_mutex_lock(&g_lock);
+        const tFrameId got = take_frames(batch, RAM_MAGAZINE_BATCH, 0, NUM_RAM_FRAMES);
+        g_stats.magazine_refills++;
+        pthread_mutex_unlock(&g_lock);
+        // The lowest frame is handed out first.
+        for (tFrameId id = 0; id < got; id++)
+        {
+            mag->frames[id] = batch[got - 1 - id];
+        }
+        mag->count = got;
+    }
+    int ret = -1;
+    if (mag->count > 0)
+    {
+        *frame_id = mag->frames[--mag->count];
+        atomic_fetch_add_explicit(&mag->hits, 1, memory_order_relaxed);
+        ret = 0;
     }
+    magazine_unlock(mag);
+    return ret;
+}
 
-    for (uint16_t id = start_frame_id; id < start_frame_id + found_number; id++)
+static int magazine_free(tFrameId frame_id)
+{
+    tMagazine *mag = own_magazine();
+    if (mag == NULL)
+        return -1;
+
+    magazine_lock(mag);
+    if (mag->count == RAM_MAGAZINE_SIZE)
+        magazine_flush(mag, RAM_MAGAZINE_BATCH);  // the least recently freed frames
+    mag->frames[mag->count++] = frame_id;
+    magazine_unlock(mag);
+    return 0;
+}
+
+// Claims one frame without g_lock, searching from where the previous claim of the thread succeeded.
+static int lock_free_alloc(tFrameId *frame_id)
+{
+    const tFrameId frames = NUM_RAM_FRAMES;
+    const tFrameId hint = (g_own_hint < frames) ? g_own_hint : 0;
+    int32_t id = bitmap_atomic_claim(BITMAP, frames, hint);
+    if (id < 0 && hint != 0)
+        id = bitmap_atomic_claim(BITMAP, hint, 0);
+    if (id < 0)
+        return -1;
+
+    g_own_hint = id;
+    atomic_fetch_add_explicit(&g_lock_free_allocations, 1, memory_order_relaxed);
+    *frame_id = id;
+    return 0;
+}
+
+static int alloc_locked(tFrameId *frame_id, tFrameId number, tFrameId first, tFrameId end, tFrameId *rover);
+
+int falloc(tFrameId *frame_id, tFrameId number)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (number == 0 || frame_id == NULL)
+        return -1;
+
+    if (number == 1 && g_magazines_enabled && magazine_alloc(frame_id) == 0)
+        return 0;
+
+    if (number == 1 && g_lock_free && lock_free_alloc(frame_id) == 0)
+        return 0;
+
+    return alloc_locked(frame_id, number, 0, NUM_RAM_FRAMES, &g_ram->rover);
+}
+
+int falloc_node(tFrameId *frame_id, tFrameId number, uint8_t node)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (number == 0 || frame_id == NULL || node >= g_node_count)
+        return -2;
+
+    if (g_node_count == 1)
+        return falloc(frame_id, number);
+
+    tRamNode *ram_node = &g_nodes[node];
+    return alloc_locked(frame_id, number, ram_node->first, ram_node->first + ram_node->frames, &ram_node->rover);
+}
+
+// Reserves a run of frames in [first, end) under g_lock, see falloc().
+static int alloc_locked(tFrameId *frame_id, tFrameId number, tFrameId first, tFrameId end, tFrameId *rover)
+{
+    pthread_mutex_lock(&g_lock);
+    int32_t start_frame_id = alloc_run(first, end, rover, number);
+    pthread_mutex_unlock(&g_lock);
+    if (start_frame_id < 0 && g_magazines_enabled && ram_cached_frames() != 0)
     {
-        g_ram->bitmap[id / 8] |= (0x01 << (id % 8));
+        // The free frames may sit in the magazines.
+        ram_drain_magazines();
+        pthread_mutex_lock(&g_lock);
+        start_frame_id = alloc_run(first, end, rover, number);
+        pthread_mutex_unlock(&g_lock);
     }
 
+    pthread_mutex_lock(&g_lock);
+    if (start_frame_id < 0)
+        g_stats.failures++;
+    else
+        g_stats.allocations++;
+    pthread_mutex_unlock(&g_lock);
+    if (start_frame_id < 0)
+        return -1;
+
     *frame_id = start_frame_id;
     return 0;
 }
 
-void ffree(uint16_t frame_id, uint16_t number)
+int falloc_at(tFrameId frame_id, tFrameId number)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (number == 0 || (uint32_t)frame_id + number > NUM_RAM_FRAMES)
+        return -2;
+
+    int ret = -1;
+    pthread_mutex_lock(&g_lock);
+    if (bitmap_find_clear_run(BITMAP, frame_id + number, frame_id, number) == (int32_t)frame_id &&
+        mark_used(frame_id, number) == 0)
+    {
+        ret = 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return ret;
+}
+
+int falloc_scattered(tFrameId *frame_ids, tFrameId number)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (number == 0 || frame_ids == NULL)
+        return -2;
+
+    pthread_mutex_lock(&g_lock);
+    const tFrameId found_number = take_frames(frame_ids, number, 0, NUM_RAM_FRAMES);
+    pthread_mutex_unlock(&g_lock);
+    return found_number;
+}
+
+int falloc_scattered_node(tFrameId *frame_ids, tFrameId number, uint8_t node)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (number == 0 || frame_ids == NULL || node >= g_node_count)
+        return -2;
+
+    const tRamNode *ram_node = &g_nodes[node];
+    pthread_mutex_lock(&g_lock);
+    const tFrameId found_number = take_frames(frame_ids, number, ram_node->first, ram_node->first + ram_node->frames);
+    pthread_mutex_unlock(&g_lock);
+    return found_number;
+}
+
+void ffree(tFrameId frame_id, tFrameId number)
 {
     if (g_ram == NULL)
         return;
 
-    uint16_t end_frame_id = frame_id + number;
+    uint32_t end_frame_id = (uint32_t)frame_id + number;
     if (end_frame_id > NUM_RAM_FRAMES)
         return;
 
-    for (; frame_id < end_frame_id; frame_id++)
+    if (number == 1 && g_magazines_enabled && magazine_free(frame_id) == 0)
+        return;
+
+    if (g_lock_free)
     {
-        g_ram->bitmap[frame_id / 8] &= ~(0x01 << (frame_id % 8));
+        mark_free(frame_id, number);
+        return;
     }
+
+    pthread_mutex_lock(&g_lock);
+    mark_free(frame_id, number);
+    pthread_mutex_unlock(&g_lock);
+}
+
+tFrameId ram_free_frames()
+{
+    if (g_ram == NULL)
+        return 0;
+
+    pthread_mutex_lock(&g_lock);
+    const tFrameId free_frames = NUM_RAM_FRAMES - bitmap_count(BITMAP, NUM_RAM_FRAMES);
+    pthread_mutex_unlock(&g_lock);
+    return free_frames;
+}
+
+tFrameId ram_largest_free_run()
+{
+    if (g_ram == NULL)
+        return 0;
+
+    pthread_mutex_lock(&g_lock);
+    const tFrameId largest = bitmap_largest_clear_run(BITMAP, NUM_RAM_FRAMES);
+    pthread_mutex_unlock(&g_lock);
+    return largest;
+}
+
+int ram_set_magazines(uint8_t enabled)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (enabled == 0)
+        ram_drain_magazines();
+    g_magazines_enabled = (enabled != 0) ? 0x1 : 0x0;
+    return 0;
+}
+
+void ram_drain_magazines()
+{
+    for (uint8_t slot = 0; slot < RAM_MAGAZINES; slot++)
+    {
+        tMagazine *mag = &g_magazines[slot];
+        magazine_lock(mag);
+        if (g_ram != NULL && mag->count != 0)
+            magazine_flush(mag, mag->count);
+        magazine_unlock(mag);
+    }
+}
+
+int ram_set_nodes(uint8_t count, const uint8_t *weights)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    const tFrameId frames = NUM_RAM_FRAMES;
+    if (count == 0 || count > RAM_MAX_NODES || (count & (count - 1)) || count > frames)
+        return -2;
+
+    for (uint8_t node = 0; weights != NULL && node < count; node++)
+    {
+        if (weights[node] == 0)
+            return -2;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    for (uint8_t node = 0; node < count; node++)
+    {
+        g_nodes[node].first = node * (frames / count);
+        g_nodes[node].frames = frames / count;
+        g_nodes[node].rover = g_nodes[node].first;
+        g_nodes[node].weight = (weights != NULL) ? weights[node] : 1;
+    }
+    g_node_count = count;
+    pthread_mutex_unlock(&g_lock);
+    return 0;
+}
+
+uint8_t ram_node_count()
+{
+    return g_node_count;
+}
+
+const tRamNode *ram_get_node(uint8_t node)
+{
+    return (node < g_node_count) ? &g_nodes[node] : NULL;
+}
+
+int ram_frame_node(tFrameId frame_id)
+{
+    if (g_ram == NULL || frame_id >= NUM_RAM_FRAMES)
+        return -1;
+
+    return frame_id / g_nodes[0].frames;
+}
+
+tFrameId ram_node_free_frames(uint8_t node)
+{
+    if (g_ram == NULL || node >= g_node_count)
+        return 0;
+
+    const tRamNode *ram_node = &g_nodes[node];
+    pthread_mutex_lock(&g_lock);
+    const tFrameId used = bitmap_count(BITMAP, ram_node->first + ram_node->frames) - bitmap_count(BITMAP, ram_node->first);
+    pthread_mutex_unlock(&g_lock);
+    return ram_node->frames - used;
+}
+
+// Makes all RAM a single node.
+static void reset_nodes()
+{
+    g_nodes[0].first = 0;
+    g_nodes[0].frames = NUM_RAM_FRAMES;
+    g_nodes[0].rover = 0;
+    g_nodes[0].weight = 1;
+    g_node_count = 1;
+}
+
+int ram_set_lock_free(uint8_t enabled)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    pthread_mutex_lock(&g_lock);
+    const uint8_t lock_free = (enabled != 0) ? 0x1 : 0x0;
+    if (lock_free != g_lock_free && g_ram->summary != 0)
+    {
+        // A zeroed summary is valid for any bitmap, a full one has to be computed again.
+        const tFrameId frames = NUM_RAM_FRAMES;
+        uint8_t *summary = (uint8_t *)g_ram + g_ram->summary;
+        memset(summary, 0, BITMAP_SUMMARY_BYTES(frames));
+        if (!lock_free)
+            bitmap_summary_update(BITMAP, summary, frames, 0, frames);
+    }
+    g_lock_free = lock_free;
+    pthread_mutex_unlock(&g_lock);
+    return 0;
+}
+
+tFrameId ram_cached_frames()
+{
+    tFrameId cached = 0;
+    for (uint8_t slot = 0; slot < RAM_MAGAZINES; slot++)
+    {
+        tMagazine *mag = &g_magazines[slot];
+        magazine_lock(mag);
+        cached += mag->count;
+        magazine_unlock(mag);
+    }
+    return cached;
+}
+
+// Forgets the frames cached for a previous RAM.
+static void reset_magazines()
+{
+    g_magazines_enabled = 0;
+    for (uint8_t slot = 0; slot < RAM_MAGAZINES; slot++)
+    {
+        magazine_lock(&g_magazines[slot]);
+        g_magazines[slot].count = 0;
+        magazine_unlock(&g_magazines[slot]);
+    }
+}
+
+int ram_set_alloc_policy(uint8_t policy)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (policy > RAM_ALLOC_BEST_FIT)
+        return -2;
+
+    g_ram->alloc_policy = policy;
+    return 0;
+}
+
+uint8_t ram_fragmentation()
+{
+    const tFrameId free_frames = ram_free_frames();
+    if (free_frames == 0)
+        return 0;
+
+    return (uint8_t)(100 - (uint64_t)ram_largest_free_run() * 100 / free_frames);
+}
+
+const tRamStats *ram_get_stats()
+{
+    uint32_t hits = 0;
+    for (uint8_t slot = 0; slot < RAM_MAGAZINES; slot++)
+    {
+        hits += atomic_load_explicit(&g_magazines[slot].hits, memory_order_relaxed);
+    }
+    g_stats.magazine_hits = hits;
+    g_stats.lock_free_allocations = atomic_load_explicit(&g_lock_free_allocations, memory_order_relaxed);
+    return &g_stats;
+}
+
+void ram_reset_stats()
+{
+    pthread_mutex_lock(&g_lock);
+    memset(&g_stats, 0, sizeof(g_stats));
+    pthread_mutex_unlock(&g_lock);
+    atomic_store_explicit(&g_lock_free_allocations, 0, memory_order_relaxed);
+    for (uint8_t slot = 0; slot < RAM_MAGAZINES; slot++)
+    {
+        atomic_store_explicit(&g_magazines[slot].hits, 0, memory_order_relaxed);
+    }
+}
+
+int ram_set_watermarks(tFrameId low, tFrameId high)
+{
+    if (g_ram == NULL)
+        return -1;
+
+    if (low > high || high > NUM_RAM_FRAMES)
+        return -2;
+
+    g_ram->wmark_low = low;
+    g_ram->wmark_high = high;
+    return 0;
 }
 
 const tRam *get_ram_state()
@@ -0,0 +1,136 @@
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ram.h"
+#include "ram_image.h"
+#include "task.h"
+
+static const uint8_t g_magic[4] = {'O', 'S', 'P', 'R'};
+
+// Writes all bytes of data. Returns 0 or -1 on an I/O error.
+static int write_all(int fd, const uint8_t *data, uint32_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written <= 0)
+            return -1;
+
+        data += written;
+        size -= written;
+    }
+    return 0;
+}
+
+int ram_image_save(const char *path)
+{
+    const tRam *ram = get_ram_state();
+    if (ram == NULL || path == NULL)
+        return -1;
+
+    const tTaskMgr *mgr = get_task_mgr();
+    for (uint8_t slot = 0; mgr != NULL && slot < TASK_TABLE_SIZE; slot++)
+    {
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE && mgr->tasks[slot].pid != -1; id++)
+        {
+            if (mgr->tasks[slot].page_table[id].t_bit == 0x1)
+                return -3;
+        }
+    }
+
+    // Caches of threads are not part of the image, their frames would stay reserved in it.
+    ram_drain_magazines();
+
+    uint8_t header[RAM_IMAGE_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    tRamImageHeader *fields = (tRamImageHeader *)header;
+    memcpy(fields->magic, g_magic, sizeof(g_magic));
+    fields->version = RAM_IMAGE_VERSION;
+    fields->page_size = ram->page_size;
+    fields->size = ram->size;
+    fields->task_mgr = (mgr != NULL) ? (tRamSize)((const uint8_t *)mgr - (const uint8_t *)ram) : 0;
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -2;
+
+    int ret = 0;
+    if (write_all(fd, header, sizeof(header)) != 0 || write_all(fd, (const uint8_t *)ram, ram->size) != 0)
+        ret = -2;
+
+    if (close(fd) != 0)
+        ret = -2;
+    return ret;
+}
+
+int ram_image_attach(tRamImage *image, const char *path)
+{
+    if (image == NULL || path == NULL)
+        return -1;
+
+    image->map = NULL;
+    image->length = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -2;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return -2;
+    }
+    if ((size_t)st.st_size < RAM_IMAGE_HEADER_SIZE)
+    {
+        close(fd);
+        return -3;
+    }
+
+    uint8_t *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -2;
+
+    const tRamImageHeader *header = (const tRamImageHeader *)map;
+    if (memcmp(header->magic, g_magic, sizeof(g_magic)) != 0 || header->version != RAM_IMAGE_VERSION ||
+        (size_t)st.st_size < RAM_IMAGE_HEADER_SIZE + (size_t)header->size)
+    {
+        munmap(map, st.st_size);
+        return -3;
+    }
+
+    destroy_ram();
+    int frames = attach_ram(map + RAM_IMAGE_HEADER_SIZE, header->size, header->page_size);
+    if (frames < 0 || attach_taskMgr(header->task_mgr) != 0)
+    {
+        attach_taskMgr(0);
+        destroy_ram();
+        munmap(map, st.st_size);
+        return -3;
+    }
+
+    image->map = map;
+    image->length = st.st_size;
+    return frames;
+}
+
+void ram_image_detach(tRamImage *image)
+{
+    if (image == NULL || image->map == NULL)
+        return;
+
+    if (get_ram_state() == (const tRam *)(image->map + RAM_IMAGE_HEADER_SIZE))
+    {
+        if (get_task_mgr() != NULL)
+            destroy_taskMgr();
+        destroy_ram();
+    }
+    munmap(image->map, image->length);
+    image->map = NULL;
+    image->length = 0;
+}
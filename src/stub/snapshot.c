@@ -0,0 +1,147 @@
+#include <string.h>
+
+#include "pager.h"
+#include "ram.h"
+#include "snapshot.h"
+#include "task.h"
+#include "types.h"
+
+static const uint8_t g_magic[4] = {'O', 'S', 'P', 'S'};
+
+typedef struct tSnapshotHeader
+{
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t page_shift;
+    uint8_t max_frames;
+    uint8_t policy;
+    uint8_t pages;
+    uint8_t lock_limit;
+    uint8_t large_order;
+    uint8_t home_node;
+} tSnapshotHeader;
+
+int snapshot_task(int pid, const tSnapshotWriter *writer)
+{
+    const tRam *ram = get_ram_state();
+    const tTaskStruct *task = get_task_struct(pid);
+    if (ram == NULL || task == NULL)
+        return -1;
+
+    if (writer == NULL || writer->write == NULL)
+        return -2;
+
+    tSnapshotHeader header = {
+        .version = SNAPSHOT_VERSION,
+        .page_shift = __builtin_ctz(ram->page_size),
+        .max_frames = task->max_frames,
+        .policy = task->policy,
+        .pages = PAGE_TABLE_SIZE,
+        .lock_limit = task->lock_limit,
+        .large_order = task->large_order,
+        .home_node = task->home_node,
+    };
+    memcpy(header.magic, g_magic, sizeof(g_magic));
+    if (writer->write(writer->ctx, &header, sizeof(header)) != 0)
+        return -3;
+
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        const tPageTableEntry *entry = &task->page_table[id];
+        uint8_t flags = (entry->r ? SNAPSHOT_PAGE_R : 0) | (entry->w ? SNAPSHOT_PAGE_W : 0) |
+                        (entry->x ? SNAPSHOT_PAGE_X : 0) | (entry->l_bit ? SNAPSHOT_PAGE_LOCKED : 0);
+        // Clean pages match the backing store, only modified ones carry their content.
+        if (entry->p_bit == 0x1 && entry->m_bit == 0x1)
+            flags |= SNAPSHOT_PAGE_DATA;
+
+        if (writer->write(writer->ctx, &flags, sizeof(flags)) != 0)
+            return -3;
+
+        if (flags & SNAPSHOT_PAGE_DATA)
+        {
+            const uint8_t *frame = (const uint8_t *)ram + (entry->frame_id * ram->page_size);
+            if (writer->write(writer->ctx, frame, ram->page_size) != 0)
+                return -3;
+        }
+    }
+    return 0;
+}
+
+int restore_task(const tSnapshotReader *reader, const tBackingOps *backing, void *store)
+{
+    if (reader == NULL || reader->read == NULL || backing == NULL || store == NULL)
+        return -2;
+
+    const tRam *ram = get_ram_state();
+    if (ram == NULL || get_task_mgr() == NULL)
+        return -3;
+
+    tSnapshotHeader header;
+    if (reader->read(reader->ctx, &header, sizeof(header)) != 0)
+        return -4;
+
+    if (memcmp(header.magic, g_magic, sizeof(g_magic)) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.page_shift != __builtin_ctz(ram->page_size) || header.pages != PAGE_TABLE_SIZE)
+        return -4;
+
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    memset(page_table, 0, sizeof(page_table));
+    int pid = create_task_backed(page_table, header.max_frames, backing, store);
+    if (pid < 0)
+        return pid;
+
+    tTaskStruct *task = get_task_struct(pid);
+    if (set_replacement_policy(pid, header.policy) != 0 || set_lock_limit(pid, header.lock_limit) != 0 ||
+        set_large_pages(pid, header.large_order) != 0 || set_home_node(pid, header.home_node) != 0)
+    {
+        destroy_task(pid);
+        return -4;
+    }
+
+    tPageMask locked = 0;
+    uint8_t page[RAM_MAX_PAGE_SIZE];
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        uint8_t flags = 0;
+        if (reader->read(reader->ctx, &flags, sizeof(flags)) != 0)
+        {
+            destroy_task(pid);
+            return -4;
+        }
+
+        tPageTableEntry *entry = &task->page_table[id];
+        entry->r = (flags & SNAPSHOT_PAGE_R) ? 0x1 : 0x0;
+        entry->w = (flags & SNAPSHOT_PAGE_W) ? 0x1 : 0x0;
+        entry->x = (flags & SNAPSHOT_PAGE_X) ? 0x1 : 0x0;
+        if (flags & SNAPSHOT_PAGE_LOCKED)
+            locked |= PAGE_MASK_BIT(id);
+        if ((flags & SNAPSHOT_PAGE_DATA) == 0)
+            continue;
+
+        if (reader->read(reader->ctx, page, ram->page_size) != 0)
+        {
+            destroy_task(pid);
+            return -4;
+        }
+        if (backing->write_page(store, id, page, ram->page_size) != 0)
+        {
+            destroy_task(pid);
+            return -5;
+        }
+    }
+
+    // Locked pages are loaded right away, once their content is in the store.
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        if ((locked & PAGE_MASK_BIT(id)) == 0)
+            continue;
+
+        const int result = lock_pages(pid, (tVirtAddr)id * ram->page_size, ram->page_size);
+        if (result != 0)
+        {
+            destroy_task(pid);
+            return (result == -3) ? -1 : (result == -5) ? -5 : -4;
+        }
+    }
+    return pid;
+}
@@ -1,11 +1,14 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "cgroup.h"
 #include "pager.h"
 #include "ram.h"
 #include "task.h"
 
 static tTaskMgr *g_task_mgr = NULL;
+static tTaskBacking g_backing[TASK_TABLE_SIZE];  // Backing stores of the task slots.
+static uint8_t g_remote_hits[TASK_TABLE_SIZE][PAGE_TABLE_SIZE];  // Remote access counters of the task slots.
 
 #define MAX_NUM_TASKS sizeof(g_task_mgr->tasks)/sizeof(tTaskStruct)
 #define NUM_FRAMES(bytes) ((bytes) / ram->page_size) + (((bytes) % ram->page_size) ? 1 : 0)
@@ -16,7 +19,7 @@ int init_taskMgr()
     if (ram == NULL)
         return -1;
 
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, NUM_FRAMES(sizeof(tTaskMgr)));
     if (ret != 0)
         return -1;
@@ -26,7 +29,9 @@ int init_taskMgr()
     for (uint8_t id = 0; id < 8; id++)
     {
         g_task_mgr->tasks[id].pid = -1;
+        g_backing[id] = (tTaskBacking){&unbound_backing_ops, NULL};
     }
+    cgroup_reset();
 
     return 0;
 }
@@ -37,18 +42,63 @@ void destroy_taskMgr()
     if (ram == NULL)
         return;
 
-    uint16_t frame_id = ((uint8_t *)g_task_mgr - (uint8_t *)ram) / ram->page_size;
+    tFrameId frame_id = ((uint8_t *)g_task_mgr - (uint8_t *)ram) / ram->page_size;
 
     ffree(frame_id, NUM_FRAMES(sizeof(tTaskMgr)));
     g_task_mgr = NULL;
+    cgroup_reset();
+}
+
+int attach_taskMgr(tRamSize offset)
+{
+    if (offset == 0)
+    {
+        g_task_mgr = NULL;
+        cgroup_reset();
+        return 0;
+    }
+
+    const tRam *ram = get_ram_state();
+    if (ram == NULL || offset < sizeof(tRam) || (uint32_t)offset + sizeof(tTaskMgr) > ram->size)
+        return -1;
+
+    g_task_mgr = (tTaskMgr *)((uint8_t *)ram + offset);
+    for (uint8_t id = 0; id < MAX_NUM_TASKS; id++)
+    {
+        g_backing[id] = (tTaskBacking){&unbound_backing_ops, NULL};
+    }
+    memset(g_remote_hits, 0, sizeof(g_remote_hits));
+    cgroup_reset();
+    // The groups live in host memory, charge the frames the tasks hold in RAM to the root group again.
+    for (uint8_t id = 0; id < MAX_NUM_TASKS; id++)
+    {
+        const tTaskStruct *task = &(g_task_mgr->tasks[id]);
+        if (task->pid == -1)
+            continue;
+
+        tFrameId frames = 0;
+        for (uint8_t page_id = 0; page_id < PAGE_TABLE_SIZE; page_id++)
+        {
+            if (task->page_table[page_id].p_bit == 0x1 || task->page_table[page_id].t_bit == 0x1)
+                frames++;
+        }
+        cgroup_charge(task->pid, frames);
+    }
+    return 0;
 }
 
 int create_task(const tPageTableEntry *page_table, uint8_t max_frames, void *address_space)
+{
+    return create_task_backed(page_table, max_frames, &memory_backing_ops, address_space);
+}
+
+int create_task_backed(const tPageTableEntry *page_table, uint8_t max_frames, const tBackingOps *backing,
+    void *store)
 {
     if (page_table == NULL)
         return -2;
 
-    if (address_space == NULL)
+    if (backing == NULL || store == NULL)
         return -2;
 
     if (g_task_mgr == NULL)
@@ -61,14 +111,34 @@ int create_task(const tPageTableEntry *page_table, uint8_t max_frames, void *add
         {
             task->max_frames = max_frames;
             task->pid = id;
-            task->address_space = address_space;
-            memcpy(&task->page_table, page_table, 8*sizeof(tPageTableEntry));
+            g_backing[id] = (tTaskBacking){backing, store};
+            memcpy(&task->page_table, page_table, sizeof(task->page_table));
+            memset(&task->ws, 0, sizeof(tWorkingSet));
+            memset(task->age, 0, sizeof(task->age));
+            task->policy = PAGER_POLICY_NRU;
+            task->large_order = 0;
+            task->home_node = 0;
+            task->lock_limit = PAGER_LOCK_LIMIT;
+            memset(g_remote_hits[id], 0, sizeof(g_remote_hits[id]));
             return id;
         }
     }
     return -1;  
 }
 
+int task_set_backing(int pid, const tBackingOps *backing, void *store)
+{
+    tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    if (backing == NULL || store == NULL)
+        return -2;
+
+    g_backing[task - g_task_mgr->tasks] = (tTaskBacking){backing, store};
+    return 0;
+}
+
 int destroy_task(int pid)
 {
     const tRam *ram = get_ram_state();
@@ -84,14 +154,16 @@ int destroy_task(int pid)
 
     for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
     {
-        if (task->page_table[id].p_bit == 0x1)
+        if (task->page_table[id].p_bit == 0x1 || task->page_table[id].t_bit == 0x1)
         {
             ffree(task->page_table[id].frame_id, 1);
         }
     }
+    cgroup_exit(pid);
 
     memset(task, 0, sizeof(tTaskStruct));
     task->pid = -1;
+    g_backing[task - g_task_mgr->tasks] = (tTaskBacking){&unbound_backing_ops, NULL};
     return 0;
 }
 
@@ -100,9 +172,26 @@ const tTaskMgr *get_task_mgr()
     return g_task_mgr;
 }
 
+const tTaskBacking *get_task_backing(const tTaskStruct *task)
+{
+    if (g_task_mgr == NULL || task < g_task_mgr->tasks || task >= g_task_mgr->tasks + MAX_NUM_TASKS)
+        return NULL;
+
+    return &g_backing[task - g_task_mgr->tasks];
+}
+
+uint8_t *get_task_remote_hits(const tTaskStruct *task)
+{
+    if (g_task_mgr == NULL || task < g_task_mgr->tasks || task >= g_task_mgr->tasks + MAX_NUM_TASKS)
+        return NULL;
+
+    return g_remote_hits[task - g_task_mgr->tasks];
+}
+
 tTaskStruct *get_task_struct(int pid)
 {
-    if (g_task_mgr == NULL)
+    // Free slots hold pid -1.
+    if (g_task_mgr == NULL || pid < 0)
         return NULL;
 
     for (uint8_t id = 0; id < MAX_NUM_TASKS; id++)
@@ -115,3 +204,11 @@ tTaskStruct *get_task_struct(int pid)
     }
     return NULL;
 }
+
+tTaskStruct *get_task_slot(uint8_t slot)
+{
+    if (g_task_mgr == NULL || slot >= MAX_NUM_TASKS || g_task_mgr->tasks[slot].pid == -1)
+        return NULL;
+
+    return &g_task_mgr->tasks[slot];
+}
@@ -0,0 +1,108 @@
+#include <stddef.h>
+
+#include "pager.h"
+#include "pte.h"
+#include "task.h"
+#include "wss.h"
+
+static void wss_tune(tTaskStruct *task)
+{
+    tWorkingSet *ws = &task->ws;
+    if (ws->pff_high == 0)
+        return;
+
+    uint8_t limit = (task->max_frames != 0) ? task->max_frames : PAGE_TABLE_SIZE;
+    if (ws->faults > ws->pff_high)
+    {
+        limit = (limit + 1 > ws->estimate) ? limit + 1 : ws->estimate;
+        if (limit > PAGE_TABLE_SIZE)
+            limit = PAGE_TABLE_SIZE;
+    }
+    else if (ws->faults < ws->pff_low)
+    {
+        // Locked pages stay present, one more frame is left for the faults of the other pages.
+        tPteScan scan;
+        pte_scan(task->page_table, &scan);
+        const uint8_t locked = PAGE_MASK_COUNT(scan.locked) + 1;
+        uint8_t floor = (ws->estimate != 0) ? ws->estimate : 1;
+        floor = (floor > locked) ? floor : locked;
+        if (limit > floor)
+            limit--;
+    }
+    task->max_frames = limit;
+}
+
+void wss_sample(struct tTaskStruct *task)
+{
+    tWorkingSet *ws = &task->ws;
+    for (uint8_t page_id = 0; page_id < PAGE_TABLE_SIZE; page_id++)
+    {
+        tPageTableEntry *entry = &task->page_table[page_id];
+        if (entry->p_bit == 0x1 && entry->r_bit == 0x1)
+        {
+            ws->history[ws->head] |= PAGE_MASK_BIT(page_id);
+            entry->r_bit = 0x0;
+        }
+    }
+
+    tPageMask window = 0;
+    for (uint8_t slot = 0; slot < WSS_WINDOW; slot++)
+    {
+        window |= ws->history[slot];
+    }
+    ws->estimate = PAGE_MASK_COUNT(window);
+
+    wss_tune(task);
+    ws->faults = 0;
+    ws->head = (ws->head + 1) % WSS_WINDOW;
+    ws->history[ws->head] = 0;
+}
+
+int wss_tick()
+{
+    const tTaskMgr *mgr = get_task_mgr();
+    if (mgr == NULL)
+        return -1;
+
+    for (uint8_t id = 0; id < TASK_TABLE_SIZE; id++)
+    {
+        tTaskStruct *task = get_task_slot(id);
+        if (task == NULL)
+            continue;
+
+        pager_age(task);
+        wss_sample(task);
+    }
+    return 0;
+}
+
+int wss_set_tuning(int pid, uint8_t pff_low, uint8_t pff_high)
+{
+    tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    if (pff_low > pff_high)
+        return -2;
+
+    task->ws.pff_low = pff_low;
+    task->ws.pff_high = pff_high;
+    return 0;
+}
+
+int wss_get_estimate(int pid)
+{
+    const tTaskStruct *task = get_task_struct(pid);
+    if (task == NULL)
+        return -1;
+
+    return task->ws.estimate;
+}
+
+void wss_on_fault(struct tTaskStruct *task, uint8_t page_id, tPageMask referenced)
+{
+    tWorkingSet *ws = &task->ws;
+    ws->history[ws->head] |= referenced | PAGE_MASK_BIT(page_id);
+    if (ws->faults < UINT8_MAX)
+        ws->faults++;
+}
@@ -0,0 +1,224 @@
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "test_ram.h"
+
+extern "C" {
+#include "aio.h"
+#include "backing.h"
+#include "pager.h"
+#include "task.h"
+}
+
+TEST(AioTest_NoEngine, CallsFail)
+{
+    uint32_t tag = 0;
+    int result = 0;
+    tAioRead read = {};
+    EXPECT_EQ(aio_ready(), 0);
+    EXPECT_EQ(aio_submit(&read), -1);
+    EXPECT_EQ(aio_reap(&tag, &result, 1, 0), -1);
+    EXPECT_EQ(pager_complete(0), -1);
+}
+
+TEST(AioTest_NoEngine, InitTwiceFails)
+{
+    int backend = aio_init(AIO_AUTO);
+    ASSERT_GE(backend, 0);
+    EXPECT_EQ(aio_init(AIO_AUTO), -1);
+    aio_destroy();
+}
+
+class AsyncFaultTest : public RamTestBase, public ::testing::WithParamInterface<uint8_t>
+{
+  protected:
+    void SetUp() override
+    {
+        if (aio_init(GetParam()) != GetParam())
+            GTEST_SKIP() << "Backend not available";
+
+        ASSERT_EQ(init_taskMgr(), 0);
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        ASSERT_EQ(file_backing_open(&file, path, PAGE_SIZE * PAGE_TABLE_SIZE), 0);
+
+        memset(page_table, 0, sizeof(page_table));
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            page_table[id].r = 0x1;
+            memset(address_space + PAGE_SIZE * id, 0x40 + id, PAGE_SIZE);
+            memset(file.map + PAGE_SIZE * id, 0x60 + id, PAGE_SIZE);
+        }
+    }
+
+    void TearDown() override
+    {
+        aio_destroy();
+        destroy_taskMgr();
+        file_backing_close(&file);
+        unlink(path);
+    }
+
+    void CheckFrame(const tTaskStruct *task, uint8_t page_id, uint8_t value)
+    {
+        ASSERT_EQ(task->page_table[page_id].p_bit, 0x1);
+        ASSERT_EQ(task->page_table[page_id].t_bit, 0x0);
+        const uint8_t *frame = ram + task->page_table[page_id].frame_id * PAGE_SIZE;
+        for (uint16_t pos = 0; pos < PAGE_SIZE; pos++)
+        {
+            ASSERT_EQ(frame[pos], value) << "Expected page content loaded into the frame";
+        }
+    }
+
+    char path[32] = "/tmp/ospager_XXXXXX";
+    tFileBacking file = {-1, nullptr, 0};
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    uint8_t address_space[PAGE_SIZE * PAGE_TABLE_SIZE];
+};
+
+TEST_P(AsyncFaultTest, PageInTransitUntilCompleted)
+{
+    int pid = create_task(page_table, 0, address_space);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    ASSERT_EQ(page_fault_async(pid, PAGE_SIZE * 3), 0);
+    EXPECT_EQ(task->page_table[3].t_bit, 0x1);
+    EXPECT_EQ(task->page_table[3].p_bit, 0x0);
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 3), -6) << "Expected page in transit";
+    EXPECT_EQ(page_fault_async(pid, PAGE_SIZE * 3), -6) << "Expected page in transit";
+
+    int done = 0;
+    while (done == 0)
+    {
+        done = pager_complete(1);
+    }
+    EXPECT_EQ(done, 1);
+    CheckFrame(task, 3, 0x43);
+    EXPECT_EQ(pager_complete(0), 0);
+}
+
+TEST_P(AsyncFaultTest, FaultsOfSeveralTasksOverlap)
+{
+    int pids[3];
+    for (int &pid : pids)
+    {
+        pid = create_task_backed(page_table, 0, &file_backing_ops, &file);
+        ASSERT_GE(pid, 0);
+    }
+    for (uint8_t page_id = 0; page_id < 3; page_id++)
+    {
+        for (int pid : pids)
+        {
+            ASSERT_EQ(page_fault_async(pid, PAGE_SIZE * page_id), 0);
+        }
+    }
+
+    int done = 0;
+    while (done < 9)
+    {
+        int ret = pager_complete(1);
+        ASSERT_GE(ret, 0);
+        done += ret;
+    }
+    EXPECT_EQ(done, 9);
+    for (int pid : pids)
+    {
+        for (uint8_t page_id = 0; page_id < 3; page_id++)
+        {
+            CheckFrame(get_task_struct(pid), page_id, 0x60 + page_id);
+        }
+    }
+}
+
+TEST_P(AsyncFaultTest, InTransitPagesCountTowardsMaxFrames)
+{
+    int pid = create_task(page_table, 2, address_space);
+    ASSERT_GE(pid, 0);
+    ASSERT_EQ(page_fault_async(pid, PAGE_SIZE * 1), 0);
+    ASSERT_EQ(page_fault_async(pid, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(page_fault_async(pid, PAGE_SIZE * 3), -3) << "Expected no victim while all pages are in transit";
+    while (pager_complete(1) == 1)
+        ;
+}
+
+TEST_P(AsyncFaultTest, StoppedEngineKeepsResidentSet)
+{
+    int pid = create_task(page_table, 1, address_space);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    ASSERT_EQ(page_fault(pid, 0), 0);
+    task->page_table[0].m_bit = 0x1;
+    const tFrameId frame_id = task->page_table[0].frame_id;
+    const tFrameId free_frames = ram_free_frames();
+    pager_reset_stats();
+    aio_destroy();
+
+    EXPECT_EQ(page_fault_async(pid, PAGE_SIZE * 1), -7);
+    EXPECT_EQ(task->page_table[0].p_bit, 0x1) << "Expected no victim evicted for a fault that never started";
+    EXPECT_EQ(task->page_table[0].m_bit, 0x1);
+    EXPECT_EQ(task->page_table[0].frame_id, frame_id);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[1].t_bit, 0x0);
+    EXPECT_EQ(ram_free_frames(), free_frames);
+    EXPECT_EQ(pager_get_stats()->dirty_victims, 0u);
+}
+
+TEST_P(AsyncFaultTest, FailedReadReleasesFrame)
+{
+    file_backing_close(&file);
+    ASSERT_EQ(file_backing_open(&file, path, PAGE_SIZE), 0);
+    int pid = create_task_backed(page_table, 0, &file_backing_ops, &file);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    tFrameId free_frames = ram_free_frames();
+    ASSERT_EQ(page_fault_async(pid, PAGE_SIZE * 4), 0);
+    EXPECT_EQ(pager_complete(1), 1);
+    EXPECT_EQ(task->page_table[4].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[4].t_bit, 0x0);
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST_P(AsyncFaultTest, DestroyCompletesFaultsInTransit)
+{
+    int pid = create_task_backed(page_table, 0, &file_backing_ops, &file);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    const tFrameId free_frames = ram_free_frames();
+    ASSERT_EQ(page_fault_async(pid, PAGE_SIZE * 2), 0);
+    aio_destroy();
+
+    CheckFrame(task, 2, 0x62);
+    EXPECT_EQ(ram_free_frames(), free_frames - 1);
+    ASSERT_EQ(aio_init(GetParam()), GetParam());
+    EXPECT_EQ(pager_complete(0), 0) << "Expected no fault left in transit";
+
+    // The page is an ordinary present page again, it can be evicted and faulted.
+    task->max_frames = 1;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0);
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(ram_free_frames(), free_frames - 1) << "Expected no frame lost";
+}
+
+TEST_P(AsyncFaultTest, DestroyFailedReadReleasesFrame)
+{
+    file_backing_close(&file);
+    ASSERT_EQ(file_backing_open(&file, path, PAGE_SIZE), 0);
+    int pid = create_task_backed(page_table, 0, &file_backing_ops, &file);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    const tFrameId free_frames = ram_free_frames();
+    ASSERT_EQ(page_fault_async(pid, PAGE_SIZE * 4), 0);
+    aio_destroy();
+
+    EXPECT_EQ(task->page_table[4].t_bit, 0x0);
+    EXPECT_EQ(task->page_table[4].p_bit, 0x0);
+    EXPECT_EQ(ram_free_frames(), free_frames);
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 4), -5) << "Expected a new fault, not a page in transit";
+}
+
+INSTANTIATE_TEST_SUITE_P(Backend, AsyncFaultTest, ::testing::Values(AIO_URING, AIO_THREADS),
+    [](const ::testing::TestParamInfo<uint8_t> &info) { return info.param == AIO_URING ? "Uring" : "Threads"; });
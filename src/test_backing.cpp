@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "test_ram.h"
+
+extern "C" {
+#include "backing.h"
+#include "mmu.h"
+#include "pager.h"
+#include "task.h"
+}
+
+class FileBackingTest : public RamTestBase
+{
+  protected:
+    static constexpr uint32_t FILE_SIZE = PAGE_SIZE * PAGE_TABLE_SIZE;
+
+    void SetUp() override
+    {
+        ASSERT_EQ(init_taskMgr(), 0);
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        ASSERT_EQ(file_backing_open(&file, path, FILE_SIZE), 0);
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            memset(file.map + PAGE_SIZE * id, 0x30 + id, PAGE_SIZE);
+        }
+
+        memset(page_table, 0, sizeof(page_table));
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            page_table[id].r = 0x1;
+            page_table[id].w = 0x1;
+        }
+    }
+
+    void TearDown() override
+    {
+        destroy_taskMgr();
+        set_page_table(nullptr);
+        file_backing_close(&file);
+        unlink(path);
+    }
+
+    char path[32] = "/tmp/ospager_XXXXXX";
+    tFileBacking file;
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+};
+
+TEST(FileBackingTest_Params, OpenInvalidParams)
+{
+    tFileBacking file;
+    EXPECT_EQ(file_backing_open(nullptr, "/tmp/x", 16), -1);
+    EXPECT_EQ(file_backing_open(&file, nullptr, 16), -1);
+    EXPECT_EQ(file_backing_open(&file, "/tmp/x", 0), -1);
+    EXPECT_EQ(file_backing_open(&file, "/nonexistent/dir/file", 16), -2);
+    EXPECT_EQ(file.map, nullptr);
+    EXPECT_EQ(file_backing_sync(&file), -1);
+}
+
+TEST_F(FileBackingTest, CreateTaskInvalidParams)
+{
+    EXPECT_EQ(create_task_backed(page_table, 2, nullptr, &file), -2);
+    EXPECT_EQ(create_task_backed(page_table, 2, &file_backing_ops, nullptr), -2);
+}
+
+TEST_F(FileBackingTest, PageFaultLoadsFromFile)
+{
+    int pid = create_task_backed(page_table, 2, &file_backing_ops, &file);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    const uint8_t *frame = ram + task->page_table[3].frame_id * PAGE_SIZE;
+    EXPECT_EQ(memcmp(frame, file.map + PAGE_SIZE * 3, PAGE_SIZE), 0) << "Expected page content loaded from file";
+}
+
+TEST_F(FileBackingTest, EvictedPageWrittenToFileAndPersists)
+{
+    int pid = create_task_backed(page_table, 1, &file_backing_ops, &file);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    set_page_table(task->page_table);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    ASSERT_EQ(store_data(PAGE_SIZE * 2 + 7, 0x99), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 5), 0);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0);
+    EXPECT_EQ(file.map[PAGE_SIZE * 2 + 7], 0x99) << "Expected evicted modified page written to file";
+
+    ASSERT_EQ(file_backing_sync(&file), 0);
+    file_backing_close(&file);
+    EXPECT_EQ(file.map, nullptr);
+    ASSERT_EQ(file_backing_open(&file, path, FILE_SIZE), 0);
+    EXPECT_EQ(file.map[PAGE_SIZE * 2 + 7], 0x99) << "Expected content to survive reopening the file";
+}
+
+TEST_F(FileBackingTest, LargeFileNotTruncated)
+{
+    file_backing_close(&file);
+    const off_t large = (off_t)1 << 32 | PAGE_SIZE;  // the low 32 bits are smaller than FILE_SIZE
+    if (truncate(path, large) != 0)
+        GTEST_SKIP() << "File system cannot hold the file";
+
+    ASSERT_EQ(file_backing_open(&file, path, FILE_SIZE), 0);
+    struct stat st;
+    ASSERT_EQ(stat(path, &st), 0);
+    EXPECT_EQ(st.st_size, large) << "Expected the file not to shrink";
+}
+
+TEST_F(FileBackingTest, PageOutsideOfFileFails)
+{
+    file_backing_close(&file);
+    ASSERT_EQ(file_backing_open(&file, path, PAGE_SIZE * 2), 0);
+    int pid = create_task_backed(page_table, 2, &file_backing_ops, &file);
+    ASSERT_GE(pid, 0);
+    tTaskStruct *task = get_task_struct(pid);
+    tFrameId free_frames = ram_free_frames();
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 4), -5);
+    EXPECT_EQ(task->page_table[4].p_bit, 0x0);
+    EXPECT_EQ(ram_free_frames(), free_frames) << "Expected frame released after failed read";
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+}
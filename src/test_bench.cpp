@@ -0,0 +1,1052 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "debug.h"
+#include "test_ram.h"
+
+extern "C" {
+#include "aio.h"
+#include "backing.h"
+#include "bitmap.h"
+#include "cgroup.h"
+#include "mmu.h"
+#include "pager.h"
+#include "pte.h"
+#include "ram_image.h"
+#include "task.h"
+}
+
+// Replays page access traces against the pager and compares the outcome of different configurations.
+class Bench : public RamTestBase
+{
+  protected:
+    static constexpr uint32_t TRACE_LENGTH = 20000;
+
+    void SetUp() override
+    {
+        ASSERT_EQ(init_taskMgr(), 0);
+        memset(page_table, 0, sizeof(page_table));
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            page_table[id].r = 0x1;
+            page_table[id].w = 0x1;
+        }
+    }
+
+    void TearDown() override
+    {
+        destroy_taskMgr();
+        set_page_table(nullptr);
+    }
+
+    // Runs the trace in a new task, every fourth access is a store. Returns number of page faults.
+    // With tick_interval set, the pager runs in clock mode and ticks after every tick_interval accesses.
+    // The task takes its frames from home_node first, see set_home_node().
+    uint32_t Replay(const std::vector<uint8_t> &trace, uint8_t max_frames, uint8_t policy, uint32_t tick_interval = 0,
+        uint8_t home_node = 0)
+    {
+        pager_set_clock(tick_interval != 0);
+        pager_reset_stats();
+        fault_ns = 0;
+        int pid = create_task(page_table, max_frames, address_space);
+        EXPECT_GE(pid, 0);
+        EXPECT_EQ(set_replacement_policy(pid, policy), 0);
+        EXPECT_EQ(set_home_node(pid, home_node), 0);
+        tTaskStruct *task = get_task_struct(pid);
+        set_page_table(task->page_table);
+
+        uint32_t faults = 0;
+        for (uint32_t step = 0; step < trace.size(); step++)
+        {
+            const uint16_t address = trace[step] * PAGE_SIZE + (step % PAGE_SIZE);
+            uint8_t data = 0;
+            int ret = (step % 4 == 3) ? store_data(address, data) : load_data(address, &data);
+            if (ret == -1)
+            {
+                faults++;
+                auto start = std::chrono::steady_clock::now();
+                EXPECT_EQ(page_fault(pid, address), 0);
+                fault_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                ret = (step % 4 == 3) ? store_data(address, data) : load_data(address, &data);
+            }
+            EXPECT_EQ(ret, 0);
+            if (tick_interval != 0 && step % tick_interval == tick_interval - 1)
+            {
+                EXPECT_EQ(pager_tick(), 0);
+            }
+        }
+        destroy_task(pid);
+        pager_set_clock(0);
+        return faults;
+    }
+
+    static std::vector<uint8_t> LoopTrace(uint8_t pages)
+    {
+        std::vector<uint8_t> trace(TRACE_LENGTH);
+        for (uint32_t step = 0; step < TRACE_LENGTH; step++)
+        {
+            trace[step] = step % pages;
+        }
+        return trace;
+    }
+
+    static std::vector<uint8_t> ZipfTrace(double skew)
+    {
+        std::vector<double> weights(PAGE_TABLE_SIZE);
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            weights[id] = 1.0 / std::pow(id + 1, skew);
+        }
+        std::mt19937 gen(42);
+        std::discrete_distribution<int> dist(weights.begin(), weights.end());
+        std::vector<uint8_t> trace(TRACE_LENGTH);
+        for (auto &page : trace)
+        {
+            page = dist(gen);
+        }
+        return trace;
+    }
+
+    uint64_t fault_ns;  // Time spent in page_fault() by the last Replay().
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    uint8_t address_space[PAGE_SIZE * PAGE_TABLE_SIZE];
+};
+
+TEST_F(Bench, PolicyFaultRateLoop)
+{
+    const auto trace = LoopTrace(5);
+    for (uint8_t frames = 2; frames <= 5; frames++)
+    {
+        uint32_t nru = Replay(trace, frames, PAGER_POLICY_NRU);
+        uint32_t aging = Replay(trace, frames, PAGER_POLICY_AGING);
+        dprintf("loop(5) frames %u: NRU %u faults, aging %u faults\n", frames, nru, aging);
+        EXPECT_GE(nru, 5u);
+        EXPECT_GE(aging, 5u);
+        if (frames == 5)
+        {
+            EXPECT_EQ(nru, 5u) << "Expected only compulsory faults when the loop fits";
+            EXPECT_EQ(aging, 5u) << "Expected only compulsory faults when the loop fits";
+        }
+    }
+}
+
+TEST_F(Bench, PolicyFaultRateZipf)
+{
+    const auto trace = ZipfTrace(1.0);
+    for (uint8_t frames = 2; frames < PAGE_TABLE_SIZE; frames++)
+    {
+        uint32_t nru = Replay(trace, frames, PAGER_POLICY_NRU);
+        uint32_t aging = Replay(trace, frames, PAGER_POLICY_AGING);
+        dprintf("zipf(1.0) frames %u: NRU %u faults, aging %u faults\n", frames, nru, aging);
+        EXPECT_LE(aging, nru) << "Expected aging to keep the hot pages at least as well as NRU";
+    }
+}
+
+TEST_F(Bench, ClockTickFaultRateZipf)
+{
+    const auto trace = ZipfTrace(1.0);
+    for (uint8_t frames = 2; frames < PAGE_TABLE_SIZE; frames++)
+    {
+        for (uint8_t policy : {PAGER_POLICY_NRU, PAGER_POLICY_AGING})
+        {
+            uint32_t faults = Replay(trace, frames, policy);
+            uint64_t ns = fault_ns;
+            uint32_t clock_faults = Replay(trace, frames, policy, 16);
+            dprintf("zipf(1.0) frames %u policy %u: per fault %u faults %lu ns/fault, tick/16 %u faults %lu ns/fault\n",
+                frames, policy, faults, ns / faults, clock_faults, fault_ns / clock_faults);
+            EXPECT_GE(clock_faults, PAGE_TABLE_SIZE);
+        }
+    }
+}
+
+TEST_F(Bench, FlushDirtyVictimsZipf)
+{
+    const auto trace = ZipfTrace(1.0);
+    for (uint8_t frames = 2; frames < PAGE_TABLE_SIZE; frames++)
+    {
+        pager_set_flush_watermark(1);  // RAM never runs out here, so nothing is flushed
+        Replay(trace, frames, PAGER_POLICY_AGING, 16);
+        const tPagerStats lazy = *pager_get_stats();
+        pager_set_flush_watermark(0);
+        Replay(trace, frames, PAGER_POLICY_AGING, 16);
+        const tPagerStats eager = *pager_get_stats();
+        dprintf("zipf(1.0) frames %u: no flush %u clean/%u dirty victims, flush %u clean/%u dirty victims "
+                "(%u pages flushed)\n",
+            frames, lazy.clean_victims, lazy.dirty_victims, eager.clean_victims, eager.dirty_victims,
+            eager.flushed_pages);
+        EXPECT_EQ(lazy.flushed_pages, 0u);
+        EXPECT_LT(eager.dirty_victims, lazy.dirty_victims);
+    }
+}
+
+TEST_F(Bench, ReclaimDirectFaultsZipf)
+{
+    const auto trace = ZipfTrace(1.0);
+    // The task is not limited by max_frames, only 4 frames of RAM are left free
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, ram_free_frames() - 4), 0);
+    uint32_t baseline = 0;
+    for (uint16_t high : {0, 1, 2})
+    {
+        ASSERT_EQ(ram_set_watermarks(high ? 1 : 0, high), 0);
+        uint32_t faults = Replay(trace, 0, PAGER_POLICY_AGING, 4);
+        const tPagerStats stats = *pager_get_stats();
+        const uint64_t direct_ns = stats.direct_reclaims ? stats.direct_reclaim_ns / stats.direct_reclaims : 0;
+        dprintf("zipf(1.0) 4 free frames, watermarks %u/%u: %u faults, %u direct reclaims (%lu ns/fault), "
+                "%u reclaim scans, %u pages reclaimed\n",
+            high ? 1 : 0, high, faults, stats.direct_reclaims, direct_ns, stats.reclaim_scans, stats.reclaimed_pages);
+        if (high == 0)
+        {
+            EXPECT_EQ(stats.direct_reclaims + 4, faults);
+            baseline = stats.direct_reclaims;
+        }
+        else
+        {
+            EXPECT_LT(stats.direct_reclaims, baseline) << "Expected reclaim to leave free frames for faults";
+        }
+    }
+}
+
+TEST_F(Bench, AsyncPageInThroughput)
+{
+    constexpr uint32_t ROUNDS = 500;
+    char path[] = "/tmp/ospager_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    tFileBacking file;
+    ASSERT_EQ(file_backing_open(&file, path, PAGE_SIZE * PAGE_TABLE_SIZE), 0);
+
+    // Loads all pages of a file backed task ROUNDS times, with at most depth faults in transit
+    auto run = [&](uint8_t depth) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            int pid = create_task_backed(page_table, 0, &file_backing_ops, &file);
+            EXPECT_GE(pid, 0);
+            uint8_t in_transit = 0;
+            for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+            {
+                if (depth == 0)
+                {
+                    EXPECT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+                    continue;
+                }
+                while (in_transit >= depth)
+                    in_transit -= pager_complete(1);
+                EXPECT_EQ(page_fault_async(pid, PAGE_SIZE * id), 0);
+                in_transit++;
+            }
+            while (in_transit > 0)
+                in_transit -= pager_complete(1);
+            destroy_task(pid);
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return ns.count() / (ROUNDS * PAGE_TABLE_SIZE);
+    };
+
+    dprintf("page-in sync: %ld ns/page\n", run(0));
+    for (uint8_t backend : {AIO_URING, AIO_THREADS})
+    {
+        if (aio_init(backend) != backend)
+            continue;
+        for (uint8_t depth : {1, 4, 8})
+        {
+            dprintf("page-in %s depth %u: %ld ns/page\n", backend == AIO_URING ? "io_uring" : "threads", depth,
+                run(depth));
+        }
+        aio_destroy();
+    }
+    file_backing_close(&file);
+    unlink(path);
+}
+
+TEST_F(Bench, BatchPageInLatency)
+{
+    constexpr uint32_t ROUNDS = 2000;
+    constexpr uint8_t GROUP = PAGE_TABLE_SIZE / 2;
+
+    // Loads both halves of the page table ROUNDS times into a task with room for one half,
+    // so the second half evicts the first one
+    auto run = [&](uint8_t batched) {
+        pager_reset_stats();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            int pid = create_task(page_table, GROUP, address_space);
+            EXPECT_GE(pid, 0);
+            for (uint8_t first = 0; first < PAGE_TABLE_SIZE; first += GROUP)
+            {
+                tVirtAddr addrs[GROUP];
+                for (uint8_t id = 0; id < GROUP; id++)
+                {
+                    addrs[id] = PAGE_SIZE * (first + id);
+                }
+                if (batched)
+                {
+                    EXPECT_EQ(page_fault_batch(pid, addrs, GROUP), GROUP);
+                    continue;
+                }
+                for (uint8_t id = 0; id < GROUP; id++)
+                {
+                    EXPECT_EQ(page_fault(pid, addrs[id]), 0);
+                }
+            }
+            destroy_task(pid);
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return ns.count() / (ROUNDS * PAGE_TABLE_SIZE);
+    };
+
+    const long single_ns = run(0);
+    const tPagerStats single = *pager_get_stats();
+    const long batch_ns = run(1);
+    const tPagerStats batch = *pager_get_stats();
+    dprintf("page-in %u pages per call: %ld ns/page, page_fault_batch: %ld ns/page\n", GROUP, single_ns, batch_ns);
+    EXPECT_EQ(batch.faults, single.faults);
+    EXPECT_EQ(batch.clean_victims + batch.dirty_victims, single.clean_victims + single.dirty_victims);
+}
+
+TEST_F(Bench, ScenarioSetupFromImage)
+{
+    constexpr uint32_t ROUNDS = 500;
+    constexpr uint16_t SCENARIO_RAM_SIZE = 32768;
+    char path[] = "/tmp/ospager_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    destroy_taskMgr();
+    destroy_ram();
+    std::vector<uint8_t> memory(SCENARIO_RAM_SIZE);
+
+    // Initializes RAM and the task manager, then fills every task slot with a task that faults in all its pages
+    auto build = [&]() {
+        destroy_taskMgr();
+        destroy_ram();
+        memset(memory.data(), 0, SCENARIO_RAM_SIZE);
+        EXPECT_EQ(init_ram(memory.data(), SCENARIO_RAM_SIZE, PAGE_SIZE), SCENARIO_RAM_SIZE / PAGE_SIZE);
+        EXPECT_EQ(init_taskMgr(), 0);
+        for (uint8_t slot = 0; slot < TASK_TABLE_SIZE; slot++)
+        {
+            int pid = create_task(page_table, 0, address_space);
+            EXPECT_GE(pid, 0);
+            for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+            {
+                EXPECT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+            }
+        }
+    };
+
+    build();
+    ASSERT_EQ(ram_image_save(path), 0);
+    const tFrameId free_frames = ram_free_frames();
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < ROUNDS; round++)
+    {
+        build();
+    }
+    auto build_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    destroy_taskMgr();
+    destroy_ram();
+
+    tRamImage image;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < ROUNDS; round++)
+    {
+        EXPECT_EQ(ram_image_attach(&image, path), SCENARIO_RAM_SIZE / PAGE_SIZE);
+        for (uint8_t slot = 0; slot < TASK_TABLE_SIZE; slot++)
+        {
+            task_set_backing(get_task_mgr()->tasks[slot].pid, &memory_backing_ops, address_space);
+        }
+        EXPECT_EQ(ram_free_frames(), free_frames);
+        ram_image_detach(&image);
+    }
+    auto attach_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    dprintf("scenario setup (%u B RAM, %u tasks): build %ld ns, attach image %ld ns\n", SCENARIO_RAM_SIZE,
+        TASK_TABLE_SIZE, build_ns.count() / ROUNDS, attach_ns.count() / ROUNDS);
+
+    unlink(path);
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, PteScanNruClasses)
+{
+    constexpr uint32_t ROUNDS = 1000000;
+    std::mt19937 gen(3);
+    std::vector<tPageTableEntry> tables(64 * PAGE_TABLE_SIZE);
+    for (auto &entry : tables)
+    {
+        entry.p_bit = gen() & 0x1;
+        entry.r_bit = gen() & 0x1;
+        entry.m_bit = gen() & 0x1;
+    }
+
+    // Lowest NRU class present in every table, field by field and from the scanned masks
+    uint32_t fields_sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < ROUNDS; round++)
+    {
+        const tPageTableEntry *table = &tables[(round % 64) * PAGE_TABLE_SIZE];
+        uint8_t lowest = 4;
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            const uint8_t cls = (table[id].r_bit << 1) | table[id].m_bit;
+            if (table[id].p_bit && cls < lowest)
+                lowest = cls;
+        }
+        fields_sum += lowest;
+    }
+    auto fields_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    uint32_t scan_sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < ROUNDS; round++)
+    {
+        tPteScan scan;
+        pte_scan(&tables[(round % 64) * PAGE_TABLE_SIZE], &scan);
+        uint8_t cls = 0;
+        while (cls < 4 && pte_nru_class(&scan, cls) == 0)
+            cls++;
+        scan_sum += cls;
+    }
+    auto scan_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    dprintf("NRU classification per page table of %u pages: fields %.2f ns, pte_scan %.2f ns\n", PAGE_TABLE_SIZE,
+        (double)fields_ns.count() / ROUNDS, (double)scan_ns.count() / ROUNDS);
+    EXPECT_EQ(scan_sum, fields_sum);
+}
+
+TEST_F(Bench, BitmapBulkOps)
+{
+    constexpr uint32_t ROUNDS = 2000;
+    constexpr uint16_t LARGE_RAM_SIZE = 32768;
+    destroy_taskMgr();
+    destroy_ram();
+    std::vector<uint8_t> memory(LARGE_RAM_SIZE);
+    ASSERT_EQ(init_ram(memory.data(), LARGE_RAM_SIZE, 1), LARGE_RAM_SIZE);
+    const uint16_t frames = ram_free_frames();
+    uint8_t *bitmap = memory.data() + get_ram_state()->bitmap;
+
+    // Bit by bit equivalents of ram_free_frames() and ffree() of the same bitmap
+    auto count_free = [&]() {
+        uint32_t free_frames = 0;
+        for (uint32_t id = 0; id < LARGE_RAM_SIZE; id++)
+            free_frames += ((bitmap[id / 8] >> (id % 8)) & 0x1) == 0;
+        return free_frames;
+    };
+    auto clear_bits = [&](tFrameId first, uint16_t number) {
+        for (uint32_t id = first; id < (uint32_t)first + number; id++)
+            bitmap[id / 8] &= ~(0x01 << (id % 8));
+        bitmap_summary_update(bitmap, memory.data() + get_ram_state()->summary, LARGE_RAM_SIZE, first, number);
+    };
+
+    auto time = [](auto &&op) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < ROUNDS; round++)
+            op();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() /
+               ROUNDS;
+    };
+
+    tFrameId frame_id = 0;
+    uint32_t sum = 0;
+    const long count_ns = time([&]() { sum += ram_free_frames(); });
+    const long count_bits_ns = time([&]() { sum += count_free(); });
+    EXPECT_EQ(sum, 2u * ROUNDS * frames);
+    const long bulk_ns = time([&]() {
+        EXPECT_EQ(falloc(&frame_id, frames), 0);
+        ffree(frame_id, frames);
+    });
+    const long bulk_bits_ns = time([&]() {
+        EXPECT_EQ(falloc(&frame_id, frames), 0);
+        clear_bits(frame_id, frames);
+    });
+
+    dprintf("%u frames: free count %ld ns (bit by bit %ld ns), falloc+ffree of all %ld ns (ffree bit by bit %ld ns)\n",
+        LARGE_RAM_SIZE, count_ns, count_bits_ns, bulk_ns, bulk_bits_ns);
+
+    destroy_ram();
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, AllocPolicyChurn)
+{
+    constexpr uint32_t STEPS = 20000;
+    constexpr uint16_t CHURN_RAM_SIZE = 32768;
+    constexpr uint8_t CHURN_PAGE_SIZE = 64;
+    destroy_taskMgr();
+    std::vector<uint8_t> memory(CHURN_RAM_SIZE);
+
+    for (uint8_t policy : {RAM_ALLOC_FIRST_FIT, RAM_ALLOC_NEXT_FIT, RAM_ALLOC_BEST_FIT})
+    {
+        destroy_ram();
+        memset(memory.data(), 0, CHURN_RAM_SIZE);
+        ASSERT_GT(init_ram(memory.data(), CHURN_RAM_SIZE, CHURN_PAGE_SIZE), 0);
+        ASSERT_EQ(ram_set_alloc_policy(policy), 0);
+
+        // Same sequence for every policy: mostly small blocks, a few large ones, freed in random order
+        std::mt19937 gen(11);
+        std::vector<std::pair<uint16_t, uint16_t>> blocks;
+        uint32_t fragmentation = 0;
+        uint32_t samples = 0;
+        for (uint32_t step = 0; step < STEPS; step++)
+        {
+            if (blocks.empty() || gen() % 100 < 52)
+            {
+                const uint16_t number = (gen() % 8 == 0) ? 8 + gen() % 25 : 1 + gen() % 4;
+                tFrameId frame_id = 0;
+                if (falloc(&frame_id, number) == 0)
+                    blocks.emplace_back(frame_id, number);
+            }
+            else
+            {
+                const size_t id = gen() % blocks.size();
+                ffree(blocks[id].first, blocks[id].second);
+                blocks[id] = blocks.back();
+                blocks.pop_back();
+            }
+            if (step % 100 == 99)
+            {
+                fragmentation += ram_fragmentation();
+                samples++;
+            }
+        }
+        const tRamStats stats = *ram_get_stats();
+        const uint32_t calls = stats.allocations + stats.failures;
+        dprintf("churn policy %u: %.1f%% allocations succeeded, %.1f frames scanned per call, "
+                "%u%% average fragmentation\n",
+            policy, 100.0 * stats.allocations / calls, (double)stats.scanned_frames / calls, fragmentation / samples);
+        EXPECT_GT(stats.allocations, 0u);
+    }
+
+    destroy_ram();
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, CompactionChurn)
+{
+    constexpr uint32_t ROUNDS = 2000;
+    constexpr uint16_t CHURN_RAM_SIZE = 4096 * (PAGE_TABLE_SIZE > 8 ? PAGE_TABLE_SIZE / 8 : 1);
+    constexpr uint8_t CHURN_PAGE_SIZE = 64;
+    constexpr uint16_t BLOCK = 24;
+    destroy_taskMgr();
+    std::vector<uint8_t> memory(CHURN_RAM_SIZE);
+
+    for (uint16_t budget : {0, 4, PAGE_TABLE_SIZE * TASK_TABLE_SIZE})
+    {
+        destroy_ram();
+        memset(memory.data(), 0, CHURN_RAM_SIZE);
+        ASSERT_GT(init_ram(memory.data(), CHURN_RAM_SIZE, CHURN_PAGE_SIZE), 0);
+        ASSERT_EQ(init_taskMgr(), 0);
+        pager_reset_stats();
+
+        // Same sequence for every budget: tasks fault pages in interleaved order, then half of them exit
+        std::mt19937 gen(5);
+        uint32_t successes = 0;
+        uint64_t compact_ns = 0;
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            int pids[TASK_TABLE_SIZE];
+            for (auto &pid : pids)
+            {
+                pid = create_task(page_table, 0, address_space);
+                ASSERT_GE(pid, 0);
+            }
+            for (uint32_t fault = 0; fault < 6 * TASK_TABLE_SIZE; fault++)
+            {
+                const int pid = pids[gen() % TASK_TABLE_SIZE];
+                const int ret = page_fault(pid, (gen() % PAGE_TABLE_SIZE) * CHURN_PAGE_SIZE);
+                EXPECT_TRUE(ret == 0 || ret == -2);
+            }
+            for (uint8_t id = 0; id < TASK_TABLE_SIZE / 2; id++)
+            {
+                const uint8_t exited = id + gen() % (TASK_TABLE_SIZE - id);
+                std::swap(pids[id], pids[exited]);
+                destroy_task(pids[id]);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            if (budget != 0)
+            {
+                EXPECT_GE(pager_compact(budget), 0);
+            }
+            compact_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+            tFrameId frame_id = 0;
+            if (falloc(&frame_id, BLOCK) == 0)
+            {
+                successes++;
+                ffree(frame_id, BLOCK);
+            }
+            for (uint8_t id = TASK_TABLE_SIZE / 2; id < TASK_TABLE_SIZE; id++)
+            {
+                destroy_task(pids[id]);
+            }
+        }
+        dprintf("compaction budget %u: %.1f%% of %u-frame allocations succeeded, %u pages moved, "
+                "%.0f ns per pass\n",
+            budget, 100.0 * successes / ROUNDS, BLOCK, pager_get_stats()->compacted_pages,
+            (double)compact_ns / ROUNDS);
+        destroy_taskMgr();
+    }
+
+    destroy_ram();
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, LargePageSequentialScan)
+{
+    constexpr uint32_t ROUNDS = 2000;
+
+    for (uint8_t order = 0; order <= PAGER_MAX_LARGE_ORDER; order++)
+    {
+        pager_reset_stats();
+        uint64_t scan_ns = 0;
+        uint32_t coverage = 0;
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            const int pid = create_task(page_table, 0, address_space);
+            ASSERT_GE(pid, 0);
+            ASSERT_EQ(set_large_pages(pid, order), 0);
+            tTaskStruct *task = get_task_struct(pid);
+            set_page_table(task->page_table);
+
+            // Reads the whole address space once, like a sequential copy.
+            auto start = std::chrono::steady_clock::now();
+            for (uint16_t address = 0; address < PAGE_SIZE * PAGE_TABLE_SIZE; address++)
+            {
+                uint8_t data = 0;
+                if (load_data(address, &data) == -1)
+                {
+                    EXPECT_EQ(page_fault(pid, address), 0);
+                    EXPECT_EQ(load_data(address, &data), 0);
+                }
+            }
+            scan_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            coverage += pager_large_coverage(pid);
+            destroy_task(pid);
+        }
+        const tPagerStats stats = *pager_get_stats();
+        dprintf("large page order %u: %.1f faults per scan, %.0f ns per scan, %.0f%% coverage, %u fallbacks\n",
+            order, (double)stats.faults / ROUNDS, (double)scan_ns / ROUNDS,
+            100.0 * coverage / (ROUNDS * PAGE_TABLE_SIZE), stats.large_fallbacks);
+        EXPECT_GT(stats.faults, 0u);
+    }
+    set_page_table(nullptr);
+}
+
+TEST_F(Bench, InitRamZeroCheck)
+{
+    constexpr uint32_t ROUNDS = 2000;
+    constexpr tRamSize INIT_RAM_SIZE = 16384;
+    constexpr tPageSize INIT_PAGE_SIZE = 64;
+    destroy_taskMgr();
+    destroy_ram();
+    std::vector<uint8_t> memory(INIT_RAM_SIZE);
+
+    // The former byte-by-byte check, for comparison.
+    auto byte_loop = [](void *buffer, tRamSize size, tPageSize page_size) {
+        for (tRamSize pos = 0; pos < size; pos++)
+        {
+            if (((char *)buffer)[pos] != 0)
+                return -3;
+        }
+        return init_ram_trusted(buffer, size, page_size);
+    };
+    const std::pair<const char *, int (*)(void *, tRamSize, tPageSize)> variants[] = {
+        {"byte loop", byte_loop},
+        {"init_ram", init_ram},
+        {"init_ram_trusted", init_ram_trusted},
+    };
+    for (const auto &variant : variants)
+    {
+        uint64_t init_ns = 0;
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            memset(memory.data(), 0, INIT_RAM_SIZE);
+            auto start = std::chrono::steady_clock::now();
+            ASSERT_EQ(variant.second(memory.data(), INIT_RAM_SIZE, INIT_PAGE_SIZE), INIT_RAM_SIZE / INIT_PAGE_SIZE);
+            init_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            destroy_ram();
+        }
+        dprintf("%s: %.0f ns per init of %u bytes\n", variant.first, (double)init_ns / ROUNDS, INIT_RAM_SIZE);
+    }
+
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, NearlyFullFalloc)
+{
+    constexpr uint32_t ROUNDS = 20000;
+    constexpr tRamSize FULL_RAM_SIZE = 32768;
+    destroy_taskMgr();
+    destroy_ram();
+    std::vector<uint8_t> memory(FULL_RAM_SIZE);
+    ASSERT_EQ(init_ram(memory.data(), FULL_RAM_SIZE, 1), FULL_RAM_SIZE);
+    const tRam *state = get_ram_state();
+    uint8_t *bitmap = memory.data() + state->bitmap;
+
+    auto time = [](auto &&op) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < ROUNDS; round++)
+            op();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() /
+               ROUNDS;
+    };
+
+    // Only the last frames stay free, like RAM under pressure before reclaim.
+    for (tFrameId free_frames : {16384u, 1024u, 16u})
+    {
+        tFrameId frame_id = 0;
+        ASSERT_EQ(falloc(&frame_id, ram_free_frames() - free_frames), 0);
+        const long summary_ns = time([&]() {
+            tFrameId id = 0;
+            EXPECT_EQ(falloc(&id, 1), 0);
+            ffree(id, 1);
+        });
+        // The same allocation through the bitmap alone.
+        const long bitmap_ns = time([&]() {
+            const int32_t id = bitmap_find_clear_run(bitmap, FULL_RAM_SIZE, 0, 1);
+            EXPECT_GE(id, 0);
+            bitmap_set_range(bitmap, id, 1);
+            bitmap_clear_range(bitmap, id, 1);
+        });
+        dprintf("%u of %u frames free: falloc+ffree %ld ns with summary, %ld ns bitmap only\n", free_frames,
+            FULL_RAM_SIZE, summary_ns, bitmap_ns);
+        ffree(frame_id, FULL_RAM_SIZE - free_frames - frame_id);
+    }
+
+    destroy_ram();
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, MagazineContention)
+{
+    constexpr uint32_t ROUNDS = 200000;
+    constexpr tRamSize CONTENTION_RAM_SIZE = 4096;
+    destroy_taskMgr();
+    destroy_ram();
+    std::vector<uint8_t> memory(CONTENTION_RAM_SIZE);
+    ASSERT_GT(init_ram(memory.data(), CONTENTION_RAM_SIZE, 16), 0);
+
+    // Every thread allocates and frees one frame per round, like page faults of tasks on different CPUs.
+    auto run = [&](unsigned thread_count) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned thread = 0; thread < thread_count; thread++)
+        {
+            threads.emplace_back([]() {
+                for (uint32_t round = 0; round < ROUNDS; round++)
+                {
+                    tFrameId id = 0;
+                    if (falloc(&id, 1) == 0)
+                        ffree(id, 1);
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() /
+               ROUNDS;
+    };
+
+    for (unsigned thread_count : {1u, 2u, 4u})
+    {
+        ASSERT_EQ(ram_set_magazines(0), 0);
+        const long locked_ns = run(thread_count);
+        ASSERT_EQ(ram_set_magazines(1), 0);
+        ram_reset_stats();
+        const long magazine_ns = run(thread_count);
+        const tRamStats *stats = ram_get_stats();
+        dprintf("%u threads: falloc+ffree %ld ns per round with lock only, %ld ns with magazines "
+                "(%u hits, %u refills)\n",
+            thread_count, locked_ns, magazine_ns, stats->magazine_hits, stats->magazine_refills);
+        EXPECT_EQ(ram_cached_frames(), 0u);
+    }
+
+    destroy_ram();
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, LockFreeContention)
+{
+    constexpr uint32_t ROUNDS = 200000;
+    constexpr tRamSize CONTENTION_RAM_SIZE = 4096;
+    destroy_taskMgr();
+    destroy_ram();
+    std::vector<uint8_t> memory(CONTENTION_RAM_SIZE);
+    ASSERT_GT(init_ram(memory.data(), CONTENTION_RAM_SIZE, 16), 0);
+    const tFrameId free_frames = ram_free_frames();
+
+    // Returns falloc(1)+ffree(1) pairs per microsecond of all threads together.
+    auto run = [&](unsigned thread_count) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned thread = 0; thread < thread_count; thread++)
+        {
+            threads.emplace_back([]() {
+                for (uint32_t round = 0; round < ROUNDS; round++)
+                {
+                    tFrameId id = 0;
+                    if (falloc(&id, 1) == 0)
+                        ffree(id, 1);
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        const auto ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        return (double)ROUNDS * thread_count * 1000 / ns;
+    };
+
+    const unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+        ASSERT_EQ(ram_set_lock_free(0), 0);
+        const double locked = run(thread_count);
+        ASSERT_EQ(ram_set_lock_free(1), 0);
+        const double lock_free = run(thread_count);
+        dprintf("%u threads (%u CPUs): %.1f falloc+ffree per us with lock, %.1f lock-free\n", thread_count,
+            std::thread::hardware_concurrency(), locked, lock_free);
+        EXPECT_EQ(ram_free_frames(), free_frames);
+    }
+
+    destroy_ram();
+    memset(ram, 0, RAM_SIZE);
+    ASSERT_EQ(init_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+}
+
+TEST_F(Bench, NodePlacementZipf)
+{
+    // Four nodes, the task runs on node 3 and the other nodes are four times as far.
+    // Nodes 0 and 1 hold tRam and the task manager.
+    const uint8_t weights[] = {4, 4, 4, 4};
+    ASSERT_EQ(ram_set_nodes(4, weights), 0);
+    set_mmu_node(3);
+    const auto trace = ZipfTrace(1.0);
+    const tFrameId node_frames = ram_node_free_frames(3);
+
+    // Frames of node 3 taken by other users before the task starts.
+    for (tFrameId taken : {(tFrameId)0, (tFrameId)(node_frames / 2), node_frames})
+    {
+        for (uint8_t home_node : {3, 2})
+        {
+            std::vector<tFrameId> held(taken);
+            for (auto &frame_id : held)
+            {
+                ASSERT_EQ(falloc_node(&frame_id, 1, 3), 0);
+            }
+            mmu_reset_stats();
+            const uint32_t faults = Replay(trace, 6, PAGER_POLICY_AGING, 0, home_node);
+            const tMmuStats *stats = mmu_get_stats();
+            dprintf("home node %u, %u of %u frames of node 3 taken: %u faults, %.1f%% remote accesses, "
+                    "%.2f cost per access\n",
+                home_node, taken, node_frames, faults,
+                100.0 * stats->remote_accesses / (stats->local_accesses + stats->remote_accesses),
+                (double)stats->access_cost / TRACE_LENGTH);
+            EXPECT_EQ(stats->local_accesses + stats->remote_accesses, TRACE_LENGTH);
+            for (auto frame_id : held)
+            {
+                ffree(frame_id, 1);
+            }
+        }
+    }
+    set_mmu_node(0);
+}
+
+TEST_F(Bench, NodeMigrationZipf)
+{
+    constexpr uint32_t TICK_INTERVAL = 200;
+    const uint8_t weights[] = {4, 4, 4, 4};
+    ASSERT_EQ(ram_set_nodes(4, weights), 0);
+    set_mmu_node(3);
+    const auto trace = ZipfTrace(1.0);
+
+    uint32_t base_remote = 0;
+    for (uint16_t budget : {0, 1, 4})
+    {
+        int pid = create_task(page_table, 6, address_space);
+        ASSERT_GE(pid, 0);
+        ASSERT_EQ(set_home_node(pid, 3), 0);
+        tTaskStruct *task = get_task_struct(pid);
+        set_page_table(task->page_table);
+
+        // The pages are loaded while node 3 is taken by others, then node 3 becomes free.
+        std::vector<tFrameId> held;
+        tFrameId frame_id = 0;
+        while (falloc_node(&frame_id, 1, 3) == 0)
+            held.push_back(frame_id);
+        for (uint8_t page = 0; page < PAGE_TABLE_SIZE; page++)
+        {
+            page_fault(pid, page * PAGE_SIZE);
+        }
+        for (auto id : held)
+        {
+            ffree(id, 1);
+        }
+
+        pager_set_migration(budget);
+        pager_reset_stats();
+        mmu_reset_stats();
+        for (uint32_t step = 0; step < trace.size(); step++)
+        {
+            const uint16_t address = trace[step] * PAGE_SIZE + (step % PAGE_SIZE);
+            uint8_t data = 0;
+            if (load_data(address, &data) == -1)
+            {
+                EXPECT_EQ(page_fault(pid, address), 0);
+                EXPECT_EQ(load_data(address, &data), 0);
+            }
+            if (step % TICK_INTERVAL == TICK_INTERVAL - 1)
+            {
+                EXPECT_EQ(pager_tick(), 0);
+            }
+        }
+        const uint32_t remote = mmu_get_stats()->remote_accesses;
+        if (budget == 0)
+            base_remote = remote;
+        dprintf("migration budget %u per %u accesses: %u remote accesses (%d saved), %u pages / %lu bytes migrated\n",
+            budget, TICK_INTERVAL, remote, (int)(base_remote - remote), pager_get_stats()->migrated_pages,
+            (unsigned long)pager_get_stats()->migrated_bytes);
+        if (budget != 0)
+        {
+            EXPECT_LT(remote, base_remote);
+        }
+        destroy_task(pid);
+    }
+    pager_set_migration(0);
+    set_mmu_node(0);
+}
+
+TEST_F(Bench, CgroupReservationZipf)
+{
+    // The RAM left after the task manager, at most 10 frames, is shared by the tasks.
+    const tFrameId shared = std::min<tFrameId>(ram_free_frames(), 10);
+    const auto trace = ZipfTrace(1.0);
+    uint32_t base_faults = 0;
+    const tFrameId reservations[] = {0, (tFrameId)(shared / 2 - 1), (tFrameId)(shared / 2 + 1)};
+    for (tFrameId reservation : reservations)
+    {
+        ASSERT_EQ(cgroup_set_limit(CGROUP_ROOT, shared), 0);
+        const int group = cgroup_create(CGROUP_ROOT, 0, reservation);
+        ASSERT_GE(group, 0);
+        int pid = create_task(page_table, 0, address_space);
+        ASSERT_GE(pid, 0);
+        ASSERT_EQ(cgroup_attach(pid, group), 0);
+
+        // A task outside of the group takes all frames it can get first, but leaves two.
+        int noisy = create_task(page_table, shared - 2, address_space);
+        ASSERT_GE(noisy, 0);
+        for (uint8_t page = 0; page < PAGE_TABLE_SIZE; page++)
+        {
+            page_fault(noisy, page * PAGE_SIZE);
+        }
+
+        tTaskStruct *task = get_task_struct(pid);
+        set_page_table(task->page_table);
+        const uint32_t hits = cgroup_get(CGROUP_ROOT)->limit_hits;
+        uint32_t faults = 0;
+        uint64_t ns = 0;
+        for (uint32_t step = 0; step < trace.size(); step++)
+        {
+            const uint16_t address = trace[step] * PAGE_SIZE + (step % PAGE_SIZE);
+            uint8_t data = 0;
+            if (load_data(address, &data) == -1)
+            {
+                faults++;
+                auto start = std::chrono::steady_clock::now();
+                EXPECT_EQ(page_fault(pid, address), 0);
+                ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                EXPECT_EQ(load_data(address, &data), 0);
+            }
+        }
+        if (reservation == 0)
+            base_faults = faults;
+        dprintf("zipf(1.0) %u shared frames, reservation %u: %u frames held, %u faults (%lu ns/fault), "
+                "%u limit hits of the root\n",
+            shared, reservation, cgroup_usage(group), faults, (unsigned long)(faults ? ns / faults : 0),
+            cgroup_get(CGROUP_ROOT)->limit_hits - hits);
+        EXPECT_GE(cgroup_usage(group), reservation);
+        if (reservation != 0)
+        {
+            EXPECT_LT(faults, base_faults) << "Expected the reservation to keep frames away from the other task";
+        }
+        destroy_task(noisy);
+        destroy_task(pid);
+        ASSERT_EQ(cgroup_destroy(group), 0);
+    }
+    cgroup_set_limit(CGROUP_ROOT, 0);
+}
+
+TEST_F(Bench, LockedHotPagesZipf)
+{
+    const auto trace = ZipfTrace(0.6);
+    for (uint8_t locked : {0, 1, 2})
+    {
+        int pid = create_task(page_table, 4, address_space);
+        ASSERT_GE(pid, 0);
+        ASSERT_EQ(set_replacement_policy(pid, PAGER_POLICY_AGING), 0);
+        if (locked != 0)
+        {
+            ASSERT_EQ(lock_pages(pid, 0, locked * PAGE_SIZE), 0);
+        }
+        tTaskStruct *task = get_task_struct(pid);
+        set_page_table(task->page_table);
+
+        // The hottest pages stand for the data of a real-time task, whose accesses must not fault.
+        uint32_t faults = 0;
+        uint32_t hot_faults = 0;
+        for (uint32_t step = 0; step < trace.size(); step++)
+        {
+            const uint16_t address = trace[step] * PAGE_SIZE + (step % PAGE_SIZE);
+            uint8_t data = 0;
+            if (load_data(address, &data) == -1)
+            {
+                faults++;
+                hot_faults += (trace[step] < 2);
+                EXPECT_EQ(page_fault(pid, address), 0);
+                EXPECT_EQ(load_data(address, &data), 0);
+            }
+        }
+        dprintf("zipf(0.6) 4 frames, %u pages locked: %u faults, %u on the 2 hottest pages\n", locked, faults,
+            hot_faults);
+        if (locked == 2)
+        {
+            EXPECT_EQ(hot_faults, 0u) << "Expected no fault on locked pages";
+        }
+        destroy_task(pid);
+    }
+}
@@ -0,0 +1,245 @@
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "bitmap.h"
+}
+
+// Bit by bit reference of the bitmap operations.
+static int32_t FindClearRun(const std::vector<uint8_t> &bitmap, uint32_t bits, uint32_t start, uint32_t length)
+{
+    uint32_t run = 0;
+    for (uint32_t bit = start; bit < bits; bit++)
+    {
+        run = bitmap_test(bitmap.data(), bit) ? 0 : run + 1;
+        if (length != 0 && run == length)
+            return bit + 1 - length;
+    }
+    return -1;
+}
+
+static uint32_t LargestClearRun(const std::vector<uint8_t> &bitmap, uint32_t bits)
+{
+    uint32_t run = 0;
+    uint32_t largest = 0;
+    for (uint32_t bit = 0; bit < bits; bit++)
+    {
+        run = bitmap_test(bitmap.data(), bit) ? 0 : run + 1;
+        largest = std::max(largest, run);
+    }
+    return largest;
+}
+
+static uint32_t Count(const std::vector<uint8_t> &bitmap, uint32_t bits)
+{
+    uint32_t count = 0;
+    for (uint32_t bit = 0; bit < bits; bit++)
+        count += bitmap_test(bitmap.data(), bit);
+    return count;
+}
+
+class BitmapTest : public ::testing::TestWithParam<uint32_t>
+{
+  protected:
+    // Random bitmap of bits bits with set runs and clear runs of random length. Unused trailing bits are set.
+    std::vector<uint8_t> RandomBitmap(std::mt19937 &gen, uint32_t bits, uint32_t max_run)
+    {
+        std::vector<uint8_t> bitmap((bits + 7) / 8, 0xff);
+        std::uniform_int_distribution<uint32_t> len(1, max_run);
+        bool set = gen() & 0x1;
+        for (uint32_t bit = 0; bit < bits;)
+        {
+            uint32_t run = std::min(len(gen), bits - bit);
+            if (!set)
+                bitmap_clear_range(bitmap.data(), bit, run);
+            bit += run;
+            set = !set;
+        }
+        return bitmap;
+    }
+};
+
+TEST_P(BitmapTest, SetAndClearRange)
+{
+    const uint32_t bits = GetParam();
+    std::mt19937 gen(bits);
+    for (int round = 0; round < 200; round++)
+    {
+        std::vector<uint8_t> bitmap((bits + 7) / 8, 0);
+        std::vector<bool> expected(bits, false);
+        for (int op = 0; op < 8; op++)
+        {
+            uint32_t first = gen() % bits;
+            uint32_t count = gen() % (bits - first + 1);
+            bool set = gen() & 0x1;
+            if (set)
+                bitmap_set_range(bitmap.data(), first, count);
+            else
+                bitmap_clear_range(bitmap.data(), first, count);
+            for (uint32_t bit = first; bit < first + count; bit++)
+                expected[bit] = set;
+        }
+        for (uint32_t bit = 0; bit < bits; bit++)
+            ASSERT_EQ(bitmap_test(bitmap.data(), bit), expected[bit] ? 1 : 0) << "bit " << bit;
+    }
+}
+
+TEST_P(BitmapTest, CountAndRunsMatchReference)
+{
+    const uint32_t bits = GetParam();
+    std::mt19937 gen(bits + 1);
+    for (uint32_t max_run : {1u, 3u, 17u, 70u, 300u})
+    {
+        for (int round = 0; round < 50; round++)
+        {
+            auto bitmap = RandomBitmap(gen, bits, max_run);
+            ASSERT_EQ(bitmap_count(bitmap.data(), bits), Count(bitmap, bits));
+            ASSERT_EQ(bitmap_largest_clear_run(bitmap.data(), bits), LargestClearRun(bitmap, bits));
+            uint32_t pos = 0;
+            uint32_t length = 0;
+            int32_t run;
+            while ((run = bitmap_next_clear_run(bitmap.data(), bits, pos, &length)) >= 0)
+            {
+                ASSERT_EQ(run, FindClearRun(bitmap, bits, pos, 1));
+                ASSERT_GT(length, 0u);
+                ASSERT_TRUE(run + length == bits || bitmap_test(bitmap.data(), run + length));
+                ASSERT_EQ(FindClearRun(bitmap, run + length, run, length), run);
+                pos = run + length;
+            }
+            ASSERT_EQ(FindClearRun(bitmap, bits, pos, 1), -1);
+            for (uint32_t length : {1u, 2u, 8u, 63u, 64u, 65u, 200u})
+            {
+                uint32_t start = gen() % bits;
+                ASSERT_EQ(bitmap_find_clear_run(bitmap.data(), bits, 0, length), FindClearRun(bitmap, bits, 0, length))
+                    << "length " << length;
+                ASSERT_EQ(bitmap_find_clear_run(bitmap.data(), bits, start, length),
+                    FindClearRun(bitmap, bits, start, length))
+                    << "length " << length << " start " << start;
+            }
+        }
+    }
+}
+
+TEST_P(BitmapTest, EmptyAndFullBitmaps)
+{
+    const uint32_t bits = GetParam();
+    std::vector<uint8_t> bitmap((bits + 7) / 8, 0);
+    EXPECT_EQ(bitmap_count(bitmap.data(), bits), 0u);
+    EXPECT_EQ(bitmap_largest_clear_run(bitmap.data(), bits), bits);
+    EXPECT_EQ(bitmap_find_clear_run(bitmap.data(), bits, 0, bits), 0);
+    EXPECT_EQ(bitmap_find_clear_run(bitmap.data(), bits, 0, bits + 1), -1);
+    EXPECT_EQ(bitmap_find_clear_run(bitmap.data(), bits, 0, 0), -1);
+    EXPECT_EQ(bitmap_find_clear_run(bitmap.data(), bits, bits, 1), -1);
+
+    bitmap_set_range(bitmap.data(), 0, bits);
+    EXPECT_EQ(bitmap_count(bitmap.data(), bits), bits);
+    EXPECT_EQ(bitmap_largest_clear_run(bitmap.data(), bits), 0u);
+    EXPECT_EQ(bitmap_find_clear_run(bitmap.data(), bits, 0, 1), -1);
+}
+
+TEST_P(BitmapTest, SummarySearchesMatchReference)
+{
+    const uint32_t bits = GetParam();
+    std::mt19937 gen(bits + 2);
+    for (uint32_t max_run : {3u, 70u, 300u, 2000u})
+    {
+        for (int round = 0; round < 50; round++)
+        {
+            // Mostly full bitmaps, so that the summary has full words to skip.
+            auto bitmap = RandomBitmap(gen, bits, max_run);
+            for (uint32_t bit = 0; bit < bits; bit++)
+            {
+                if (gen() % 4 != 0)
+                    bitmap_set_range(bitmap.data(), bit, 1);
+            }
+            std::vector<uint8_t> summary(BITMAP_SUMMARY_BYTES(bits), 0);
+            bitmap_summary_update(bitmap.data(), summary.data(), bits, 0, bits);
+
+            // Random changes keep the summary up to date.
+            for (int op = 0; op < 8; op++)
+            {
+                const uint32_t first = gen() % bits;
+                const uint32_t count = gen() % std::min(bits - first + 1, 200u);
+                if (gen() & 0x1)
+                    bitmap_set_range(bitmap.data(), first, count);
+                else
+                    bitmap_clear_range(bitmap.data(), first, count);
+                bitmap_summary_update(bitmap.data(), summary.data(), bits, first, count);
+            }
+            for (uint32_t word = 0; word < (bits + 63) / 64; word++)
+            {
+                const uint32_t end = std::min(bits, (word + 1) * 64);
+                ASSERT_EQ(bitmap_test(summary.data(), word) != 0, FindClearRun(bitmap, end, word * 64, 1) < 0)
+                    << "word " << word;
+            }
+
+            for (uint32_t length : {1u, 2u, 63u, 64u, 65u, 200u})
+            {
+                const uint32_t start = gen() % bits;
+                ASSERT_EQ(bitmap_summary_find_clear_run(bitmap.data(), summary.data(), bits, start, length),
+                    FindClearRun(bitmap, bits, start, length))
+                    << "length " << length << " start " << start;
+            }
+            uint32_t length = 0;
+            uint32_t expected_length = 0;
+            const uint32_t start = gen() % bits;
+            ASSERT_EQ(bitmap_summary_next_clear_run(bitmap.data(), summary.data(), bits, start, &length),
+                bitmap_next_clear_run(bitmap.data(), bits, start, &expected_length));
+            ASSERT_EQ(length, expected_length);
+        }
+    }
+}
+
+TEST_P(BitmapTest, SummaryOfFullBitmap)
+{
+    const uint32_t bits = GetParam();
+    std::vector<uint8_t> bitmap((bits + 7) / 8, 0);
+    std::vector<uint8_t> summary(BITMAP_SUMMARY_BYTES(bits), 0);
+    EXPECT_EQ(bitmap_summary_find_clear_run(bitmap.data(), summary.data(), bits, 0, bits), 0);
+
+    bitmap_set_range(bitmap.data(), 0, bits);
+    bitmap_summary_update(bitmap.data(), summary.data(), bits, 0, bits);
+    EXPECT_EQ(bitmap_count(summary.data(), (bits + 63) / 64), (bits + 63) / 64) << "Expected partial last word full";
+    EXPECT_EQ(bitmap_summary_find_clear_run(bitmap.data(), summary.data(), bits, 0, 1), -1);
+
+    bitmap_clear_range(bitmap.data(), bits - 1, 1);
+    bitmap_summary_update(bitmap.data(), summary.data(), bits, bits - 1, 1);
+    EXPECT_EQ(bitmap_summary_find_clear_run(bitmap.data(), summary.data(), bits, 0, 1), (int32_t)bits - 1);
+    EXPECT_EQ(bitmap_summary_find_clear_run(bitmap.data(), nullptr, bits, 0, 1), (int32_t)bits - 1);
+}
+
+TEST_P(BitmapTest, AtomicOpsMatchPlainOps)
+{
+    const uint32_t bits = GetParam();
+    std::vector<uint8_t> bitmap((bits + 7) / 8, 0);
+    std::vector<uint8_t> expected((bits + 7) / 8, 0);
+    std::mt19937 gen(bits);
+    for (int round = 0; round < 200; round++)
+    {
+        const uint32_t first = gen() % bits;
+        const uint32_t count = 1 + gen() % (bits - first);
+        if (gen() % 2)
+        {
+            const bool all_clear = bitmap_find_clear_run(expected.data(), first + count, first, count) == (int32_t)first;
+            ASSERT_EQ(bitmap_atomic_set_range(bitmap.data(), first, count), all_clear ? 0 : -1);
+            if (all_clear)
+                bitmap_set_range(expected.data(), first, count);
+        }
+        else
+        {
+            bitmap_atomic_clear_range(bitmap.data(), first, count);
+            bitmap_clear_range(expected.data(), first, count);
+        }
+        ASSERT_EQ(bitmap, expected) << "Expected a failed set to leave the bitmap unchanged";
+
+        const int32_t claimed = bitmap_atomic_claim(bitmap.data(), bits, first);
+        ASSERT_EQ(claimed, bitmap_find_clear_run(expected.data(), bits, first, 1));
+        if (claimed >= 0)
+            bitmap_set_range(expected.data(), claimed, 1);
+        ASSERT_EQ(bitmap, expected);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, BitmapTest, ::testing::Values(1u, 8u, 16u, 64u, 72u, 128u, 256u, 1000u, 4096u));
@@ -0,0 +1,239 @@
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "test_ram.h"
+
+extern "C" {
+#include "cgroup.h"
+#include "pager.h"
+#include "task.h"
+}
+
+class CgroupTest : public RamTestBase
+{
+  protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(init_taskMgr(), 0);
+        memset(page_table, 0, sizeof(page_table));
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            page_table[id].r = 0x1;
+        }
+        memset(address_space, 0xab, sizeof(address_space));
+        pid = create_task(page_table, 0, address_space);
+        ASSERT_GE(pid, 0);
+        other = create_task(page_table, 0, address_space);
+        ASSERT_GE(other, 0);
+        pager_reset_stats();
+    }
+
+    void TearDown() override
+    {
+        destroy_taskMgr();
+    }
+
+    // Faults pages 0 to count - 1 of the task in.
+    void Fault(int task_pid, uint8_t count)
+    {
+        for (uint8_t id = 0; id < count; id++)
+        {
+            ASSERT_EQ(page_fault(task_pid, PAGE_SIZE * id), 0);
+        }
+    }
+
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    int pid;
+    int other;
+    uint8_t address_space[PAGE_SIZE * PAGE_TABLE_SIZE];
+};
+
+TEST_F(CgroupTest, NewTaskIsInRootGroup)
+{
+    EXPECT_EQ(cgroup_of(pid), CGROUP_ROOT);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 0);
+    EXPECT_EQ(cgroup_headroom(pid), NUM_FRAMES);
+    EXPECT_EQ(cgroup_of(pid + 7), -1);
+}
+
+TEST_F(CgroupTest, InvalidArguments)
+{
+    EXPECT_EQ(cgroup_create(3, 0, 0), -2);
+    EXPECT_EQ(cgroup_destroy(CGROUP_ROOT), -1);
+    EXPECT_EQ(cgroup_destroy(3), -1);
+    EXPECT_EQ(cgroup_set_limit(3, 1), -1);
+    EXPECT_EQ(cgroup_attach(pid, 3), -1);
+    EXPECT_EQ(cgroup_attach(pid + 7, CGROUP_ROOT), -1);
+    EXPECT_EQ(cgroup_charge(pid + 7, 1), -1);
+    EXPECT_EQ(cgroup_get(3), nullptr);
+}
+
+TEST_F(CgroupTest, RunsOutOfGroups)
+{
+    for (uint8_t id = 1; id < CGROUP_MAX; id++)
+    {
+        EXPECT_EQ(cgroup_create(CGROUP_ROOT, 0, 0), id);
+    }
+    EXPECT_EQ(cgroup_create(CGROUP_ROOT, 0, 0), -1);
+    EXPECT_EQ(cgroup_destroy(3), 0);
+    EXPECT_EQ(cgroup_create(CGROUP_ROOT, 0, 0), 3) << "Expected the destroyed group to be reused";
+}
+
+TEST_F(CgroupTest, FaultsAreCharged)
+{
+    const int group = cgroup_create(CGROUP_ROOT, 0, 0);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    Fault(pid, 3);
+    Fault(other, 1);
+
+    EXPECT_EQ(cgroup_task_usage(pid), 3);
+    EXPECT_EQ(cgroup_usage(group), 3);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 4);
+    EXPECT_EQ(cgroup_get(group)->tasks, 1);
+
+    ASSERT_EQ(destroy_task(pid), 0);
+    EXPECT_EQ(cgroup_usage(group), 0);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 1);
+    EXPECT_EQ(cgroup_get(group)->tasks, 0);
+    EXPECT_EQ(cgroup_destroy(group), 0);
+}
+
+TEST_F(CgroupTest, LimitEvictsOwnPage)
+{
+    const int group = cgroup_create(CGROUP_ROOT, 2, 0);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    Fault(pid, 3);
+
+    EXPECT_EQ(cgroup_usage(group), 2);
+    EXPECT_EQ(cgroup_get(group)->limit_hits, 1u);
+    EXPECT_EQ(pager_get_stats()->clean_victims, 1u);
+    EXPECT_EQ(pager_get_stats()->direct_reclaims, 0u) << "Expected a limit not to count as a lack of frames";
+    const tTaskStruct *task = get_task_struct(pid);
+    EXPECT_EQ(task->page_table[0].p_bit, 0x0) << "Expected the task to evict its own page";
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+}
+
+TEST_F(CgroupTest, LimitWithoutPresentPageFails)
+{
+    const int group = cgroup_create(CGROUP_ROOT, 1, 0);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    ASSERT_EQ(cgroup_charge(pid, 1), 0);  // held by the task, but not by a page
+
+    EXPECT_EQ(page_fault(pid, 0), -3);
+}
+
+TEST_F(CgroupTest, ParentLimitCoversChildren)
+{
+    const int parent = cgroup_create(CGROUP_ROOT, 3, 0);
+    const int first = cgroup_create(parent, 0, 0);
+    const int second = cgroup_create(parent, 0, 0);
+    ASSERT_EQ(cgroup_get(second)->depth, 2);
+    ASSERT_EQ(cgroup_attach(pid, first), 0);
+    ASSERT_EQ(cgroup_attach(other, second), 0);
+
+    Fault(pid, 2);
+    EXPECT_EQ(cgroup_headroom(other), 1);
+    Fault(other, 2);
+
+    EXPECT_EQ(cgroup_usage(first), 2);
+    EXPECT_EQ(cgroup_usage(second), 1);
+    EXPECT_EQ(cgroup_usage(parent), 3);
+    EXPECT_EQ(cgroup_get(parent)->limit_hits, 1u);
+    EXPECT_EQ(cgroup_destroy(parent), -2);
+}
+
+TEST_F(CgroupTest, ReservationIsHeldInParent)
+{
+    ASSERT_EQ(cgroup_set_limit(CGROUP_ROOT, 4), 0);
+    const int group = cgroup_create(CGROUP_ROOT, 0, 3);
+    ASSERT_GE(group, 0);
+    EXPECT_EQ(cgroup_get(CGROUP_ROOT)->committed, 3);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 0);
+    EXPECT_EQ(cgroup_create(CGROUP_ROOT, 0, 2), -3);
+    EXPECT_EQ(cgroup_set_limit(CGROUP_ROOT, 2), -2);
+
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    EXPECT_EQ(cgroup_headroom(other), 1);
+    EXPECT_EQ(cgroup_headroom(pid), 4);
+    Fault(other, 2);
+    EXPECT_EQ(cgroup_task_usage(other), 1) << "Expected the reserved frames to stay out of reach";
+
+    Fault(pid, 3);
+    EXPECT_EQ(cgroup_task_usage(pid), 3);
+    EXPECT_EQ(cgroup_get(CGROUP_ROOT)->committed, 4);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 4);
+
+    ASSERT_EQ(destroy_task(pid), 0);
+    EXPECT_EQ(cgroup_get(CGROUP_ROOT)->committed, 4) << "Expected the reservation to stay held";
+    ASSERT_EQ(cgroup_destroy(group), 0);
+    EXPECT_EQ(cgroup_get(CGROUP_ROOT)->committed, 1);
+}
+
+TEST_F(CgroupTest, ReservationMustFitLimit)
+{
+    EXPECT_EQ(cgroup_create(CGROUP_ROOT, 2, 3), -3);
+    const int group = cgroup_create(CGROUP_ROOT, 4, 3);
+    EXPECT_EQ(cgroup_set_limit(group, 2), -2);
+}
+
+TEST_F(CgroupTest, AttachMovesCharges)
+{
+    const int small = cgroup_create(CGROUP_ROOT, 2, 0);
+    const int large = cgroup_create(CGROUP_ROOT, 4, 0);
+    Fault(pid, 3);
+
+    EXPECT_EQ(cgroup_attach(pid, small), -2);
+    EXPECT_EQ(cgroup_of(pid), CGROUP_ROOT);
+    ASSERT_EQ(cgroup_attach(pid, large), 0);
+    EXPECT_EQ(cgroup_usage(large), 3);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 3);
+
+    ASSERT_EQ(cgroup_attach(pid, CGROUP_ROOT), 0);
+    EXPECT_EQ(cgroup_usage(large), 0);
+    EXPECT_EQ(cgroup_get(large)->tasks, 0);
+}
+
+TEST_F(CgroupTest, ReclaimUncharges)
+{
+    const int group = cgroup_create(CGROUP_ROOT, 0, 0);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    Fault(pid, 4);
+    ram_set_watermarks(ram_free_frames() + 1, ram_free_frames() + 2);
+
+    EXPECT_EQ(pager_reclaim(), 2);
+    EXPECT_EQ(cgroup_usage(group), 2);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 2);
+}
+
+TEST_F(CgroupTest, BatchStopsAtLimit)
+{
+    const int group = cgroup_create(CGROUP_ROOT, 2, 0);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    const tVirtAddr addresses[] = {0, PAGE_SIZE, PAGE_SIZE * 2, PAGE_SIZE * 3};
+
+    EXPECT_EQ(page_fault_batch(pid, addresses, 4), 2);
+    EXPECT_EQ(cgroup_usage(group), 2);
+    EXPECT_EQ(pager_get_stats()->direct_reclaims, 0u);
+}
+
+TEST_F(CgroupTest, LargePageFallsBackAtLimit)
+{
+    const int group = cgroup_create(CGROUP_ROOT, 1, 0);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    ASSERT_EQ(set_large_pages(pid, 1), 0);
+
+    EXPECT_EQ(page_fault(pid, 0), 0);
+    EXPECT_EQ(pager_get_stats()->large_fallbacks, 1u);
+    EXPECT_EQ(cgroup_usage(group), 1);
+}
+
+TEST_F(CgroupTest, TaskManagerResetsGroups)
+{
+    const int group = cgroup_create(CGROUP_ROOT, 1, 0);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    destroy_taskMgr();
+
+    ASSERT_EQ(init_taskMgr(), 0);
+    EXPECT_EQ(cgroup_get(group), nullptr);
+    EXPECT_EQ(cgroup_get(CGROUP_ROOT)->limit, 0);
+}
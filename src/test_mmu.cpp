@@ -55,7 +55,7 @@ TEST_F(MMUTest, GetPhysicalAddressFailsWithNullPointer)
 
 TEST_F(MMUTest, GetPhysicalAddressFailsWithoutPageTable)
 {
-    uint16_t phys = 0;
+    tRamSize phys = 0;
     set_page_table(nullptr);
     int ret = get_physical_address(0x1234, &phys);
     EXPECT_EQ(ret, -4);
@@ -64,7 +64,7 @@ TEST_F(MMUTest, GetPhysicalAddressFailsWithoutPageTable)
 
 TEST_F(MMUTest, GetPhysicalAddressFailsWithoutRamInit)
 {
-    uint16_t phys = 0;
+    tRamSize phys = 0;
     destroy_ram();
     int ret = get_physical_address(0x1234, &phys);
     EXPECT_EQ(ret, -5);
@@ -73,7 +73,7 @@ TEST_F(MMUTest, GetPhysicalAddressFailsWithoutRamInit)
 
 TEST_F(MMUTest, GetPhysicalAddressSegFaultOnRWX000)
 {
-    uint16_t phys = 0;
+    tRamSize phys = 0;
     int ret = get_physical_address(0x1234, &phys);
     EXPECT_EQ(ret, -2);
     EXPECT_EQ(phys, 0);
@@ -81,7 +81,7 @@ TEST_F(MMUTest, GetPhysicalAddressSegFaultOnRWX000)
 
 TEST_F(MMUTest, GetPhysicalAddressPageFaultOnP0)
 {
-    uint16_t phys = 0;
+    tRamSize phys = 0;
     SetTableEntry(0x1234 / PAGE_SIZE, {.r = 0x1});
 
     int ret = get_physical_address(0x1234, &phys);
@@ -91,8 +91,8 @@ TEST_F(MMUTest, GetPhysicalAddressPageFaultOnP0)
 
 TEST_F(MMUTest, GetPhysicalAddressSuccessOnP1FrameId0)
 {
-    uint16_t phys = 0;
-    uint16_t exp_phys = 0x1234 & OFFSET_MASK;
+    tRamSize phys = 0;
+    tRamSize exp_phys = 0x1234 & OFFSET_MASK;
     SetTableEntry(0x1234 / PAGE_SIZE, {.r = 0x1, .p_bit = 0x1});
 
     int ret = get_physical_address(0x1234, &phys);
@@ -102,8 +102,8 @@ TEST_F(MMUTest, GetPhysicalAddressSuccessOnP1FrameId0)
 
 TEST_F(MMUTest, GetPhysicalAddressSuccessOnP1FrameIdMAX)
 {
-    uint16_t phys = 0;
-    uint16_t exp_phys = (NUM_FRAMES - 1) * PAGE_SIZE + (0x1234 & OFFSET_MASK);
+    tRamSize phys = 0;
+    tRamSize exp_phys = (NUM_FRAMES - 1) * PAGE_SIZE + (0x1234 & OFFSET_MASK);
     SetTableEntry(0x1234 / PAGE_SIZE, {.r = 0x1, .p_bit = 0x1, .frame_id = NUM_FRAMES - 1});
 
     int ret = get_physical_address(0x1234, &phys);
@@ -113,8 +113,8 @@ TEST_F(MMUTest, GetPhysicalAddressSuccessOnP1FrameIdMAX)
 
 TEST_F(MMUTest, GetPhysicalAddressSuccessOnP1FrameId)
 {
-    uint16_t phys = 0;
-    uint16_t exp_phys = 55 * PAGE_SIZE + (0x1234 & OFFSET_MASK);
+    tRamSize phys = 0;
+    tRamSize exp_phys = 55 * PAGE_SIZE + (0x1234 & OFFSET_MASK);
     SetTableEntry(0x1234 / PAGE_SIZE, {.r = 0x1, .p_bit = 0x1, .frame_id = 55});
 
     int ret = get_physical_address(0x1234, &phys);
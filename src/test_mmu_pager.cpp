@@ -62,13 +62,13 @@ class MMUPagerTest : public RamTestBase
 
 TEST_F(MMUPagerTest, GetPhysicalAddressSuccessAfterPageFault)
 {
-    uint16_t phys = 0;
+    tRamSize phys = 0;
     uint16_t addr = PAGE_SIZE * 1 + 15;
     int page_fault_res = page_fault(task->pid, addr);
     ASSERT_EQ(page_fault_res, OK);
     int get_physical_address_res = get_physical_address(addr, &phys);
     EXPECT_EQ(get_physical_address_res, 0);
-    uint16_t frame = task->page_table[1].frame_id * PAGE_SIZE;
+    tFrameId frame = task->page_table[1].frame_id * PAGE_SIZE;
     EXPECT_EQ(phys, frame + (addr & OFFSET_MASK));
     EXPECT_EQ(task->page_table[1].p_bit, 0x1); 
 }
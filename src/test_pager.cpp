@@ -1,12 +1,15 @@
 #include <cstring>  // for memset
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "test_ram.h"
 
 extern "C" {
+#include "mmu.h"
 #include "pager.h"
 #include "task.h"
 #include "types.h"
+#include "wss.h"
 }
 
 class PagerTest : public RamTestBase
@@ -47,7 +50,7 @@ class PagerTest : public RamTestBase
         const uint8_t p_bit = task->page_table[page_id].p_bit;
         ASSERT_EQ(p_bit, 0x1) << "Page Expected in ram";
 
-        const uint16_t frame_id = task->page_table[page_id].frame_id;
+        const tFrameId frame_id = task->page_table[page_id].frame_id;
         ASSERT_LT(frame_id, NUM_FRAMES) << "Stored frame_id is outside of reserved memory for ram";
 
         const uint8_t *frame = (ram + task->page_table[page_id].frame_id * PAGE_SIZE);
@@ -108,7 +111,7 @@ TEST_F(PagerTest, PageFaultOutOfFrames)
     const uint16_t used_frames = getOccupiedFrames(nullptr);
 
     // Allocate all remaining pages
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, NUM_FRAMES - used_frames);
     ASSERT_EQ(ret, 0);
 
@@ -189,24 +192,24 @@ TEST_F(PagerTest, PageFaultWritesMorePagesToRam)
 
 TEST_F(NRUTest, NoRecentNorModifiedPages)
 {
-    uint16_t frame_id1 = task->page_table[1].frame_id;
-    uint16_t frame_id2 = task->page_table[2].frame_id;
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    tFrameId frame_id2 = task->page_table[2].frame_id;
     int result = page_fault(pid, PAGE_SIZE * 7);
     EXPECT_EQ(result, 0);
     uint8_t p_bit1 = task->page_table[1].p_bit;
     uint8_t p_bit2 = task->page_table[2].p_bit;
     uint8_t p_bit7 = task->page_table[7].p_bit;
-    uint16_t frame_id7 = task->page_table[7].frame_id;
+    tFrameId frame_id7 = task->page_table[7].frame_id;
     EXPECT_NE(p_bit1, p_bit2) << "Expected one of present pages to be evicted";
     EXPECT_EQ(p_bit7, 0x1) << "Expected new page present in ram";
-    uint16_t evicted_frame_id = (p_bit1 == 0) ? frame_id1 : frame_id2;
+    tFrameId evicted_frame_id = (p_bit1 == 0) ? frame_id1 : frame_id2;
     EXPECT_EQ(frame_id7, evicted_frame_id) << "Expected frame_id of evicted page used by new page";
     CheckPagePresentInRam(7);
 }
 
 TEST_F(NRUTest, OneRecentPage)
 {
-    uint16_t frame_id2 = task->page_table[2].frame_id;
+    tFrameId frame_id2 = task->page_table[2].frame_id;
     task->page_table[1].r_bit = 0x1;
     int result = page_fault(pid, PAGE_SIZE * 7);
     EXPECT_EQ(result, 0);
@@ -214,7 +217,7 @@ TEST_F(NRUTest, OneRecentPage)
     uint8_t r_bit1 = task->page_table[1].r_bit;
     uint8_t p_bit2 = task->page_table[2].p_bit;
     uint8_t p_bit7 = task->page_table[7].p_bit;
-    uint16_t frame_id7 = task->page_table[7].frame_id;
+    tFrameId frame_id7 = task->page_table[7].frame_id;
     EXPECT_EQ(p_bit2, 0x0) << "Expected not accessed page to be evicted";
     EXPECT_EQ(p_bit1, 0x1) << "Expected recent page to stay";
     EXPECT_EQ(r_bit1, 0x0) << "Expected recent page r_bit cleared";
@@ -225,8 +228,8 @@ TEST_F(NRUTest, OneRecentPage)
 
 TEST_F(NRUTest, OneModifiedPage)
 {
-    uint16_t frame_id1 = task->page_table[1].frame_id;
-    uint16_t frame_id2 = task->page_table[2].frame_id;
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    tFrameId frame_id2 = task->page_table[2].frame_id;
     task->page_table[2].m_bit = 0x1;
     ram[frame_id2 * PAGE_SIZE + frame_id2] = frame_id2;
 
@@ -236,7 +239,7 @@ TEST_F(NRUTest, OneModifiedPage)
     uint8_t m_bit2 = task->page_table[2].m_bit;
     uint8_t p_bit2 = task->page_table[2].p_bit;
     uint8_t p_bit7 = task->page_table[7].p_bit;
-    uint16_t frame_id7 = task->page_table[7].frame_id;
+    tFrameId frame_id7 = task->page_table[7].frame_id;
     EXPECT_EQ(p_bit1, 0x0) << "Expected not accessed page to be evicted";
     EXPECT_EQ(p_bit2, 0x1) << "Expected modified page to stay";
     EXPECT_EQ(m_bit2, 0x0) << "Expected modified page m_bit cleared";
@@ -248,8 +251,8 @@ TEST_F(NRUTest, OneModifiedPage)
 
 TEST_F(NRUTest, AllRecentPages)
 {
-    uint16_t frame_id1 = task->page_table[1].frame_id;
-    uint16_t frame_id2 = task->page_table[2].frame_id;
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    tFrameId frame_id2 = task->page_table[2].frame_id;
     task->page_table[1].r_bit = 0x1;
     task->page_table[2].r_bit = 0x1;
 
@@ -260,20 +263,20 @@ TEST_F(NRUTest, AllRecentPages)
     uint8_t r_bit2 = task->page_table[2].r_bit;
     uint8_t p_bit2 = task->page_table[2].p_bit;
     uint8_t p_bit7 = task->page_table[7].p_bit;
-    uint16_t frame_id7 = task->page_table[7].frame_id;
+    tFrameId frame_id7 = task->page_table[7].frame_id;
     EXPECT_NE(p_bit1, p_bit2) << "Expected one of pages to be evicted";
     EXPECT_EQ(r_bit1, 0x0) << "Expected recent page r_bit cleared";
     EXPECT_EQ(r_bit2, 0x0) << "Expected recent page r_bit cleared";
     EXPECT_EQ(p_bit7, 0x1) << "Expected new page present in ram";
-    uint16_t evicted_frame_id = (p_bit1) ? frame_id2 : frame_id1;
+    tFrameId evicted_frame_id = (p_bit1) ? frame_id2 : frame_id1;
     EXPECT_EQ(frame_id7, evicted_frame_id) << "Expected frame_id of evicted page used by new page";
     CheckPagePresentInRam(7);
 }
 
 TEST_F(NRUTest, AllModifiedPages)
 {
-    uint16_t frame_id1 = task->page_table[1].frame_id;
-    uint16_t frame_id2 = task->page_table[2].frame_id;
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    tFrameId frame_id2 = task->page_table[2].frame_id;
     task->page_table[1].m_bit = 0x1;
     task->page_table[2].m_bit = 0x1;
     ram[frame_id1 * PAGE_SIZE + frame_id1] = frame_id1;
@@ -286,12 +289,12 @@ TEST_F(NRUTest, AllModifiedPages)
     uint8_t m_bit2 = task->page_table[2].m_bit;
     uint8_t p_bit2 = task->page_table[2].p_bit;
     uint8_t p_bit7 = task->page_table[7].p_bit;
-    uint16_t frame_id7 = task->page_table[7].frame_id;
+    tFrameId frame_id7 = task->page_table[7].frame_id;
     EXPECT_NE(p_bit1, p_bit2) << "Expected one of pages to be evicted";
     EXPECT_EQ(m_bit1, 0x0) << "Expected modified page m_bit cleared";
     EXPECT_EQ(m_bit2, 0x0) << "Expected modified page m_bit cleared";
     EXPECT_EQ(p_bit7, 0x1) << "Expected new page present in ram";
-    const uint16_t evicted_frame_id = (p_bit1) ? frame_id2 : frame_id1;
+    const tFrameId evicted_frame_id = (p_bit1) ? frame_id2 : frame_id1;
     const uint16_t evicted_page_id = (p_bit1) ? 2 : 1;
     EXPECT_EQ(frame_id7, evicted_frame_id) << "Expected frame_id of evicted page used by new page";
     CheckPagePresentInRam(7);
@@ -302,8 +305,8 @@ TEST_F(NRUTest, AllModifiedPages)
 
 TEST_F(NRUTest, OneRecentAndOneModifiedPage)
 {
-    uint16_t frame_id1 = task->page_table[1].frame_id;
-    uint16_t frame_id2 = task->page_table[2].frame_id;
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    tFrameId frame_id2 = task->page_table[2].frame_id;
     task->page_table[1].m_bit = 0x1;
     task->page_table[2].r_bit = 0x1;
     ram[frame_id1 * PAGE_SIZE + frame_id1] = frame_id1;
@@ -315,12 +318,12 @@ TEST_F(NRUTest, OneRecentAndOneModifiedPage)
     uint8_t r_bit2 = task->page_table[2].m_bit;
     uint8_t p_bit2 = task->page_table[2].p_bit;
     uint8_t p_bit7 = task->page_table[7].p_bit;
-    uint16_t frame_id7 = task->page_table[7].frame_id;
+    tFrameId frame_id7 = task->page_table[7].frame_id;
     EXPECT_NE(p_bit1, p_bit2) << "Expected one of pages to be evicted";
     EXPECT_EQ(r_bit1, 0x0) << "Expected recent page r_bit cleared";
     EXPECT_EQ(r_bit2, 0x0) << "Expected recent page r_bit cleared";
     EXPECT_EQ(p_bit7, 0x1) << "Expected new page present in ram";
-    uint16_t evicted_frame_id = (p_bit1) ? frame_id2 : frame_id1;
+    tFrameId evicted_frame_id = (p_bit1) ? frame_id2 : frame_id1;
     EXPECT_EQ(frame_id7, evicted_frame_id) << "Expected frame_id of evicted page used by new page";
     CheckPagePresentInRam(7);
     bool address_space_modified = address_space[PAGE_SIZE * 1 + frame_id1] == frame_id1;
@@ -329,8 +332,8 @@ TEST_F(NRUTest, OneRecentAndOneModifiedPage)
 
 TEST_F(NRUTest, OneRecentModifiedAndOneRecentPage)
 {
-    uint16_t frame_id1 = task->page_table[1].frame_id;
-    uint16_t frame_id2 = task->page_table[2].frame_id;
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    tFrameId frame_id2 = task->page_table[2].frame_id;
     task->page_table[1].m_bit = 0x1;
     task->page_table[1].r_bit = 0x1;
     task->page_table[2].r_bit = 0x1;
@@ -343,15 +346,1005 @@ TEST_F(NRUTest, OneRecentModifiedAndOneRecentPage)
     uint8_t r_bit2 = task->page_table[2].m_bit;
     uint8_t p_bit2 = task->page_table[2].p_bit;
     uint8_t p_bit7 = task->page_table[7].p_bit;
-    uint16_t frame_id7 = task->page_table[7].frame_id;
+    tFrameId frame_id7 = task->page_table[7].frame_id;
     EXPECT_NE(p_bit1, p_bit2) << "Expected one of pages to be evicted";
     EXPECT_EQ(p_bit2, 0x0);
     EXPECT_EQ(r_bit1, 0x0) << "Expected recent page r_bit cleared";
     EXPECT_EQ(r_bit2, 0x0) << "Expected recent page r_bit cleared";
     EXPECT_EQ(p_bit7, 0x1) << "Expected new page present in ram";
-    uint16_t evicted_frame_id = frame_id2;
+    tFrameId evicted_frame_id = frame_id2;
     EXPECT_EQ(frame_id7, evicted_frame_id) << "Expected frame_id of evicted page used by new page";
     CheckPagePresentInRam(7);
     bool address_space_modified = address_space[PAGE_SIZE * 1 + frame_id1] == frame_id1;
     EXPECT_EQ(address_space_modified, true) << "Expected that modified and evicted page written to address_space";
 }
+
+class AgingTest : public NRUTest
+{
+  protected:
+    void SetUp() override
+    {
+        NRUTest::SetUp();
+        ASSERT_EQ(set_replacement_policy(pid, PAGER_POLICY_AGING), 0);
+    }
+};
+
+TEST_F(PagerTest, SetPolicyTaskNotFound)
+{
+    EXPECT_EQ(set_replacement_policy(pid + 1, PAGER_POLICY_AGING), -1);
+}
+
+TEST_F(PagerTest, SetPolicyUnknownPolicy)
+{
+    EXPECT_EQ(set_replacement_policy(pid, 0xff), -2);
+    EXPECT_EQ(task->policy, PAGER_POLICY_NRU);
+}
+
+TEST_F(NRUTest, ForgetsReferencesOlderThanLastFault)
+{
+    // page 1 was referenced during the previous interval only, NRU sees both pages in the same class
+    task->page_table[1].r_bit = 0x1;
+    ASSERT_EQ(wss_tick(), 0);
+    int result = page_fault(pid, PAGE_SIZE * 7);
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0) << "Expected first page of the lowest class evicted";
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+}
+
+TEST_F(AgingTest, KeepsReferencesOlderThanLastFault)
+{
+    tFrameId frame_id2 = task->page_table[2].frame_id;
+    task->page_table[1].r_bit = 0x1;
+    ASSERT_EQ(wss_tick(), 0);
+    int result = page_fault(pid, PAGE_SIZE * 7);
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x1) << "Expected page referenced in the past to stay";
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0) << "Expected page with the lowest counter evicted";
+    EXPECT_EQ(task->page_table[7].frame_id, frame_id2);
+    CheckPagePresentInRam(7);
+}
+
+TEST_F(AgingTest, RecentReferenceOutweighsOlderOnes)
+{
+    task->page_table[1].r_bit = 0x1;
+    ASSERT_EQ(wss_tick(), 0);
+    task->page_table[2].r_bit = 0x1;
+    int result = page_fault(pid, PAGE_SIZE * 7);
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0) << "Expected page referenced longer ago evicted";
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+    EXPECT_EQ(task->page_table[2].r_bit, 0x0) << "Expected r_bit cleared";
+}
+
+TEST_F(AgingTest, ModifiedVictimWrittenBack)
+{
+    tFrameId frame_id2 = task->page_table[2].frame_id;
+    task->page_table[1].r_bit = 0x1;
+    task->page_table[2].m_bit = 0x1;
+    ram[frame_id2 * PAGE_SIZE] = 0x42;
+    int result = page_fault(pid, PAGE_SIZE * 7);
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0);
+    EXPECT_EQ(address_space[PAGE_SIZE * 2], 0x42) << "Expected evicted modified page written to address_space";
+}
+
+class ClockTest : public NRUTest
+{
+  protected:
+    void SetUp() override
+    {
+        pager_set_clock(1);
+        NRUTest::SetUp();
+    }
+
+    void TearDown() override
+    {
+        pager_set_clock(0);
+        pager_set_flush_watermark(0);
+        NRUTest::TearDown();
+    }
+};
+
+TEST(PagerTest_NoTaskMgr, TickFails)
+{
+    EXPECT_EQ(pager_tick(), -1);
+}
+
+TEST_F(ClockTest, PageFaultKeepsReferenceBits)
+{
+    task->page_table[1].r_bit = 0x1;
+    task->page_table[2].r_bit = 0x1;
+    task->page_table[2].m_bit = 0x1;
+    task->max_frames = 3;
+    int result = page_fault(pid, PAGE_SIZE * 7);
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(task->page_table[1].r_bit, 0x1) << "Expected r_bit kept until the next tick";
+    EXPECT_EQ(task->page_table[2].r_bit, 0x1) << "Expected r_bit kept until the next tick";
+    EXPECT_EQ(task->page_table[2].m_bit, 0x1) << "Expected m_bit kept until written back by a tick";
+    CheckPagePresentInRam(7);
+}
+
+TEST_F(ClockTest, ReferencedPageSurvivesSeveralFaults)
+{
+    task->page_table[2].r_bit = 0x1;
+    SetWritablePageEntry(3);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 7), 0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    EXPECT_EQ(task->page_table[7].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1) << "Expected referenced page to stay until the next tick";
+}
+
+TEST_F(ClockTest, EvictedModifiedPageWrittenBack)
+{
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    task->page_table[1].m_bit = 0x1;
+    task->page_table[2].r_bit = 0x1;
+    ram[frame_id1 * PAGE_SIZE] = 0x42;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 7), 0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[1].m_bit, 0x0);
+    EXPECT_EQ(address_space[PAGE_SIZE * 1], 0x42) << "Expected evicted modified page written to address_space";
+}
+
+TEST_F(ClockTest, TickClearsReferenceBitsAndWritesBack)
+{
+    tFrameId frame_id1 = task->page_table[1].frame_id;
+    task->page_table[1].r_bit = 0x1;
+    task->page_table[1].m_bit = 0x1;
+    task->page_table[2].r_bit = 0x1;
+    ram[frame_id1 * PAGE_SIZE] = 0x42;
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(task->page_table[1].r_bit, 0x0);
+    EXPECT_EQ(task->page_table[2].r_bit, 0x0);
+    EXPECT_EQ(task->page_table[1].m_bit, 0x0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x1) << "Expected written back page to stay in ram";
+    EXPECT_EQ(address_space[PAGE_SIZE * 1], 0x42) << "Expected modified page written to address_space";
+    EXPECT_EQ(task->age[1], task->age[2]);
+    EXPECT_GE(task->age[1], 0x80);
+}
+
+TEST_F(ClockTest, TickWritesBackInBatches)
+{
+    task->max_frames = 0;
+    for (uint8_t id = 3; id < PAGE_TABLE_SIZE; id++)
+    {
+        SetWritablePageEntry(id);
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+    }
+    uint8_t dirty = 0;
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        task->page_table[id].m_bit = task->page_table[id].p_bit;
+        dirty += task->page_table[id].m_bit;
+    }
+    ASSERT_GT(dirty, PAGER_FLUSH_BATCH);
+
+    for (uint8_t tick = 1; dirty > 0; tick++)
+    {
+        ASSERT_EQ(pager_tick(), 0);
+        uint8_t left = 0;
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            left += task->page_table[id].m_bit;
+        }
+        EXPECT_EQ(left, (dirty > PAGER_FLUSH_BATCH) ? dirty - PAGER_FLUSH_BATCH : 0);
+        dirty = left;
+    }
+}
+
+TEST_F(ClockTest, TickSkipsWriteBackAboveWatermark)
+{
+    task->page_table[1].m_bit = 0x1;
+    pager_set_flush_watermark(1);
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(task->page_table[1].m_bit, 0x1) << "Expected no write-back while enough frames are free";
+
+    pager_set_flush_watermark(NUM_FRAMES);
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(task->page_table[1].m_bit, 0x0) << "Expected write-back below the watermark";
+}
+
+TEST_F(ClockTest, StatsCountCleanAndDirtyVictims)
+{
+    SetWritablePageEntry(3);
+    pager_reset_stats();
+    task->page_table[1].m_bit = 0x1;
+    task->page_table[2].m_bit = 0x1;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 7), 0);
+    EXPECT_EQ(pager_get_stats()->dirty_victims, 1u);
+    EXPECT_EQ(pager_get_stats()->clean_victims, 0u);
+
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(pager_get_stats()->flushed_pages, 1u);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    EXPECT_EQ(pager_get_stats()->dirty_victims, 1u);
+    EXPECT_EQ(pager_get_stats()->clean_victims, 1u) << "Expected victim written back by the tick";
+    EXPECT_EQ(pager_get_stats()->faults, 2u);
+}
+
+class ReclaimTest : public NRUTest
+{
+  protected:
+    void SetUp() override
+    {
+        NRUTest::SetUp();
+        // Leave no free frame in RAM
+        tFrameId frame_id = 0;
+        ASSERT_EQ(falloc(&frame_id, ram_free_frames()), 0);
+        pager_reset_stats();
+    }
+};
+
+TEST(PagerTest_NoTaskMgr, ReclaimFails)
+{
+    EXPECT_EQ(pager_reclaim(), -1);
+}
+
+TEST_F(ReclaimTest, NothingToDoAboveHighWatermark)
+{
+    EXPECT_EQ(pager_reclaim(), 0) << "Expected no reclaim without watermarks";
+    EXPECT_EQ(task->page_table[1].p_bit, 0x1);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+}
+
+TEST_F(ReclaimTest, EvictsUntilHighWatermark)
+{
+    ASSERT_EQ(ram_set_watermarks(1, 2), 0);
+    EXPECT_EQ(pager_reclaim(), 2);
+    EXPECT_EQ(ram_free_frames(), 2);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0);
+    EXPECT_EQ(pager_get_stats()->reclaimed_pages, 2u);
+    EXPECT_EQ(pager_get_stats()->reclaim_scans, 2u);
+}
+
+TEST_F(ReclaimTest, EvictsColdPagesFirst)
+{
+    tFrameId frame_id2 = task->page_table[2].frame_id;
+    task->page_table[1].m_bit = 0x1;
+    task->page_table[2].r_bit = 0x1;
+    ram[task->page_table[1].frame_id * PAGE_SIZE] = 0x42;
+    ASSERT_EQ(ram_set_watermarks(1, 1), 0);
+    EXPECT_EQ(pager_reclaim(), 1);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0) << "Expected not referenced page evicted";
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+    EXPECT_EQ(address_space[PAGE_SIZE * 1], 0x42) << "Expected evicted modified page written to address_space";
+
+    // reclaimed frame is used by the next fault without eviction
+    task->max_frames = 0;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 7), 0);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+    EXPECT_NE(task->page_table[7].frame_id, frame_id2);
+    EXPECT_EQ(pager_get_stats()->direct_reclaims, 0u);
+}
+
+TEST_F(ReclaimTest, TickReclaimsBelowLowWatermark)
+{
+    ASSERT_EQ(ram_set_watermarks(1, 1), 0);
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(ram_free_frames(), 1);
+    EXPECT_EQ(pager_get_stats()->reclaimed_pages, 1u);
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(pager_get_stats()->reclaimed_pages, 1u) << "Expected no reclaim at the low watermark";
+}
+
+TEST_F(ReclaimTest, FaultWithoutFreeFrameIsDirectReclaim)
+{
+    task->max_frames = 0;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 7), 0);
+    EXPECT_EQ(pager_get_stats()->direct_reclaims, 1u);
+    EXPECT_GT(pager_get_stats()->direct_reclaim_ns, 0u);
+
+    task->max_frames = 2;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+    EXPECT_EQ(pager_get_stats()->direct_reclaims, 1u) << "Expected eviction due to max_frames not counted";
+}
+
+// --- page_fault_batch() tests ---
+
+TEST_F(PagerTest, BatchLoadsAllPages)
+{
+    SetWritablePageEntry(1);
+    SetWritablePageEntry(3);
+    task->max_frames = 0;
+    const tVirtAddr addrs[] = {PAGE_SIZE * 3, PAGE_SIZE * 1 + 5, PAGE_SIZE * 3 + 1};
+    pager_reset_stats();
+    EXPECT_EQ(page_fault_batch(pid, addrs, 3), 2) << "Expected repeated page loaded once";
+    CheckPagePresentInRam(1);
+    CheckPagePresentInRam(3);
+    EXPECT_EQ(pager_get_stats()->faults, 2u);
+    EXPECT_EQ(page_fault_batch(pid, addrs, 3), 0) << "Expected present pages skipped";
+}
+
+TEST_F(PagerTest, BatchSegmentationFaultLoadsNothing)
+{
+    SetWritablePageEntry(1);
+    const tVirtAddr addrs[] = {PAGE_SIZE * 1, PAGE_SIZE * 2};
+    EXPECT_EQ(page_fault_batch(pid, addrs, 2), -4);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+
+    const tVirtAddr outside[] = {PAGE_SIZE * 1, PAGE_SIZE * PAGE_TABLE_SIZE};
+    EXPECT_EQ(page_fault_batch(pid, outside, 2), -4);
+    EXPECT_EQ(page_fault_batch(pid, nullptr, 1), -4);
+    EXPECT_EQ(page_fault_batch(pid, nullptr, 0), 0);
+}
+
+TEST_F(PagerTest, BatchTaskNotFound)
+{
+    const tVirtAddr addrs[] = {PAGE_SIZE};
+    destroy_task(pid);
+    EXPECT_EQ(page_fault_batch(pid, addrs, 1), -1);
+}
+
+TEST_F(PagerTest, BatchOutOfFrames)
+{
+    SetWritablePageEntry(0);
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, ram_free_frames()), 0);
+    const tVirtAddr addrs[] = {0};
+    EXPECT_EQ(page_fault_batch(pid, addrs, 1), -3);
+}
+
+TEST_F(NRUTest, BatchEvictsVictimsInNruOrder)
+{
+    SetWritablePageEntry(3);
+    SetWritablePageEntry(4);
+    task->page_table[1].r_bit = 0x1;
+    task->page_table[2].r_bit = 0x1;
+    task->page_table[2].m_bit = 0x1;
+    ram[task->page_table[2].frame_id * PAGE_SIZE] = 0x42;
+    pager_reset_stats();
+
+    // max_frames is 2 and both frames are taken, one page is loaded over the NRU victim
+    const tVirtAddr addrs[] = {PAGE_SIZE * 7};
+    ASSERT_EQ(page_fault_batch(pid, addrs, 1), 1);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0) << "Expected referenced clean page evicted first";
+    EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+    CheckPagePresentInRam(7);
+
+    // both pages are replaced, the modified one is written back
+    const tVirtAddr more[] = {PAGE_SIZE * 3, PAGE_SIZE * 4};
+    ASSERT_EQ(page_fault_batch(pid, more, 2), 2);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[7].p_bit, 0x0);
+    EXPECT_EQ(address_space[PAGE_SIZE * 2], 0x42);
+    CheckPagePresentInRam(3);
+    CheckPagePresentInRam(4);
+    EXPECT_EQ(pager_get_stats()->faults, 3u);
+    EXPECT_EQ(pager_get_stats()->clean_victims + pager_get_stats()->dirty_victims, 3u);
+}
+
+TEST_F(NRUTest, BatchLoadsFirstPagesWhenFramesRunOut)
+{
+    SetWritablePageEntry(3);
+    SetWritablePageEntry(4);
+    SetWritablePageEntry(5);
+    const tVirtAddr addrs[] = {PAGE_SIZE * 5, PAGE_SIZE * 4, PAGE_SIZE * 3};
+    EXPECT_EQ(page_fault_batch(pid, addrs, 3), 2) << "Expected only max_frames pages loaded";
+    CheckPagePresentInRam(3);
+    CheckPagePresentInRam(4);
+    EXPECT_EQ(task->page_table[5].p_bit, 0x0);
+}
+
+TEST_F(ReclaimTest, BatchWithoutFreeFramesIsOneDirectReclaim)
+{
+    SetWritablePageEntry(3);
+    task->max_frames = 0;
+    const tVirtAddr addrs[] = {PAGE_SIZE * 3, PAGE_SIZE * 7};
+    ASSERT_EQ(page_fault_batch(pid, addrs, 2), 2);
+    EXPECT_EQ(pager_get_stats()->direct_reclaims, 1u);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0);
+}
+
+// --- pager_compact() tests ---
+
+class CompactTest : public PagerTest
+{
+  protected:
+    // Loads pages 1..5 in consecutive frames, then unloads pages 1 and 3, leaving holes below pages 4 and 5.
+    void SetUp() override
+    {
+        PagerTest::SetUp();
+        task->max_frames = 0;
+        for (uint8_t id = 1; id <= 5; id++)
+        {
+            SetWritablePageEntry(id);
+            ASSERT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+        }
+        for (uint8_t id : {1, 3})
+        {
+            ffree(task->page_table[id].frame_id, 1);
+            task->page_table[id].p_bit = 0x0;
+        }
+        hole = task->page_table[1].frame_id;
+        pager_reset_stats();
+    }
+
+    void TearDown() override
+    {
+        pager_set_compaction(0);
+        set_page_table(nullptr);
+        PagerTest::TearDown();
+    }
+
+    tFrameId hole;
+};
+
+TEST(PagerTest_NoTaskMgr, CompactFails)
+{
+    EXPECT_EQ(pager_compact(1), -1);
+}
+
+TEST_F(CompactTest, MovesHighestPagesIntoHoles)
+{
+    const tFrameId free_frames = ram_free_frames();
+    const tFrameId largest = ram_largest_free_run();
+    const tFrameId frame5 = task->page_table[5].frame_id;
+    ram[frame5 * PAGE_SIZE] = 0x42;  // modified in RAM only
+
+    EXPECT_EQ(pager_compact(1), 1) << "Expected the budget respected";
+    EXPECT_EQ(task->page_table[5].frame_id, hole);
+    EXPECT_EQ(ram[hole * PAGE_SIZE], 0x42) << "Expected frame content moved";
+
+    EXPECT_EQ(pager_compact(8), 1) << "Expected compaction to stop once no hole is below a page";
+    EXPECT_EQ(ram_free_frames(), free_frames);
+    EXPECT_EQ(ram_largest_free_run(), largest + 2);
+    EXPECT_EQ(ram_fragmentation(), 0);
+    EXPECT_EQ(pager_get_stats()->compacted_pages, 2u);
+    CheckPagePresentInRam(4);
+    CheckPagePresentInRam(2);
+}
+
+TEST_F(CompactTest, ActivePageTableSeesMovedFrames)
+{
+    set_page_table(task->page_table);
+    task->page_table[5].r = 0x1;
+    ram[task->page_table[5].frame_id * PAGE_SIZE + 3] = 0x17;
+    ASSERT_EQ(pager_compact(2), 2);
+    uint8_t data = 0;
+    ASSERT_EQ(load_data(PAGE_SIZE * 5 + 3, &data), 0);
+    EXPECT_EQ(data, 0x17);
+    ASSERT_EQ(store_data(PAGE_SIZE * 4, 0x21), 0);
+    EXPECT_EQ(ram[task->page_table[4].frame_id * PAGE_SIZE], 0x21);
+}
+
+TEST_F(CompactTest, PagesInTransitNotMoved)
+{
+    const tFrameId frame5 = task->page_table[5].frame_id;
+    task->page_table[5].p_bit = 0x0;
+    task->page_table[5].t_bit = 0x1;
+    EXPECT_EQ(pager_compact(8), 1);
+    EXPECT_EQ(task->page_table[5].frame_id, frame5);
+    EXPECT_EQ(task->page_table[4].frame_id, hole);
+    task->page_table[5].t_bit = 0x0;
+    task->page_table[5].p_bit = 0x1;
+}
+
+TEST_F(CompactTest, TickCompactsWithinBudget)
+{
+    pager_set_compaction(1);
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(pager_get_stats()->compacted_pages, 1u);
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(pager_get_stats()->compacted_pages, 2u);
+    ASSERT_EQ(pager_tick(), 0);
+    EXPECT_EQ(pager_get_stats()->compacted_pages, 2u);
+}
+
+// --- Large page tests ---
+
+TEST_F(CompactTest, LockedPagesStay)
+{
+    const tFrameId frame4 = task->page_table[4].frame_id;
+    const tFrameId frame5 = task->page_table[5].frame_id;
+    ASSERT_EQ(lock_pages(pid, PAGE_SIZE * 4, PAGE_SIZE * 2), 0);
+
+    EXPECT_EQ(pager_compact(4), 1) << "Expected only page 2 moved";
+    EXPECT_EQ(task->page_table[2].frame_id, hole);
+    EXPECT_EQ(task->page_table[4].frame_id, frame4);
+    EXPECT_EQ(task->page_table[5].frame_id, frame5);
+}
+
+class LargePageTest : public PagerTest
+{
+  protected:
+    void SetUp() override
+    {
+        PagerTest::SetUp();
+        task->max_frames = 0;
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            SetWritablePageEntry(id);
+            task->page_table[id].r = 0x1;
+        }
+        ASSERT_EQ(set_large_pages(pid, 2), 0);
+        pager_reset_stats();
+    }
+
+    void TearDown() override
+    {
+        set_page_table(nullptr);
+        PagerTest::TearDown();
+    }
+};
+
+TEST_F(LargePageTest, SetLargePagesChecksParameters)
+{
+    EXPECT_EQ(set_large_pages(pid + 1, 1), -1);
+    EXPECT_EQ(set_large_pages(pid, PAGER_MAX_LARGE_ORDER + 1), -2);
+    EXPECT_EQ(set_large_pages(pid, PAGER_MAX_LARGE_ORDER), 0);
+    EXPECT_EQ(pager_large_coverage(pid + 1), -1);
+}
+
+TEST_F(LargePageTest, FaultLoadsWholeGroup)
+{
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 5 + 1), 0);
+    const tFrameId first = task->page_table[4].frame_id;
+    for (uint8_t id = 4; id < 8; id++)
+    {
+        CheckPagePresentInRam(id);
+        EXPECT_EQ(task->page_table[id].order, 2);
+        EXPECT_EQ(task->page_table[id].frame_id, first + id - 4) << "Expected consecutive frames";
+    }
+    for (uint8_t id = 0; id < 4; id++)
+    {
+        EXPECT_EQ(task->page_table[id].p_bit, 0x0);
+    }
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 7), -2);
+    EXPECT_EQ(pager_get_stats()->faults, 1u);
+    EXPECT_EQ(pager_get_stats()->large_pages, 1u);
+    EXPECT_EQ(pager_large_coverage(pid), 4);
+
+    set_page_table(task->page_table);
+    uint8_t data = 0;
+    EXPECT_EQ(load_data(PAGE_SIZE * 6, &data), 0) << "Expected the whole group mapped by one fault";
+    EXPECT_EQ(data, address_space[PAGE_SIZE * 6]);
+}
+
+TEST_F(LargePageTest, FallsBackWhenGroupPartlyMapped)
+{
+    ASSERT_EQ(set_large_pages(pid, 0), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+    ASSERT_EQ(set_large_pages(pid, 2), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(task->page_table[2].order, 0);
+    EXPECT_EQ(task->page_table[3].p_bit, 0x0);
+
+    task->page_table[6].w = 0x0;
+    task->page_table[6].r = 0x0;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 5), 0);
+    EXPECT_EQ(task->page_table[4].p_bit, 0x0) << "Expected a base page when a page of the group is inaccessible";
+    EXPECT_EQ(pager_large_coverage(pid), 0);
+    EXPECT_EQ(pager_get_stats()->large_fallbacks, 0u);
+}
+
+TEST_F(LargePageTest, FallsBackWithoutConsecutiveFrames)
+{
+    // Leave only single free frames.
+    std::vector<uint16_t> frames;
+    tFrameId frame_id = 0;
+    while (falloc(&frame_id, 1) == 0)
+    {
+        frames.push_back(frame_id);
+    }
+    for (size_t id = 0; id < frames.size(); id += 2)
+    {
+        ffree(frames[id], 1);
+    }
+    ASSERT_LT(ram_largest_free_run(), 2);
+
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+    CheckPagePresentInRam(1);
+    EXPECT_EQ(task->page_table[0].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[1].order, 0);
+    EXPECT_EQ(pager_get_stats()->large_fallbacks, 1u);
+    EXPECT_EQ(pager_get_stats()->large_pages, 0u);
+}
+
+TEST_F(LargePageTest, FallsBackBelowMaxFrames)
+{
+    task->max_frames = 3;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(pager_large_coverage(pid), 0);
+    EXPECT_EQ(pager_get_stats()->large_fallbacks, 1u);
+}
+
+TEST_F(LargePageTest, EvictionSplitsLargePage)
+{
+    task->max_frames = 4;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+    ASSERT_EQ(pager_large_coverage(pid), 4);
+
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 5), 0);
+    CheckPagePresentInRam(5);
+    EXPECT_EQ(pager_large_coverage(pid), 0) << "Expected the victim's large page split";
+    uint8_t present = 0;
+    for (uint8_t id = 0; id < 4; id++)
+    {
+        present += task->page_table[id].p_bit;
+        EXPECT_EQ(task->page_table[id].order, 0);
+    }
+    EXPECT_EQ(present, 3);
+}
+
+TEST_F(LargePageTest, CompactionKeepsLargePages)
+{
+    tFrameId hole = 0;
+    ASSERT_EQ(falloc(&hole, 1), 0);
+    ASSERT_EQ(page_fault(pid, 0), 0);
+    ffree(hole, 1);
+    const tFrameId first = task->page_table[0].frame_id;
+    ASSERT_GT(first, hole);
+
+    EXPECT_EQ(pager_compact(8), 0);
+    EXPECT_EQ(task->page_table[0].frame_id, first);
+}
+
+class NodeTest : public PagerTest
+{
+  protected:
+    // Four nodes of NUM_FRAMES / 4 frames. The task runs on the last one, which init_ram() and init_taskMgr()
+    // leave free, and the other nodes are three times as far.
+    void SetUp() override
+    {
+        PagerTest::SetUp();
+        task->max_frames = 0;
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            SetWritablePageEntry(id);
+            task->page_table[id].r = 0x1;
+        }
+        const uint8_t weights[] = {3, 3, 3, 2};
+        ASSERT_EQ(ram_set_nodes(4, weights), 0);
+        ASSERT_EQ(set_home_node(pid, HOME), 0);
+        set_mmu_node(HOME);
+        pager_reset_stats();
+        mmu_reset_stats();
+    }
+
+    void TearDown() override
+    {
+        pager_set_migration(0);
+        set_mmu_node(0);
+        set_page_table(nullptr);
+        PagerTest::TearDown();
+    }
+
+    // Reserves all free frames of the node.
+    void FillNode(uint8_t node)
+    {
+        tFrameId frame_id = 0;
+        while (falloc_node(&frame_id, 1, node) == 0)
+            ;
+        ASSERT_EQ(ram_node_free_frames(node), 0);
+    }
+
+    static constexpr uint8_t HOME = 3;
+};
+
+TEST_F(NodeTest, SetHomeNodeChecksParameters)
+{
+    EXPECT_EQ(set_home_node(pid + 1, 0), -1);
+    EXPECT_EQ(set_home_node(pid, 4), -2);
+    EXPECT_EQ(set_home_node(pid, 0), 0);
+}
+
+TEST_F(NodeTest, FaultTakesHomeNodeFrames)
+{
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    CheckPagePresentInRam(2);
+    EXPECT_EQ(ram_frame_node(task->page_table[2].frame_id), HOME);
+    EXPECT_EQ(pager_get_stats()->remote_frames, 0u);
+}
+
+TEST_F(NodeTest, FaultSpillsToOtherNode)
+{
+    FillNode(HOME);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    CheckPagePresentInRam(2);
+    EXPECT_NE(ram_frame_node(task->page_table[2].frame_id), HOME);
+    EXPECT_EQ(pager_get_stats()->remote_frames, 1u);
+}
+
+TEST_F(NodeTest, BatchFillsHomeNodeFirst)
+{
+    FillNode(HOME);
+    ffree(ram_get_node(HOME)->first + 1, 1);
+
+    const tVirtAddr addrs[] = {PAGE_SIZE * 1, PAGE_SIZE * 2};
+    ASSERT_EQ(page_fault_batch(pid, addrs, 2), 2);
+    EXPECT_EQ(task->page_table[1].frame_id, ram_get_node(HOME)->first + 1);
+    EXPECT_NE(ram_frame_node(task->page_table[2].frame_id), HOME);
+    EXPECT_EQ(pager_get_stats()->remote_frames, 1u);
+}
+
+TEST_F(NodeTest, MmuCountsRemoteAccesses)
+{
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    FillNode(HOME);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    set_page_table(task->page_table);
+
+    uint8_t data = 0;
+    ASSERT_EQ(load_data(PAGE_SIZE * 2, &data), 0);
+    ASSERT_EQ(store_data(PAGE_SIZE * 3, 0x42), 0);
+    EXPECT_EQ(mmu_get_stats()->local_accesses, 1u);
+    EXPECT_EQ(mmu_get_stats()->remote_accesses, 1u);
+    EXPECT_EQ(mmu_get_stats()->access_cost, 1u + 3u) << "Expected the weight of the remote node";
+
+    set_mmu_node(0);
+    ASSERT_EQ(load_data(PAGE_SIZE * 2, &data), 0);
+    EXPECT_EQ(mmu_get_stats()->remote_accesses, 2u);
+    EXPECT_EQ(mmu_get_stats()->access_cost, 1u + 3u + 2u);
+}
+
+TEST_F(NodeTest, CompactionStaysInNode)
+{
+    tFrameId hole = 0;
+    ASSERT_EQ(falloc_node(&hole, 1, HOME), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    ffree(hole, 1);
+    const tFrameId frame_id = task->page_table[2].frame_id;
+    ASSERT_GT(frame_id, hole);
+    ASSERT_GT(ram_free_frames(), ram_node_free_frames(HOME)) << "Expected lower free frames in other nodes";
+
+    EXPECT_EQ(pager_compact(8), 1);
+    EXPECT_EQ(task->page_table[2].frame_id, hole) << "Expected the page moved within its node only";
+    CheckPagePresentInRam(2);
+}
+
+class MigrateTest : public NodeTest
+{
+  protected:
+    // Loads page 2 into another node while the home node is full, then frees one frame of the home node.
+    void SetUp() override
+    {
+        NodeTest::SetUp();
+        FillNode(HOME);
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+        ASSERT_NE(ram_frame_node(task->page_table[2].frame_id), HOME);
+        ffree(ram_get_node(HOME)->first, 1);
+        set_page_table(task->page_table);
+        pager_reset_stats();
+    }
+
+    void Access(uint8_t times)
+    {
+        uint8_t data = 0;
+        for (uint8_t cnt = 0; cnt < times; cnt++)
+        {
+            ASSERT_EQ(load_data(PAGE_SIZE * 2, &data), 0);
+        }
+    }
+};
+
+TEST(PagerTest_NoTaskMgr, MigrateFails)
+{
+    EXPECT_EQ(pager_migrate(1), -1);
+}
+
+TEST_F(MigrateTest, MovesHotPageToHomeNode)
+{
+    Access(PAGER_MIGRATE_THRESHOLD);
+    EXPECT_EQ(get_task_remote_hits(task)[2], PAGER_MIGRATE_THRESHOLD);
+    ram[task->page_table[2].frame_id * PAGE_SIZE] = 0x42;  // modified in RAM only
+
+    EXPECT_EQ(pager_migrate(4), 1);
+    EXPECT_EQ(task->page_table[2].frame_id, ram_get_node(HOME)->first);
+    EXPECT_EQ(ram[ram_get_node(HOME)->first * PAGE_SIZE], 0x42) << "Expected frame content moved";
+    EXPECT_EQ(get_task_remote_hits(task)[2], 0);
+    EXPECT_EQ(pager_get_stats()->migrated_pages, 1u);
+    EXPECT_EQ(pager_get_stats()->migrated_bytes, PAGE_SIZE);
+
+    mmu_reset_stats();
+    Access(1);
+    EXPECT_EQ(mmu_get_stats()->local_accesses, 1u) << "Expected the active page table to see the new frame";
+}
+
+TEST_F(MigrateTest, ColdPageStays)
+{
+    Access(PAGER_MIGRATE_THRESHOLD - 1);
+    const tFrameId frame_id = task->page_table[2].frame_id;
+    EXPECT_EQ(pager_migrate(4), 0);
+    EXPECT_EQ(task->page_table[2].frame_id, frame_id);
+    EXPECT_EQ(get_task_remote_hits(task)[2], (PAGER_MIGRATE_THRESHOLD - 1) / 2) << "Expected the counters halved";
+}
+
+TEST_F(MigrateTest, FullHomeNodeKeepsPage)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc_node(&frame_id, 1, HOME), 0);
+    Access(PAGER_MIGRATE_THRESHOLD);
+    EXPECT_EQ(pager_migrate(4), 0);
+    EXPECT_NE(ram_frame_node(task->page_table[2].frame_id), HOME);
+}
+
+TEST_F(MigrateTest, TickMigratesWithinBudget)
+{
+    pager_set_migration(1);
+    Access(PAGER_MIGRATE_THRESHOLD);
+    EXPECT_EQ(pager_tick(), 0);
+    EXPECT_EQ(ram_frame_node(task->page_table[2].frame_id), HOME);
+    EXPECT_EQ(pager_get_stats()->migrated_pages, 1u);
+}
+
+TEST_F(MigrateTest, EvictionResetsCounter)
+{
+    Access(PAGER_MIGRATE_THRESHOLD);
+    task->max_frames = 1;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    ASSERT_EQ(task->page_table[2].p_bit, 0x0) << "Expected page 2 evicted";
+    EXPECT_EQ(get_task_remote_hits(task)[2], 0);
+}
+
+TEST_F(MigrateTest, AttachResetsCounters)
+{
+    Access(PAGER_MIGRATE_THRESHOLD);
+    const tRamSize task_mgr = (const uint8_t *)get_task_mgr() - ram;
+    ASSERT_EQ(attach_taskMgr(task_mgr), 0);
+
+    EXPECT_EQ(get_task_remote_hits(task)[2], 0) << "Expected no counters kept from the previous task manager";
+    EXPECT_EQ(pager_migrate(4), 0);
+}
+
+TEST_F(MigrateTest, LockedPageStays)
+{
+    task->max_frames = 0;
+    ASSERT_EQ(lock_pages(pid, PAGE_SIZE * 2, 1), 0);
+    const tFrameId frame_id = task->page_table[2].frame_id;
+    Access(PAGER_MIGRATE_THRESHOLD);
+    EXPECT_EQ(pager_migrate(4), 0);
+    EXPECT_EQ(task->page_table[2].frame_id, frame_id);
+}
+
+class LockTest : public PagerTest
+{
+  protected:
+    void SetUp() override
+    {
+        PagerTest::SetUp();
+        task->max_frames = 4;
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            task->page_table[id].r = 0x1;
+        }
+        task->page_table[7].r = 0x0;
+        pager_reset_stats();
+    }
+
+    // Takes all free frames of RAM.
+    void FillRam()
+    {
+        tFrameId frame_id = 0;
+        ASSERT_EQ(falloc(&frame_id, ram_free_frames()), 0);
+    }
+};
+
+TEST_F(LockTest, LocksAndLoadsRange)
+{
+    EXPECT_EQ(lock_pages(pid, PAGE_SIZE + 10, PAGE_SIZE), 0) << "Expected partial pages to round out";
+    CheckPagePresentInRam(1);
+    CheckPagePresentInRam(2);
+    EXPECT_EQ(task->page_table[1].l_bit, 0x1);
+    EXPECT_EQ(task->page_table[2].l_bit, 0x1);
+    EXPECT_EQ(task->page_table[3].l_bit, 0x0);
+    EXPECT_EQ(pager_locked_pages(pid), 2);
+    EXPECT_EQ(pager_get_stats()->faults, 2u);
+
+    EXPECT_EQ(lock_pages(pid, PAGE_SIZE, PAGE_SIZE), 0) << "Expected locking a locked page to succeed";
+    EXPECT_EQ(lock_pages(pid, 0, 0), 0);
+    EXPECT_EQ(pager_locked_pages(pid), 2);
+}
+
+TEST_F(LockTest, InvalidArguments)
+{
+    EXPECT_EQ(lock_pages(pid + 1, 0, 1), -1);
+    EXPECT_EQ(unlock_pages(pid + 1, 0, 1), -1);
+    EXPECT_EQ(set_lock_limit(pid + 1, 1), -1);
+    EXPECT_EQ(pager_locked_pages(pid + 1), -1);
+    EXPECT_EQ(lock_pages(pid, PAGE_SIZE * 6, PAGE_SIZE * 2), -4) << "Expected page 7 inaccessible";
+    EXPECT_EQ(lock_pages(pid, PAGE_SIZE * (PAGE_TABLE_SIZE - 1), PAGE_SIZE * 2), -4) << "Expected the range to leave the address space";
+    EXPECT_EQ(unlock_pages(pid, PAGE_SIZE * (PAGE_TABLE_SIZE - 1), PAGE_SIZE * 2), -4);
+    EXPECT_EQ(set_lock_limit(pid, PAGE_TABLE_SIZE + 1), -2);
+    EXPECT_EQ(pager_locked_pages(pid), 0);
+    EXPECT_EQ(task->page_table[6].p_bit, 0x0) << "Expected nothing loaded";
+}
+
+TEST_F(LockTest, RespectsLockLimit)
+{
+    task->max_frames = 0;
+    ASSERT_EQ(set_lock_limit(pid, 2), 0);
+    EXPECT_EQ(lock_pages(pid, 0, PAGE_SIZE * 3), -2);
+    ASSERT_EQ(lock_pages(pid, 0, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(lock_pages(pid, PAGE_SIZE * 2, 1), -2);
+    EXPECT_EQ(set_lock_limit(pid, 1), -2) << "Expected the limit not to drop below the locked pages";
+    EXPECT_EQ(set_lock_limit(pid, PAGE_TABLE_SIZE), 0);
+    EXPECT_EQ(lock_pages(pid, PAGE_SIZE * 2, 1), 0);
+}
+
+TEST_F(LockTest, LeavesOneFrameBelowMaxFrames)
+{
+    EXPECT_EQ(lock_pages(pid, 0, PAGE_SIZE * 4), -2);
+    EXPECT_EQ(lock_pages(pid, 0, PAGE_SIZE * 3), 0);
+}
+
+TEST_F(LockTest, LockedPagesAreNoVictims)
+{
+    for (uint8_t policy : {PAGER_POLICY_NRU, PAGER_POLICY_AGING})
+    {
+        ASSERT_EQ(set_replacement_policy(pid, policy), 0);
+        ASSERT_EQ(lock_pages(pid, PAGE_SIZE, PAGE_SIZE * 2), 0);
+        for (uint8_t round = 0; round < 2; round++)
+        {
+            for (uint8_t id : {0, 3, 4, 5, 6})
+            {
+                if (task->page_table[id].p_bit == 0x0)
+                {
+                    ASSERT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+                }
+            }
+        }
+        EXPECT_EQ(task->page_table[1].p_bit, 0x1);
+        EXPECT_EQ(task->page_table[2].p_bit, 0x1);
+        ASSERT_EQ(unlock_pages(pid, PAGE_SIZE, PAGE_SIZE * 2), 0);
+    }
+}
+
+TEST_F(LockTest, UnlockedPagesAreVictimsAgain)
+{
+    task->max_frames = 2;
+    ASSERT_EQ(lock_pages(pid, PAGE_SIZE, 1), 0);
+    ASSERT_EQ(unlock_pages(pid, 0, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(pager_locked_pages(pid), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+}
+
+TEST_F(LockTest, FaultWithOnlyLockedPagesFails)
+{
+    task->max_frames = 0;
+    ASSERT_EQ(lock_pages(pid, PAGE_SIZE, 1), 0);
+    FillRam();
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 3), -3);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x1);
+
+    const tVirtAddr addresses[] = {PAGE_SIZE * 3, PAGE_SIZE * 4};
+    EXPECT_EQ(page_fault_batch(pid, addresses, 2), -3);
+}
+
+TEST_F(LockTest, FailedLockUnlocksAgain)
+{
+    task->max_frames = 0;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE), 0);
+    FillRam();
+    EXPECT_EQ(lock_pages(pid, PAGE_SIZE, PAGE_SIZE * 2), -3) << "Expected page 2 to find no frame";
+    EXPECT_EQ(pager_locked_pages(pid), 0);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x1);
+}
+
+TEST_F(LockTest, ReclaimSkipsLockedPages)
+{
+    task->max_frames = 0;
+    ASSERT_EQ(lock_pages(pid, PAGE_SIZE, 1), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    FillRam();
+    ASSERT_EQ(ram_set_watermarks(1, 2), 0);
+
+    EXPECT_EQ(pager_reclaim(), 1);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x1);
+    EXPECT_EQ(task->page_table[2].p_bit, 0x0);
+}
+
+TEST_F(LockTest, TuningKeepsFrameForFaults)
+{
+    ASSERT_EQ(lock_pages(pid, 0, PAGE_SIZE * 3), 0);
+    ASSERT_EQ(wss_set_tuning(pid, 1, 8), 0);
+    for (uint8_t tick = 0; tick < 8; tick++)
+    {
+        ASSERT_EQ(wss_tick(), 0);
+    }
+    EXPECT_EQ(task->max_frames, 4);
+}
@@ -0,0 +1,119 @@
+#include <cstring>
+#include <random>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "pte.h"
+#include "types.h"
+}
+
+// Reference masks collected field by field.
+static tPteScan ScanFields(const tPageTableEntry *page_table)
+{
+    tPteScan scan = {};
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        const tPageTableEntry &entry = page_table[id];
+        const tPageMask bit = PAGE_MASK_BIT(id);
+        scan.accessible |= (entry.r || entry.w || entry.x) ? bit : 0;
+        scan.present |= entry.p_bit ? bit : 0;
+        scan.referenced |= entry.r_bit ? bit : 0;
+        scan.modified |= entry.m_bit ? bit : 0;
+        scan.transit |= entry.t_bit ? bit : 0;
+        scan.locked |= entry.l_bit ? bit : 0;
+    }
+    return scan;
+}
+
+static void SetFlags(tPageTableEntry &entry, uint16_t flags)
+{
+    entry.r = flags & 0x1;
+    entry.w = (flags >> 1) & 0x1;
+    entry.x = (flags >> 2) & 0x1;
+    entry.p_bit = (flags >> 3) & 0x1;
+    entry.r_bit = (flags >> 4) & 0x1;
+    entry.m_bit = (flags >> 5) & 0x1;
+    entry.t_bit = (flags >> 6) & 0x1;
+    entry.l_bit = (flags >> 7) & 0x1;
+}
+
+static void ExpectScanEq(const tPteScan &scan, const tPteScan &expected)
+{
+    EXPECT_EQ(scan.accessible, expected.accessible);
+    EXPECT_EQ(scan.present, expected.present);
+    EXPECT_EQ(scan.referenced, expected.referenced);
+    EXPECT_EQ(scan.modified, expected.modified);
+    EXPECT_EQ(scan.transit, expected.transit);
+    EXPECT_EQ(scan.locked, expected.locked);
+}
+
+TEST(PteScanTest, EveryFlagCombinationInEverySlot)
+{
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        for (uint16_t flags = 0; flags < 0x100; flags++)
+        {
+            memset(page_table, 0, sizeof(page_table));
+            SetFlags(page_table[id], flags);
+            page_table[id].frame_id = 0xffff;  // frame_id bits must not leak into the masks
+            page_table[id].order = 0x3;        // neither must the order bits
+            tPteScan scan;
+            pte_scan(page_table, &scan);
+            ExpectScanEq(scan, ScanFields(page_table));
+        }
+    }
+}
+
+TEST(PteScanTest, RandomPageTables)
+{
+    std::mt19937 gen(7);
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    for (int round = 0; round < 1000; round++)
+    {
+        for (auto &entry : page_table)
+        {
+            SetFlags(entry, gen() & 0xff);
+            entry.order = gen() & 0x3;  // order bits must not leak into the masks
+            entry.frame_id = gen();
+        }
+        tPteScan scan;
+        pte_scan(page_table, &scan);
+        ExpectScanEq(scan, ScanFields(page_table));
+    }
+}
+
+TEST(PteScanTest, NruClasses)
+{
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    memset(page_table, 0, sizeof(page_table));
+    for (uint8_t id = 0; id < 4; id++)
+    {
+        page_table[id].p_bit = 0x1;
+        page_table[id].r_bit = (id >> 1) & 0x1;
+        page_table[id].m_bit = id & 0x1;
+    }
+    page_table[4].r_bit = 0x1;  // not present, in no class
+
+    tPteScan scan;
+    pte_scan(page_table, &scan);
+    for (uint8_t cls = 0; cls < 4; cls++)
+    {
+        EXPECT_EQ(pte_nru_class(&scan, cls), PAGE_MASK_BIT(cls));
+    }
+}
+
+TEST(PteScanTest, LastPageOfLargeTable)
+{
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    memset(page_table, 0, sizeof(page_table));
+    page_table[PAGE_TABLE_SIZE - 1].p_bit = 0x1;
+    page_table[PAGE_TABLE_SIZE - 1].l_bit = 0x1;
+
+    tPteScan scan;
+    pte_scan(page_table, &scan);
+    EXPECT_EQ(scan.present, PAGE_MASK_BIT(PAGE_TABLE_SIZE - 1));
+    EXPECT_EQ(scan.locked, PAGE_MASK_BIT(PAGE_TABLE_SIZE - 1));
+    EXPECT_EQ(PAGE_MASK_RANGE(0, PAGE_TABLE_SIZE) >> (PAGE_TABLE_SIZE - 1), 0x1) << "Expected a mask of all pages";
+}
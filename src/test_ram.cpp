@@ -3,6 +3,7 @@
 #include "test_ram.h"
 
 extern "C" {
+#include "bitmap.h"
 #include "ram.h"
 }
 
@@ -32,6 +33,44 @@ TEST_F(InitRamTest, MemoryNotZeroed)
     EXPECT_EQ(ret, -3);
 }
 
+TEST_F(InitRamTest, NonZeroByteAnywhereDetected)
+{
+    // First and last byte, inside and at the edges of the blocks tested at once.
+    for (uint16_t pos : {0, 7, 8, 63, 64, 100, 4095, 16383})
+    {
+        buffer[pos] = 0x80;
+        EXPECT_EQ(init_ram(buffer, 16384, 16), -3) << "Byte " << pos;
+        buffer[pos] = 0x0;
+    }
+    buffer[20] = 0x1;
+    EXPECT_EQ(init_ram(buffer, 32, 8), -3);
+    buffer[20] = 0x0;
+    buffer[40] = 0x1;
+    EXPECT_EQ(init_ram(buffer, 32, 8), 4) << "Expected bytes behind RAM ignored";
+    destroy_ram();
+    memset(buffer, 0, sizeof(buffer));
+    EXPECT_EQ(init_ram(buffer, 16384, 16), 1024);
+}
+
+TEST_F(InitRamTest, TrustedInitSkipsZeroCheck)
+{
+    buffer[200] = 0x1;  // inside a data frame, init_ram() would refuse it
+    EXPECT_EQ(init_ram_trusted(buffer, 256, 16), 16);
+    ASSERT_NE(get_ram_state(), nullptr);
+    EXPECT_EQ(get_ram_state()->size, 256);
+    tFrameId frame_id = 0;
+    EXPECT_EQ(falloc(&frame_id, 1), 0);
+}
+
+TEST_F(InitRamTest, TrustedInitChecksParams)
+{
+    EXPECT_EQ(init_ram_trusted(nullptr, 256, 16), -3);
+    EXPECT_EQ(init_ram_trusted(buffer, 300, 16), -1);
+    EXPECT_EQ(init_ram_trusted(buffer, 256, 24), -2);
+    EXPECT_EQ(init_ram_trusted(buffer, 8, 8), -4);
+    EXPECT_EQ(get_ram_state(), nullptr);
+}
+
 TEST_F(InitRamTest, NullMemoryPointer)
 {
     int ret = init_ram(nullptr, 256, 16);
@@ -102,13 +141,10 @@ uint8_t reversByte(uint8_t b)
 
 uint16_t getOccupiedFrames(const tRam &ram, bool *isContinuous)
 {
-    uint8_t *bitmap = ram.bitmap;
+    const uint8_t *bitmap = (const uint8_t *)&ram + ram.bitmap;
     uint16_t num_frames = ram.size / ram.page_size;
     uint16_t bitmapSize = (num_frames > 8) ? num_frames / 8 : 1;
 
-    if (bitmap == nullptr)
-        return 0;
-
     // check frames used by system
     uint16_t occupiedFrames = 0;
     bool blockStarted = false;
@@ -197,7 +233,8 @@ TEST_P(RamParamTest, GetRamState)
 
     // test that there is some ram already used by system
     uint16_t bitmapSize = (result > 8) ? (result / 8) : 1;
-    uint16_t occupiedBytes = bitmapSize + sizeof(tRam);
+    uint16_t summarySize = (result > 64) ? BITMAP_SUMMARY_BYTES(result) : 0;
+    uint16_t occupiedBytes = bitmapSize + summarySize + sizeof(tRam);
     uint16_t expectedOccupiedFrames = (occupiedBytes / p.page_size) + ((occupiedBytes % p.page_size) ? 1 : 0);
 
     bool isContinuous = true;
@@ -224,9 +261,8 @@ TEST_P(RamParamTest, GetRamState_boundaries)
         EXPECT_GE((uint8_t *)ret, buffer);
         EXPECT_LT((uint8_t *)ret, buffer + p.size);
         // bitmap is inside reserved ram memory
-        EXPECT_GE(ret->bitmap, buffer);
-        EXPECT_GE(ret->bitmap, buffer + sizeof(tRam));
-        EXPECT_LT(ret->bitmap, buffer + p.size);
+        EXPECT_GE(ret->bitmap, sizeof(tRam));
+        EXPECT_LT(ret->bitmap, p.size);
     }
     else
     {
@@ -250,7 +286,7 @@ INSTANTIATE_TEST_SUITE_P(Negative,
         InitRamCase{300, 16, -1, "InvalidSize"},
         InitRamCase{256, 24, -2, "InvalidPageSize"},
         InitRamCase{64, 128, -2, "ValidSizeSmallerThanValidPageSize"},
-        InitRamCase{16, 16, -4, "ValidSizeNotEnoughResources"}),
+        InitRamCase{8, 8, -4, "ValidSizeNotEnoughResources"}),
     testing::PrintToStringParamName());
 
 INSTANTIATE_TEST_SUITE_P(Positive,
@@ -11,7 +11,8 @@ extern "C" {
 class RamTestBase : public ::testing::Test
 {
   protected:
-    static constexpr uint16_t RAM_SIZE = 1024 * 2;   // 2KB of simulated RAM
+    // 2KB of simulated RAM, more for page tables above 8 entries so that the task manager leaves room for pages
+    static constexpr uint16_t RAM_SIZE = 1024 * 2 * (PAGE_TABLE_SIZE > 8 ? PAGE_TABLE_SIZE / 8 : 1);
     static constexpr uint8_t PAGE_SIZE = 128;        // each page is 128B
     static constexpr uint16_t NUM_FRAMES = RAM_SIZE / PAGE_SIZE;
 
@@ -20,7 +21,7 @@ class RamTestBase : public ::testing::Test
     RamTestBase()
     {
         std::memset(ram, 0, RAM_SIZE);
-        init_ram(ram, RAM_SIZE, PAGE_SIZE);
+        init_ram_trusted(ram, RAM_SIZE, PAGE_SIZE);
     }
 
     ~RamTestBase()
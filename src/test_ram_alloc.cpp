@@ -1,4 +1,7 @@
+#include <atomic>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "test_ram.h"
@@ -19,7 +22,7 @@ class RamAllocTest : public RamTestBase
 // --- falloc() basic allocation ---
 TEST_F(RamAllocTest, AllocateSinglePage)
 {
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, 1);
     CHECK_BOUNDARIES(ret, frame_id);
 }
@@ -27,8 +30,8 @@ TEST_F(RamAllocTest, AllocateSinglePage)
 // --- falloc() should return unique regions ---
 TEST_F(RamAllocTest, AllocateMultiplePages)
 {
-    uint16_t frame_id1 = 0;
-    uint16_t frame_id2 = 0;
+    tFrameId frame_id1 = 0;
+    tFrameId frame_id2 = 0;
     int ret1 = falloc(&frame_id1, 1);
     int ret2 = falloc(&frame_id2, 1);
     CHECK_BOUNDARIES(ret1, frame_id1);
@@ -38,7 +41,7 @@ TEST_F(RamAllocTest, AllocateMultiplePages)
 
 TEST_F(RamAllocTest, AllocationFailsInvalidParams)
 {
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, 0);
     EXPECT_EQ(ret, -1);
     ret = falloc(nullptr, 1);
@@ -55,7 +58,7 @@ TEST_F(RamAllocTest, AllocationFailsOnAllRam)
     uint16_t total_frames = ram_state->size / ram_state->page_size;
 
     // Allocate all pages should fail as there are some frames already occupied
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, total_frames);
     EXPECT_EQ(ret, -1);
     EXPECT_EQ(frame_id, 0);
@@ -70,7 +73,7 @@ TEST_F(RamAllocTest, AllocationFailsWhenNotEnoughSpace)
     uint16_t used_pages = getOccupiedFrames(nullptr);
 
     // Allocate all remaining pages
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, total_frames - used_pages);
     CHECK_BOUNDARIES(ret, frame_id);
     uint16_t occupied_frames = getOccupiedFrames(nullptr);
@@ -91,7 +94,7 @@ TEST_F(RamAllocTest, FreeSmallBlockWillNotFitBigger)
     uint16_t used_pages = getOccupiedFrames(nullptr);
 
     // Allocate all remaining pages
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, total_frames - used_pages);
     CHECK_BOUNDARIES(ret, frame_id);
     uint16_t occupied_frames = getOccupiedFrames(nullptr);
@@ -114,7 +117,7 @@ TEST_F(RamAllocTest, FreeBlockWillFitNew)
     uint16_t used_pages = getOccupiedFrames(nullptr);
 
     // Allocate all remaining pages
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, total_frames - used_pages);
     CHECK_BOUNDARIES(ret, frame_id);
     uint16_t occupied_frames = getOccupiedFrames(nullptr);
@@ -129,14 +132,14 @@ TEST_F(RamAllocTest, FreeBlockWillFitNew)
 
 TEST_F(RamAllocTest, FreeThenReallocate)
 {
-    uint16_t frame_id1 = 0;
+    tFrameId frame_id1 = 0;
     int ret = falloc(&frame_id1, 2);
     CHECK_BOUNDARIES(ret, frame_id1);
 
     ffree(frame_id1, 2);
 
     // Reallocate again
-    uint16_t frame_id2 = 0;
+    tFrameId frame_id2 = 0;
     ret = falloc(&frame_id2, 2);
     CHECK_BOUNDARIES(ret, frame_id2);
     EXPECT_EQ(frame_id1, frame_id2) << "Expected freed memory to be reusable";
@@ -149,7 +152,7 @@ TEST_F(RamAllocTest, FreeInvalidFrameIdDoesNotCrash)
 
 TEST_F(RamAllocTest, PartialFreeAndReallocate)
 {
-    uint16_t frame_id1 = 0;
+    tFrameId frame_id1 = 0;
     int ret = falloc(&frame_id1, 4);
     ASSERT_EQ(ret, 0);
 
@@ -157,15 +160,542 @@ TEST_F(RamAllocTest, PartialFreeAndReallocate)
     ffree(frame_id1 + 1, 2);
 
     // Allocate 2 pages (should fit into the freed section)
-    uint16_t frame_id2 = 0;
+    tFrameId frame_id2 = 0;
     ret = falloc(&frame_id2, 2);
     ASSERT_EQ(ret, 0);
     EXPECT_EQ(frame_id1 + 1, frame_id2);
 }
 
+TEST_F(RamAllocTest, FreeFramesCount)
+{
+    tFrameId free_frames = ram_free_frames();
+    EXPECT_EQ(free_frames, NUM_FRAMES - getOccupiedFrames(nullptr));
+
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 3), 0);
+    EXPECT_EQ(ram_free_frames(), free_frames - 3);
+    ffree(frame_id, 3);
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST_F(RamAllocTest, AllocateScatteredSkipsReservedFrames)
+{
+    tFrameId first = 0;
+    ASSERT_EQ(falloc(&first, 3), 0);
+    ffree(first + 1, 1);
+
+    tFrameId frame_ids[3] = {0};
+    ASSERT_EQ(falloc_scattered(frame_ids, 3), 3);
+    EXPECT_EQ(frame_ids[0], first + 1) << "Expected the hole filled first";
+    EXPECT_EQ(frame_ids[1], first + 3);
+    EXPECT_EQ(frame_ids[2], first + 4);
+    EXPECT_EQ(getOccupiedFrames(nullptr), NUM_FRAMES - ram_free_frames());
+}
+
+TEST_F(RamAllocTest, AllocateScatteredReturnsFreeFrames)
+{
+    const tFrameId free_frames = ram_free_frames();
+    tFrameId frame_ids[NUM_FRAMES];
+    EXPECT_EQ(falloc_scattered(frame_ids, NUM_FRAMES), free_frames);
+    EXPECT_EQ(ram_free_frames(), 0);
+    EXPECT_EQ(falloc_scattered(frame_ids, 1), 0);
+    EXPECT_EQ(falloc_scattered(frame_ids, 0), -2);
+    EXPECT_EQ(falloc_scattered(nullptr, 1), -2);
+}
+
+TEST_F(RamAllocTest, AllocateAtChosenFrames)
+{
+    tFrameId first = 0;
+    ASSERT_EQ(falloc(&first, 1), 0);
+    EXPECT_EQ(falloc_at(first + 2, 3), 0);
+    EXPECT_EQ(falloc_at(first + 1, 2), -1) << "Expected reserved frame refused";
+    EXPECT_EQ(falloc_at(first, 1), -1);
+    EXPECT_EQ(falloc_at(first + 1, 1), 0);
+    EXPECT_EQ(falloc_at(NUM_FRAMES - 1, 2), -2);
+    EXPECT_EQ(falloc_at(first + 8, 0), -2);
+    EXPECT_EQ(ram_free_frames(), NUM_FRAMES - first - 5);
+}
+
+TEST_F(RamAllocTest, LargestFreeRun)
+{
+    const tFrameId free_frames = ram_free_frames();
+    EXPECT_EQ(ram_largest_free_run(), free_frames) << "Expected free frames in one run after init";
+
+    tFrameId first = 0;
+    ASSERT_EQ(falloc(&first, 4), 0);
+    tFrameId second = 0;
+    ASSERT_EQ(falloc(&second, 2), 0);
+    ffree(first, 4);
+    EXPECT_EQ(ram_largest_free_run(), free_frames - 6);
+    ffree(second, 2);
+    EXPECT_EQ(ram_largest_free_run(), free_frames);
+
+    tFrameId all = 0;
+    ASSERT_EQ(falloc(&all, free_frames), 0);
+    EXPECT_EQ(ram_largest_free_run(), 0);
+}
+
+class RamAllocPolicyTest : public RamAllocTest
+{
+  protected:
+    // Leaves free holes of 3, 1 and 2 frames in front of the free tail of RAM.
+    void SetUp() override
+    {
+        RamAllocTest::SetUp();
+        ASSERT_EQ(falloc(&first, 9), 0);
+        ffree(first, 3);
+        ffree(first + 4, 1);
+        ffree(first + 6, 2);
+        tail = first + 9;
+        ram_reset_stats();
+    }
+
+    tFrameId first = 0;
+    tFrameId tail = 0;
+};
+
+TEST_F(RamAllocPolicyTest, FirstFitTakesLowestHole)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 2), 0);
+    EXPECT_EQ(frame_id, first);
+    EXPECT_EQ(ram_get_stats()->scanned_frames, first + 2u) << "Expected frames up to the end of the run passed";
+    EXPECT_EQ(ram_get_stats()->allocations, 1u);
+}
+
+TEST_F(RamAllocPolicyTest, BestFitTakesSmallestHole)
+{
+    ASSERT_EQ(ram_set_alloc_policy(RAM_ALLOC_BEST_FIT), 0);
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 2), 0);
+    EXPECT_EQ(frame_id, first + 6) << "Expected exact fit";
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    EXPECT_EQ(frame_id, first + 4);
+    ASSERT_EQ(falloc(&frame_id, 4), 0);
+    EXPECT_EQ(frame_id, tail) << "Expected hole of 3 frames skipped";
+}
+
+TEST_F(RamAllocPolicyTest, NextFitContinuesAfterLastAllocation)
+{
+    ASSERT_EQ(ram_set_alloc_policy(RAM_ALLOC_NEXT_FIT), 0);
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    EXPECT_EQ(frame_id, tail) << "Expected search to start after the last allocation";
+    EXPECT_EQ(get_ram_state()->rover, tail + 1);
+
+    // fill the tail, the search wraps around to the holes
+    ASSERT_EQ(falloc(&frame_id, NUM_FRAMES - tail - 1), 0);
+    EXPECT_EQ(get_ram_state()->rover, 0);
+    ASSERT_EQ(falloc(&frame_id, 2), 0);
+    EXPECT_EQ(frame_id, first);
+    ASSERT_EQ(falloc(&frame_id, 2), 0);
+    EXPECT_EQ(frame_id, first + 6);
+    EXPECT_EQ(falloc(&frame_id, 2), -1);
+    EXPECT_EQ(ram_get_stats()->failures, 1u);
+}
+
+TEST_F(RamAllocPolicyTest, NextFitFindsRunAcrossRover)
+{
+    ASSERT_EQ(ram_set_alloc_policy(RAM_ALLOC_NEXT_FIT), 0);
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, NUM_FRAMES - tail), 0);
+    ffree(first + 3, 1);  // joins the holes of 3 and 1 frame into 5 with the frame in between
+    tFrameId middle = 0;
+    ASSERT_EQ(falloc(&middle, 1), 0);
+    EXPECT_EQ(middle, first);
+    ASSERT_EQ(falloc(&frame_id, 4), 0);
+    EXPECT_EQ(frame_id, first + 1) << "Expected the run that starts before the rover found";
+}
+
+TEST_F(RamAllocPolicyTest, Fragmentation)
+{
+    // holes of 3, 1, 2 and the free tail
+    const tFrameId free_frames = ram_free_frames();
+    const tFrameId largest = NUM_FRAMES - tail;
+    EXPECT_EQ(ram_fragmentation(), 100 - largest * 100 / free_frames);
+
+    ffree(first, 9);
+    EXPECT_EQ(ram_fragmentation(), 0);
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, ram_free_frames()), 0);
+    EXPECT_EQ(ram_fragmentation(), 0) << "Expected no fragmentation without free frames";
+}
+
+TEST_F(RamAllocTest, SetAllocPolicyInvalid)
+{
+    EXPECT_EQ(ram_set_alloc_policy(RAM_ALLOC_BEST_FIT + 1), -2);
+    EXPECT_EQ(get_ram_state()->alloc_policy, RAM_ALLOC_FIRST_FIT);
+}
+
+TEST_F(RamAllocTest, SetWatermarks)
+{
+    EXPECT_EQ(ram_set_watermarks(2, 4), 0);
+    EXPECT_EQ(get_ram_state()->wmark_low, 2);
+    EXPECT_EQ(get_ram_state()->wmark_high, 4);
+    EXPECT_EQ(ram_set_watermarks(0, 0), 0);
+}
+
+TEST_F(RamAllocTest, SetWatermarksInvalidParams)
+{
+    EXPECT_EQ(ram_set_watermarks(4, 2), -2);
+    EXPECT_EQ(ram_set_watermarks(1, NUM_FRAMES + 1), -2);
+    EXPECT_EQ(get_ram_state()->wmark_low, 0);
+    EXPECT_EQ(get_ram_state()->wmark_high, 0);
+}
+
+class RamMagazineTest : public RamAllocTest
+{
+  protected:
+    void SetUp() override
+    {
+        RamAllocTest::SetUp();
+        free_frames = ram_free_frames();
+        ASSERT_EQ(ram_set_magazines(1), 0);
+        ram_reset_stats();
+    }
+
+    tFrameId free_frames = 0;
+};
+
+TEST_F(RamMagazineTest, RefillTakesBatchOfLowestFrames)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    const tFrameId first = frame_id;
+    EXPECT_EQ(ram_cached_frames(), RAM_MAGAZINE_BATCH - 1);
+    EXPECT_EQ(ram_free_frames(), free_frames - RAM_MAGAZINE_BATCH) << "Expected cached frames reserved";
+
+    for (tFrameId id = 1; id < RAM_MAGAZINE_BATCH; id++)
+    {
+        ASSERT_EQ(falloc(&frame_id, 1), 0);
+        EXPECT_EQ(frame_id, first + id) << "Expected the lowest cached frame first";
+    }
+    EXPECT_EQ(ram_cached_frames(), 0);
+    EXPECT_EQ(ram_get_stats()->magazine_hits, RAM_MAGAZINE_BATCH);
+    EXPECT_EQ(ram_get_stats()->magazine_refills, 1u);
+    EXPECT_EQ(ram_get_stats()->allocations, 0u);
+}
+
+TEST_F(RamMagazineTest, FreedFrameIsCachedAndReused)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    ffree(frame_id, 1);
+    EXPECT_EQ(ram_cached_frames(), RAM_MAGAZINE_BATCH);
+
+    tFrameId again = 0;
+    ASSERT_EQ(falloc(&again, 1), 0);
+    EXPECT_EQ(again, frame_id) << "Expected the most recently freed frame";
+    EXPECT_EQ(ram_get_stats()->magazine_refills, 1u);
+}
+
+TEST_F(RamMagazineTest, FullMagazineReturnsBatch)
+{
+    // Smaller pages, so that more frames are free than a magazine holds.
+    destroy_ram();
+    std::memset(ram, 0, RAM_SIZE);
+    ASSERT_GT(init_ram_trusted(ram, RAM_SIZE, PAGE_SIZE / 4), 0);
+    free_frames = ram_free_frames();
+    ASSERT_GT(free_frames, RAM_MAGAZINE_SIZE);
+    std::vector<tFrameId> frames(free_frames);
+    ASSERT_EQ(falloc_scattered(frames.data(), free_frames), free_frames);
+    ASSERT_EQ(ram_set_magazines(1), 0);
+
+    for (tFrameId id = 0; id <= RAM_MAGAZINE_SIZE; id++)
+    {
+        ffree(frames[id], 1);
+    }
+    EXPECT_EQ(ram_cached_frames(), RAM_MAGAZINE_SIZE + 1 - RAM_MAGAZINE_BATCH);
+    EXPECT_EQ(ram_free_frames(), RAM_MAGAZINE_BATCH);
+    for (tFrameId id = 0; id < RAM_MAGAZINE_BATCH; id++)
+    {
+        EXPECT_EQ(falloc_at(frames[id], 1), 0) << "Expected the least recently freed frames returned";
+    }
+}
+
+TEST_F(RamMagazineTest, DrainReturnsAllFrames)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    ram_drain_magazines();
+    EXPECT_EQ(ram_cached_frames(), 0);
+    EXPECT_EQ(ram_free_frames(), free_frames - 1);
+    ffree(frame_id, 1);
+    ram_drain_magazines();
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST_F(RamMagazineTest, MultiFrameAllocationDrainsBeforeFailing)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    ffree(frame_id, 1);
+    ASSERT_NE(ram_cached_frames(), 0);
+
+    ASSERT_EQ(falloc(&frame_id, free_frames), 0) << "Expected the cached frames to be drained";
+    EXPECT_EQ(ram_cached_frames(), 0);
+    EXPECT_EQ(ram_get_stats()->failures, 0u);
+    EXPECT_EQ(ram_get_stats()->allocations, 1u);
+}
+
+TEST_F(RamMagazineTest, DisableDrains)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    ASSERT_EQ(ram_set_magazines(0), 0);
+    EXPECT_EQ(ram_cached_frames(), 0);
+    EXPECT_EQ(ram_free_frames(), free_frames - 1);
+}
+
+TEST_F(RamMagazineTest, DestroyRamDrains)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    destroy_ram();
+    EXPECT_EQ(ram_cached_frames(), 0);
+    ASSERT_GT(attach_ram(ram, RAM_SIZE, PAGE_SIZE), 0);
+    EXPECT_EQ(ram_free_frames(), free_frames - 1);
+}
+
+TEST_F(RamMagazineTest, ThreadsNeverShareFrames)
+{
+    constexpr int THREADS = 4;
+    constexpr int ROUNDS = 2000;
+    std::vector<std::atomic<int>> owners(NUM_FRAMES);
+    std::atomic<int> conflicts{0};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < THREADS; thread++)
+    {
+        threads.emplace_back([&, thread]() {
+            tFrameId held[2];
+            for (int round = 0; round < ROUNDS; round++)
+            {
+                int count = 0;
+                for (; count < 2 && falloc(&held[count], 1) == 0; count++)
+                {
+                    int expected = 0;
+                    if (!owners[held[count]].compare_exchange_strong(expected, thread + 1))
+                        conflicts++;
+                }
+                for (int id = 0; id < count; id++)
+                {
+                    owners[held[id]] = 0;
+                    ffree(held[id], 1);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(conflicts, 0);
+    EXPECT_EQ(ram_cached_frames(), 0) << "Expected exiting threads to return their frames";
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST(RamUninitializedTest, SetMagazinesFailsIfUninitialized)
+{
+    EXPECT_EQ(ram_set_magazines(1), -1);
+    EXPECT_EQ(ram_cached_frames(), 0);
+}
+
+class RamLockFreeTest : public RamAllocTest
+{
+  protected:
+    void SetUp() override
+    {
+        // Smaller pages, so that the bitmap has a summary.
+        destroy_ram();
+        std::memset(ram, 0, RAM_SIZE);
+        ASSERT_GT(init_ram_trusted(ram, RAM_SIZE, PAGE_SIZE / 16), 64);
+        free_frames = ram_free_frames();
+        ASSERT_EQ(ram_set_lock_free(1), 0);
+        ram_reset_stats();
+    }
+
+    tFrameId free_frames = 0;
+};
+
+TEST_F(RamLockFreeTest, SingleFrameIsClaimedAtomically)
+{
+    tFrameId first = 0;
+    tFrameId second = 0;
+    ASSERT_EQ(falloc(&first, 1), 0);
+    ASSERT_EQ(falloc(&second, 1), 0);
+    EXPECT_EQ(second, first + 1);
+    EXPECT_EQ(ram_get_stats()->lock_free_allocations, 2u);
+    EXPECT_EQ(ram_get_stats()->allocations, 0u);
+    EXPECT_EQ(ram_free_frames(), free_frames - 2);
+
+    ffree(first, 1);
+    ffree(second, 1);
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST_F(RamLockFreeTest, ClaimWrapsAroundToFreedFrames)
+{
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, free_frames - 1), 0);
+    tFrameId last = 0;
+    ASSERT_EQ(falloc(&last, 1), 0);
+    ffree(frame_id, 1);
+
+    tFrameId again = 0;
+    ASSERT_EQ(falloc(&again, 1), 0);
+    EXPECT_EQ(again, frame_id) << "Expected the search to continue at the start of RAM";
+    EXPECT_EQ(falloc(&again, 1), -1);
+    EXPECT_EQ(ram_get_stats()->failures, 1u);
+}
+
+TEST_F(RamLockFreeTest, RunsStillUseLockedSearch)
+{
+    tFrameId single = 0;
+    ASSERT_EQ(falloc(&single, 1), 0);
+    tFrameId run = 0;
+    ASSERT_EQ(falloc(&run, 8), 0);
+    EXPECT_EQ(run, single + 1);
+    EXPECT_EQ(falloc_at(run, 1), -1);
+    ffree(run, 8);
+    EXPECT_EQ(falloc_at(run, 8), 0);
+}
+
+TEST_F(RamLockFreeTest, SummaryIsRebuiltWhenSwitchedOff)
+{
+    const tRam *state = get_ram_state();
+    const uint8_t *summary = ram + state->summary;
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 64), 0);
+    EXPECT_EQ(summary[0], 0) << "Expected no summary in lock-free mode";
+
+    ASSERT_EQ(ram_set_lock_free(0), 0);
+    EXPECT_NE(summary[0], 0) << "Expected full words in the summary";
+    ffree(frame_id, 64);
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST_F(RamLockFreeTest, ThreadsNeverShareFrames)
+{
+    constexpr int THREADS = 4;
+    constexpr int ROUNDS = 2000;
+    std::vector<std::atomic<int>> owners(free_frames + 64);
+    std::atomic<int> conflicts{0};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < THREADS; thread++)
+    {
+        threads.emplace_back([&, thread]() {
+            tFrameId held[4];
+            for (int round = 0; round < ROUNDS; round++)
+            {
+                // Runs of two frames race with single frames claimed without the lock.
+                const tFrameId number = (round % 4 == 0) ? 2 : 1;
+                int count = 0;
+                for (; count < 4 && falloc(&held[count], number) == 0; count++)
+                {
+                    for (tFrameId id = 0; id < number; id++)
+                    {
+                        int expected = 0;
+                        if (!owners[held[count] + id].compare_exchange_strong(expected, thread + 1))
+                            conflicts++;
+                    }
+                }
+                for (int id = 0; id < count; id++)
+                {
+                    for (tFrameId frame = 0; frame < number; frame++)
+                        owners[held[id] + frame] = 0;
+                    ffree(held[id], number);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(conflicts, 0);
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST(RamUninitializedTest, SetLockFreeFailsIfUninitialized)
+{
+    EXPECT_EQ(ram_set_lock_free(1), -1);
+}
+
+TEST_F(RamAllocTest, SetNodesChecksParameters)
+{
+    const uint8_t zero_weight[] = {1, 0};
+    EXPECT_EQ(ram_node_count(), 1);
+    EXPECT_EQ(ram_set_nodes(0, nullptr), -2);
+    EXPECT_EQ(ram_set_nodes(3, nullptr), -2);
+    EXPECT_EQ(ram_set_nodes(RAM_MAX_NODES * 2, nullptr), -2);
+    EXPECT_EQ(ram_set_nodes(2, zero_weight), -2);
+    EXPECT_EQ(ram_node_count(), 1);
+
+    tFrameId frame_id = 0;
+    EXPECT_EQ(falloc_node(&frame_id, 1, 1), -2);
+    EXPECT_EQ(falloc_scattered_node(&frame_id, 1, 1), -2);
+    EXPECT_EQ(ram_get_node(1), nullptr);
+}
+
+TEST_F(RamAllocTest, NodesSplitRamEvenly)
+{
+    const uint8_t weights[] = {1, 2, 3, 4};
+    ASSERT_EQ(ram_set_nodes(4, weights), 0);
+    ASSERT_EQ(ram_node_count(), 4);
+    for (uint8_t node = 0; node < 4; node++)
+    {
+        const tRamNode *ram_node = ram_get_node(node);
+        ASSERT_NE(ram_node, nullptr);
+        EXPECT_EQ(ram_node->first, node * NUM_FRAMES / 4);
+        EXPECT_EQ(ram_node->frames, NUM_FRAMES / 4);
+        EXPECT_EQ(ram_node->weight, weights[node]);
+        EXPECT_EQ(ram_frame_node(ram_node->first + ram_node->frames - 1), node);
+    }
+    EXPECT_EQ(ram_frame_node(NUM_FRAMES), -1);
+    EXPECT_EQ(ram_node_free_frames(3), NUM_FRAMES / 4);
+    EXPECT_LT(ram_node_free_frames(0), NUM_FRAMES / 4) << "Expected tRam in node 0";
+}
+
+TEST_F(RamAllocTest, FallocNodeStaysInNode)
+{
+    ASSERT_EQ(ram_set_nodes(2, nullptr), 0);
+    const tRamNode *node = ram_get_node(1);
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc_node(&frame_id, node->frames, 1), 0);
+    EXPECT_EQ(frame_id, node->first);
+    EXPECT_EQ(ram_node_free_frames(1), 0);
+    EXPECT_EQ(falloc_node(&frame_id, 1, 1), -1) << "Expected no spill over to node 0";
+    EXPECT_GT(ram_node_free_frames(0), 0);
+
+    ffree(node->first + 2, 2);
+    tFrameId frame_ids[4];
+    ASSERT_EQ(falloc_scattered_node(frame_ids, 4, 1), 2);
+    EXPECT_EQ(frame_ids[0], node->first + 2);
+    EXPECT_EQ(frame_ids[1], node->first + 3);
+}
+
+TEST_F(RamAllocTest, InitRamResetsNodes)
+{
+    ASSERT_EQ(ram_set_nodes(2, nullptr), 0);
+    destroy_ram();
+    EXPECT_EQ(ram_node_count(), 0);
+    ASSERT_GT(attach_ram(ram, RAM_SIZE, PAGE_SIZE), 0);
+    EXPECT_EQ(ram_node_count(), 1);
+    EXPECT_EQ(ram_get_node(0)->frames, NUM_FRAMES);
+}
+
+TEST(RamUninitializedTest, SetNodesFailsIfUninitialized)
+{
+    tFrameId frame_id = 0;
+    EXPECT_EQ(ram_set_nodes(2, nullptr), -1);
+    EXPECT_EQ(falloc_node(&frame_id, 1, 0), -1);
+    EXPECT_EQ(ram_frame_node(0), -1);
+    EXPECT_EQ(ram_node_free_frames(0), 0);
+}
+
 TEST(RamUninitializedTest, FallocFailsIfUninitialized)
 {
-    uint16_t frame_id = 0;
+    tFrameId frame_id = 0;
     int ret = falloc(&frame_id, 1);
     EXPECT_EQ(ret, -1);
     EXPECT_EQ(frame_id, 0);
@@ -175,3 +705,35 @@ TEST(RamUninitializedTest, FfreeDoesNotCrashIfUninitialized)
 {
     EXPECT_NO_FATAL_FAILURE(ffree(0, 1));
 }
+
+TEST(RamUninitializedTest, FallocScatteredFailsIfUninitialized)
+{
+    tFrameId frame_id = 0;
+    EXPECT_EQ(falloc_scattered(&frame_id, 1), -1);
+}
+
+TEST(RamUninitializedTest, NoFreeFramesIfUninitialized)
+{
+    EXPECT_EQ(ram_free_frames(), 0);
+}
+
+TEST(RamUninitializedTest, FallocAtFailsIfUninitialized)
+{
+    EXPECT_EQ(falloc_at(1, 1), -1);
+}
+
+TEST(RamUninitializedTest, NoFreeRunIfUninitialized)
+{
+    EXPECT_EQ(ram_largest_free_run(), 0);
+}
+
+TEST(RamUninitializedTest, SetAllocPolicyFailsIfUninitialized)
+{
+    EXPECT_EQ(ram_set_alloc_policy(RAM_ALLOC_BEST_FIT), -1);
+    EXPECT_EQ(ram_fragmentation(), 0);
+}
+
+TEST(RamUninitializedTest, SetWatermarksFailsIfUninitialized)
+{
+    EXPECT_EQ(ram_set_watermarks(1, 2), -1);
+}
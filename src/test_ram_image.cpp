@@ -0,0 +1,247 @@
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "test_ram.h"
+
+extern "C" {
+#include "backing.h"
+#include "cgroup.h"
+#include "mmu.h"
+#include "pager.h"
+#include "ram_image.h"
+#include "task.h"
+}
+
+class RamImageTest : public RamTestBase
+{
+  protected:
+    void SetUp() override
+    {
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+
+        ASSERT_EQ(init_taskMgr(), 0);
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            memset(address_space + PAGE_SIZE * id, 0x50 + id, PAGE_SIZE);
+        }
+        tPageTableEntry page_table[PAGE_TABLE_SIZE];
+        memset(page_table, 0, sizeof(page_table));
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            page_table[id].r = 0x1;
+            page_table[id].w = 0x1;
+        }
+        pid = create_task(page_table, 0, address_space);
+        ASSERT_GE(pid, 0);
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+        free_frames = ram_free_frames();
+    }
+
+    void CheckFrame(int task_pid, uint8_t page_id)
+    {
+        const tTaskStruct *task = get_task_struct(task_pid);
+        ASSERT_EQ(task->page_table[page_id].p_bit, 0x1);
+        const uint8_t *frame = (const uint8_t *)get_ram_state() + task->page_table[page_id].frame_id * PAGE_SIZE;
+        EXPECT_EQ(memcmp(frame, address_space + page_id * PAGE_SIZE, PAGE_SIZE), 0);
+    }
+
+    void TearDown() override
+    {
+        ram_image_detach(&image);
+        set_page_table(nullptr);
+        destroy_taskMgr();
+        unlink(path);
+    }
+
+    char path[32] = "/tmp/ospager_XXXXXX";
+    int pid;
+    tFrameId free_frames;
+    uint8_t address_space[PAGE_SIZE * PAGE_TABLE_SIZE];
+    tRamImage image = {nullptr, 0};
+};
+
+TEST_F(RamImageTest, AttachRestoresRamAndTasks)
+{
+    ASSERT_EQ(ram_image_save(path), 0);
+    destroy_taskMgr();
+    destroy_ram();
+    memset(ram, 0, sizeof(ram));
+
+    ASSERT_EQ(ram_image_attach(&image, path), NUM_FRAMES);
+    const tRam *attached = get_ram_state();
+    ASSERT_NE(attached, nullptr);
+    EXPECT_NE((const uint8_t *)attached, ram) << "Expected RAM in the mapping";
+    EXPECT_EQ(attached->bitmap, sizeof(tRam));
+    EXPECT_EQ(ram_free_frames(), free_frames);
+
+    tTaskStruct *task = get_task_struct(pid);
+    ASSERT_NE(task, nullptr);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x1);
+    EXPECT_EQ(task->page_table[3].p_bit, 0x1);
+
+    // present pages are accessible right away
+    set_page_table(task->page_table);
+    uint8_t data = 0;
+    ASSERT_EQ(load_data(PAGE_SIZE * 3, &data), 0);
+    EXPECT_EQ(data, 0x53);
+}
+
+TEST_F(RamImageTest, TasksNeedBackingAfterAttach)
+{
+    ASSERT_EQ(ram_image_save(path), 0);
+    destroy_taskMgr();
+    destroy_ram();
+    ASSERT_EQ(ram_image_attach(&image, path), NUM_FRAMES);
+
+    EXPECT_EQ(page_fault(pid, PAGE_SIZE * 2), -5) << "Expected unbound store";
+    EXPECT_EQ(task_set_backing(pid, nullptr, address_space), -2);
+    EXPECT_EQ(task_set_backing(pid + 1, &memory_backing_ops, address_space), -1);
+    ASSERT_EQ(task_set_backing(pid, &memory_backing_ops, address_space), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(ram_free_frames(), free_frames - 1);
+}
+
+TEST_F(RamImageTest, ImageNotChangedByAttachedRun)
+{
+    ASSERT_EQ(ram_image_save(path), 0);
+    destroy_taskMgr();
+    destroy_ram();
+
+    ASSERT_EQ(ram_image_attach(&image, path), NUM_FRAMES);
+    ASSERT_EQ(destroy_task(pid), 0);
+    ram_image_detach(&image);
+    EXPECT_EQ(get_ram_state(), nullptr);
+    EXPECT_EQ(get_task_mgr(), nullptr);
+
+    ASSERT_EQ(ram_image_attach(&image, path), NUM_FRAMES);
+    EXPECT_NE(get_task_struct(pid), nullptr) << "Expected the task still in the image";
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST_F(RamImageTest, AttachWithoutTaskMgr)
+{
+    destroy_task(pid);
+    destroy_taskMgr();
+    ASSERT_EQ(ram_image_save(path), 0);
+    destroy_ram();
+    ASSERT_EQ(ram_image_attach(&image, path), NUM_FRAMES);
+    EXPECT_EQ(get_task_mgr(), nullptr);
+    EXPECT_EQ(ram_free_frames(), NUM_FRAMES - getOccupiedFrames(nullptr));
+}
+
+TEST_F(RamImageTest, SaveReturnsCachedFrames)
+{
+    ASSERT_EQ(ram_set_magazines(1), 0);
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, 1), 0);
+    ffree(frame_id, 1);
+    ASSERT_GT(ram_cached_frames(), 0);
+
+    ASSERT_EQ(ram_image_save(path), 0);
+    EXPECT_EQ(ram_cached_frames(), 0);
+    destroy_taskMgr();
+    destroy_ram();
+    ASSERT_EQ(ram_image_attach(&image, path), NUM_FRAMES);
+    EXPECT_EQ(ram_free_frames(), free_frames) << "Expected no frame lost in a cache";
+}
+
+TEST_F(RamImageTest, AttachChargesTasks)
+{
+    ASSERT_EQ(ram_image_save(path), 0);
+    destroy_taskMgr();
+    destroy_ram();
+    ASSERT_EQ(ram_image_attach(&image, path), NUM_FRAMES);
+
+    EXPECT_EQ(cgroup_of(pid), CGROUP_ROOT);
+    EXPECT_EQ(cgroup_task_usage(pid), 2);
+    EXPECT_EQ(cgroup_usage(CGROUP_ROOT), 2);
+    EXPECT_EQ(cgroup_set_limit(CGROUP_ROOT, 1), -2) << "Expected the frames of the image to count";
+
+    const int small = cgroup_create(CGROUP_ROOT, 1, 0);
+    const int group = cgroup_create(CGROUP_ROOT, 2, 0);
+    EXPECT_EQ(cgroup_attach(pid, small), -2);
+    ASSERT_EQ(cgroup_attach(pid, group), 0);
+    EXPECT_EQ(cgroup_usage(group), 2);
+
+    ASSERT_EQ(task_set_backing(pid, &memory_backing_ops, address_space), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    EXPECT_EQ(cgroup_usage(group), 2);
+    EXPECT_EQ(cgroup_get(group)->limit_hits, 1u) << "Expected the limit to make the task evict a page";
+    CheckFrame(pid, 2);
+}
+
+TEST_F(RamImageTest, CopiedRamUsedWithoutFixup)
+{
+    const uint16_t task_mgr = (const uint8_t *)get_task_mgr() - ram;
+    uint8_t copy[RAM_SIZE];
+    memcpy(copy, ram, RAM_SIZE);
+    destroy_ram();
+
+    ASSERT_EQ(attach_ram(copy, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(attach_taskMgr(task_mgr), 0);
+    EXPECT_EQ(memcmp(copy, ram, RAM_SIZE), 0) << "Expected attach not to change the RAM";
+    EXPECT_EQ(ram_free_frames(), free_frames);
+    ASSERT_EQ(task_set_backing(pid, &memory_backing_ops, address_space), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    CheckFrame(pid, 2);
+
+    // the original RAM is still usable
+    attach_taskMgr(0);
+    destroy_ram();
+    ASSERT_EQ(attach_ram(ram, RAM_SIZE, PAGE_SIZE), NUM_FRAMES);
+    ASSERT_EQ(attach_taskMgr(task_mgr), 0);
+    EXPECT_EQ(get_task_struct(pid)->page_table[2].p_bit, 0x0);
+}
+
+TEST_F(RamImageTest, AttachRejectsCorruptHeader)
+{
+    uint8_t copy[RAM_SIZE];
+    tRam *header = (tRam *)copy;
+    const tRamSize bitmap = ((const tRam *)ram)->bitmap;
+    const tRamSize offsets[] = {0, sizeof(tRam) - 1, RAM_SIZE, RAM_SIZE - 1};
+    for (tRamSize offset : offsets)
+    {
+        memcpy(copy, ram, RAM_SIZE);
+        header->bitmap = offset;
+        EXPECT_EQ(attach_ram(copy, RAM_SIZE, PAGE_SIZE), -2) << "Expected bitmap at " << offset << " rejected";
+    }
+
+    memcpy(copy, ram, RAM_SIZE);
+    header->summary = bitmap;
+    EXPECT_EQ(attach_ram(copy, RAM_SIZE, PAGE_SIZE), -2) << "Expected summary of a small RAM rejected";
+    EXPECT_EQ(get_ram_state(), (const tRam *)ram) << "Expected current RAM kept";
+    EXPECT_EQ(ram_free_frames(), free_frames);
+}
+
+TEST_F(RamImageTest, SaveFailures)
+{
+    EXPECT_EQ(ram_image_save(nullptr), -1);
+    EXPECT_EQ(ram_image_save("/nonexistent/dir/image"), -2);
+
+    get_task_struct(pid)->page_table[5].t_bit = 0x1;
+    EXPECT_EQ(ram_image_save(path), -3);
+    get_task_struct(pid)->page_table[5].t_bit = 0x0;
+}
+
+TEST_F(RamImageTest, AttachRejectsInvalidFiles)
+{
+    EXPECT_EQ(ram_image_attach(nullptr, path), -1);
+    EXPECT_EQ(ram_image_attach(&image, nullptr), -1);
+    EXPECT_EQ(ram_image_attach(&image, "/nonexistent/dir/image"), -2);
+    EXPECT_EQ(ram_image_attach(&image, path), -3) << "Expected empty file rejected";
+
+    ASSERT_EQ(ram_image_save(path), 0);
+    ASSERT_EQ(truncate(path, RAM_IMAGE_HEADER_SIZE + RAM_SIZE - 1), 0);
+    EXPECT_EQ(ram_image_attach(&image, path), -3) << "Expected truncated image rejected";
+    EXPECT_EQ(get_ram_state(), (const tRam *)ram) << "Expected current RAM kept";
+}
+
+TEST(RamUninitializedTest, SaveFailsIfUninitialized)
+{
+    EXPECT_EQ(ram_image_save("/tmp/ospager_unused"), -1);
+}
@@ -1,3 +1,5 @@
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "debug.h"
@@ -26,9 +28,10 @@ class Scale : public RamTestBase
         int ret = init_taskMgr();
         ASSERT_EQ(ret, 0);
         memset(page_tables, 0, sizeof(tPageTableEntry) * TASK_TABLE_SIZE * PAGE_TABLE_SIZE);
-        for (uint8_t id = 0; id < TASK_TABLE_SIZE * PAGE_TABLE_SIZE; id++)
+        for (uint16_t id = 0; id < TASK_TABLE_SIZE * PAGE_TABLE_SIZE; id++)
         {
-            memset(address_spaces + PAGE_SIZE * id, id, PAGE_SIZE);
+            // the fill of a page never equals the value the tests store
+            memset(address_spaces + PAGE_SIZE * id, id % 0xdd, PAGE_SIZE);
             page_tables[id].r = (DATA_PAGE(id)) ? 0x1 : 0x0;
             page_tables[id].w = (WRITE_PAGE(id)) ? 0x1 : 0x0;
             page_tables[id].x = (CODE_PAGE(id)) ? 0x1 : 0x0;
@@ -357,3 +360,61 @@ TEST_F(Scale, MultipleModifiedPagesAreWrittenToAddressSpace)
         }
     }
 }
+
+#ifdef RAM_WIDE
+
+// Megabytes of RAM with 4 KiB pages, only available in the wide configuration.
+TEST(WideScale, AllTasksResidentInMegabytesOfRam)
+{
+    constexpr tRamSize WIDE_RAM_SIZE = 4 * 1024 * 1024;
+    constexpr tPageSize WIDE_PAGE_SIZE = 4096;
+    constexpr tFrameId WIDE_FRAMES = WIDE_RAM_SIZE / WIDE_PAGE_SIZE;
+    std::vector<uint8_t> memory(WIDE_RAM_SIZE);
+    std::vector<uint8_t> address_spaces(WIDE_PAGE_SIZE * PAGE_TABLE_SIZE * TASK_TABLE_SIZE);
+    for (size_t pos = 0; pos < address_spaces.size(); pos++)
+    {
+        address_spaces[pos] = pos / WIDE_PAGE_SIZE + pos % 251;
+    }
+
+    ASSERT_EQ(init_ram(memory.data(), WIDE_RAM_SIZE, WIDE_PAGE_SIZE), (int)WIDE_FRAMES);
+    ASSERT_EQ(init_taskMgr(), 0);
+    const tFrameId free_frames = ram_free_frames();
+    EXPECT_GT(free_frames, WIDE_FRAMES - 4);
+
+    tPageTableEntry page_table[PAGE_TABLE_SIZE];
+    memset(page_table, 0, sizeof(page_table));
+    for (auto &entry : page_table)
+    {
+        entry.r = 0x1;
+        entry.w = 0x1;
+    }
+    for (uint8_t id = 0; id < TASK_TABLE_SIZE; id++)
+    {
+        const int pid = create_task(page_table, 0, address_spaces.data() + id * WIDE_PAGE_SIZE * PAGE_TABLE_SIZE);
+        ASSERT_EQ(pid, id);
+        tTaskStruct *task = get_task_struct(pid);
+        set_page_table(task->page_table);
+        for (uint8_t page_id = 0; page_id < PAGE_TABLE_SIZE; page_id++)
+        {
+            const tVirtAddr address = page_id * WIDE_PAGE_SIZE + WIDE_PAGE_SIZE - 1;
+            uint8_t data = 0;
+            ASSERT_EQ(load_data(address, &data), PAGE_FAULT);
+            ASSERT_EQ(page_fault(pid, address), OK);
+            ASSERT_EQ(load_data(address, &data), OK);
+            EXPECT_EQ(data, address_spaces[id * WIDE_PAGE_SIZE * PAGE_TABLE_SIZE + address]);
+            ASSERT_EQ(store_data(address, data + 1), OK);
+        }
+    }
+    EXPECT_EQ(ram_free_frames(), free_frames - TASK_TABLE_SIZE * PAGE_TABLE_SIZE);
+
+    tFrameId frame_id = 0;
+    ASSERT_EQ(falloc(&frame_id, WIDE_FRAMES / 2), 0) << "Expected frame runs beyond 16 bits of bytes";
+    EXPECT_EQ(ram_largest_free_run(), free_frames - TASK_TABLE_SIZE * PAGE_TABLE_SIZE - WIDE_FRAMES / 2);
+    ffree(frame_id, WIDE_FRAMES / 2);
+
+    set_page_table(nullptr);
+    destroy_taskMgr();
+    destroy_ram();
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test_ram.h"
+
+extern "C" {
+#include "backing.h"
+#include "pager.h"
+#include "snapshot.h"
+#include "task.h"
+}
+
+// Image kept in host memory, read back from the start.
+struct Image
+{
+    std::vector<uint8_t> data;
+    size_t pos = 0;
+    bool fail = false;
+
+    static int Write(void *ctx, const void *data, uint16_t size)
+    {
+        Image *image = static_cast<Image *>(ctx);
+        if (image->fail)
+            return -1;
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        image->data.insert(image->data.end(), bytes, bytes + size);
+        return 0;
+    }
+
+    static int Read(void *ctx, void *data, uint16_t size)
+    {
+        Image *image = static_cast<Image *>(ctx);
+        if (image->pos + size > image->data.size())
+            return -1;
+        memcpy(data, image->data.data() + image->pos, size);
+        image->pos += size;
+        return 0;
+    }
+};
+
+static int FailingWrite(void *, uint16_t, const uint8_t *, uint16_t)
+{
+    return -1;
+}
+
+class SnapshotTest : public RamTestBase
+{
+  protected:
+    static constexpr size_t HEADER_SIZE = 12;
+
+    void SetUp() override
+    {
+        ASSERT_EQ(init_taskMgr(), 0);
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            memset(address_space + PAGE_SIZE * id, 0x30 + id, PAGE_SIZE);
+        }
+        memcpy(copy, address_space, sizeof(copy));
+
+        tPageTableEntry page_table[PAGE_TABLE_SIZE];
+        memset(page_table, 0, sizeof(page_table));
+        page_table[1].r = 0x1;
+        page_table[2].r = 0x1;
+        page_table[2].w = 0x1;
+        page_table[5].x = 0x1;
+        pid = create_task(page_table, 3, address_space);
+        ASSERT_GE(pid, 0);
+        ASSERT_EQ(set_replacement_policy(pid, PAGER_POLICY_AGING), 0);
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+
+        // page 2 is modified in RAM only
+        tTaskStruct *task = get_task_struct(pid);
+        task->page_table[2].m_bit = 0x1;
+        memset(ram + task->page_table[2].frame_id * PAGE_SIZE, 0x42, PAGE_SIZE);
+
+        writer = {Image::Write, &image};
+        reader = {Image::Read, &image};
+    }
+
+    void TearDown() override
+    {
+        destroy_taskMgr();
+    }
+
+    int pid;
+    uint8_t address_space[PAGE_SIZE * PAGE_TABLE_SIZE];
+    uint8_t copy[PAGE_SIZE * PAGE_TABLE_SIZE];  // Address space of the restored task.
+    Image image;
+    tSnapshotWriter writer;
+    tSnapshotReader reader;
+};
+
+TEST_F(SnapshotTest, ImageHoldsOnlyModifiedPages)
+{
+    ASSERT_EQ(snapshot_task(pid, &writer), 0);
+    EXPECT_EQ(image.data.size(), HEADER_SIZE + PAGE_TABLE_SIZE + PAGE_SIZE);
+    EXPECT_EQ(memcmp(image.data.data(), "OSPS", 4), 0);
+    EXPECT_EQ(image.data[4], SNAPSHOT_VERSION);
+    EXPECT_EQ(get_task_struct(pid)->page_table[2].m_bit, 0x1) << "Expected the task not changed";
+}
+
+TEST_F(SnapshotTest, RestoreLoadsPagesLazily)
+{
+    ASSERT_EQ(ram_set_nodes(2, nullptr), 0);
+    ASSERT_EQ(set_lock_limit(pid, 2), 0);
+    ASSERT_EQ(set_large_pages(pid, 1), 0);
+    ASSERT_EQ(set_home_node(pid, 1), 0);
+    ASSERT_EQ(snapshot_task(pid, &writer), 0);
+    const tFrameId free_frames = ram_free_frames();
+    int restored = restore_task(&reader, &memory_backing_ops, copy);
+    ASSERT_GE(restored, 0);
+    EXPECT_NE(restored, pid);
+    EXPECT_EQ(ram_free_frames(), free_frames) << "Expected no frame used by the restore";
+
+    tTaskStruct *task = get_task_struct(restored);
+    ASSERT_NE(task, nullptr);
+    EXPECT_EQ(task->max_frames, 3);
+    EXPECT_EQ(task->policy, PAGER_POLICY_AGING);
+    EXPECT_EQ(task->lock_limit, 2);
+    EXPECT_EQ(task->large_order, 1);
+    EXPECT_EQ(task->home_node, 1);
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        const tPageTableEntry &entry = get_task_struct(pid)->page_table[id];
+        EXPECT_EQ(task->page_table[id].p_bit, 0x0);
+        EXPECT_EQ(task->page_table[id].r, entry.r);
+        EXPECT_EQ(task->page_table[id].w, entry.w);
+        EXPECT_EQ(task->page_table[id].x, entry.x);
+    }
+
+    ASSERT_EQ(page_fault(restored, PAGE_SIZE * 1), 0);
+    ASSERT_EQ(page_fault(restored, PAGE_SIZE * 2), 0);
+    const uint8_t *page1 = ram + task->page_table[1].frame_id * PAGE_SIZE;
+    const uint8_t *page2 = ram + task->page_table[2].frame_id * PAGE_SIZE;
+    EXPECT_EQ(memcmp(page1, address_space + PAGE_SIZE, PAGE_SIZE), 0);
+    EXPECT_EQ(page2[0], 0x42) << "Expected modified content restored";
+    EXPECT_EQ(page2[PAGE_SIZE - 1], 0x42);
+}
+
+TEST_F(SnapshotTest, RestoreLocksLockedPages)
+{
+    ASSERT_EQ(lock_pages(pid, PAGE_SIZE * 2, PAGE_SIZE), 0);
+    ASSERT_EQ(snapshot_task(pid, &writer), 0);
+    const tFrameId free_frames = ram_free_frames();
+    int restored = restore_task(&reader, &memory_backing_ops, copy);
+    ASSERT_GE(restored, 0);
+    EXPECT_EQ(ram_free_frames(), free_frames - 1) << "Expected only the locked page loaded";
+
+    const tTaskStruct *task = get_task_struct(restored);
+    EXPECT_EQ(task->page_table[1].p_bit, 0x0);
+    EXPECT_EQ(task->page_table[1].l_bit, 0x0);
+    ASSERT_EQ(task->page_table[2].p_bit, 0x1);
+    EXPECT_EQ(task->page_table[2].l_bit, 0x1);
+    EXPECT_EQ(ram[task->page_table[2].frame_id * PAGE_SIZE], 0x42) << "Expected modified content locked";
+}
+
+TEST_F(SnapshotTest, RestoreRejectsMissingHomeNode)
+{
+    ASSERT_EQ(ram_set_nodes(2, nullptr), 0);
+    ASSERT_EQ(set_home_node(pid, 1), 0);
+    ASSERT_EQ(snapshot_task(pid, &writer), 0);
+    ASSERT_EQ(ram_set_nodes(1, nullptr), 0);
+
+    EXPECT_EQ(restore_task(&reader, &memory_backing_ops, copy), -4);
+    EXPECT_EQ(get_task_struct(pid + 1), nullptr) << "Expected no task left behind";
+}
+
+TEST_F(SnapshotTest, SnapshotInvalidParams)
+{
+    EXPECT_EQ(snapshot_task(pid + 1, &writer), -1);
+    EXPECT_EQ(snapshot_task(pid, nullptr), -2);
+    image.fail = true;
+    EXPECT_EQ(snapshot_task(pid, &writer), -3);
+}
+
+TEST_F(SnapshotTest, RestoreRejectsBadImage)
+{
+    ASSERT_EQ(snapshot_task(pid, &writer), 0);
+    EXPECT_EQ(restore_task(nullptr, &memory_backing_ops, copy), -2);
+    EXPECT_EQ(restore_task(&reader, nullptr, copy), -2);
+
+    image.data[4] = SNAPSHOT_VERSION + 1;
+    EXPECT_EQ(restore_task(&reader, &memory_backing_ops, copy), -4) << "Expected unknown version rejected";
+
+    image.data[4] = SNAPSHOT_VERSION;
+    image.data[5] = __builtin_ctz(PAGE_SIZE) - 1;
+    image.pos = 0;
+    EXPECT_EQ(restore_task(&reader, &memory_backing_ops, copy), -4) << "Expected other page size rejected";
+
+    image.data[5] = __builtin_ctz(PAGE_SIZE);
+    image.data.resize(image.data.size() - 1);
+    image.pos = 0;
+    EXPECT_EQ(restore_task(&reader, &memory_backing_ops, copy), -4) << "Expected truncated image rejected";
+    EXPECT_EQ(get_task_struct(pid + 1), nullptr) << "Expected no task left behind";
+}
+
+TEST_F(SnapshotTest, RestoreFailsWhenStoreFails)
+{
+    ASSERT_EQ(snapshot_task(pid, &writer), 0);
+    tBackingOps failing = memory_backing_ops;
+    failing.write_page = FailingWrite;
+    EXPECT_EQ(restore_task(&reader, &failing, copy), -5);
+    EXPECT_EQ(get_task_struct(pid + 1), nullptr);
+}
+
+TEST(SnapshotTest_NoTaskMgr, RestoreFails)
+{
+    uint8_t store = 0;
+    Image image;
+    tSnapshotReader reader = {Image::Read, &image};
+    EXPECT_EQ(restore_task(&reader, &memory_backing_ops, &store), -3);
+}
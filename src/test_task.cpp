@@ -25,7 +25,7 @@ class TaskManagerTest : public RamTestBase
   protected:
     void SetUp() override
     {
-        page_table.resize(8);
+        page_table.resize(PAGE_TABLE_SIZE);
         memset(page_table.data(), 1, page_table.size() * sizeof(tPageTableEntry));
         memset(address_space, 2, sizeof(address_space));
         init_taskMgr();
@@ -53,8 +53,10 @@ TEST(TaskManagerTest_NoRam, InitManagerWithoutRamInit)
 TEST(TaskManagerTest_NoRam, InitManagerNotEnoughResources)
 {
     uint8_t buffer[nextPow2(sizeof(tRam))];
+    memset(buffer, 0, sizeof(buffer));
     init_ram(&buffer, nextPow2(sizeof(tRam)), nextPow2(sizeof(tRam)));
     EXPECT_EQ(init_taskMgr(), -1);
+    destroy_ram();
 }
 
 TEST_F(TaskManagerTest, InitAndDestroyManager)
@@ -170,4 +172,36 @@ TEST_F(TaskManagerTest, GetTaskStructNonexistentTask)
 {
     EXPECT_EQ(get_task_struct(5), nullptr);
     EXPECT_EQ(get_task_struct(9999), nullptr);
+    EXPECT_EQ(get_task_struct(-1), nullptr) << "Expected free slots not to be found";
+}
+
+TEST_F(TaskManagerTest, GetTaskSlot)
+{
+    int pid = create_task(page_table.data(), 2, address_space);
+    ASSERT_GE(pid, 0);
+
+    EXPECT_EQ(get_task_slot(pid), get_task_struct(pid));
+    EXPECT_EQ(get_task_slot(pid + 1), nullptr) << "Expected free slot skipped";
+    EXPECT_EQ(get_task_slot(TASK_TABLE_SIZE), nullptr);
+}
+
+TEST_F(TaskManagerTest, TaskBackingKeptOutsideOfRam)
+{
+    int pid = create_task(page_table.data(), 2, address_space);
+    ASSERT_GE(pid, 0);
+
+    const tTaskStruct *task = get_task_struct(pid);
+    const tTaskBacking *backing = get_task_backing(task);
+    ASSERT_NE(backing, nullptr);
+    EXPECT_EQ(backing->ops, &memory_backing_ops);
+    EXPECT_EQ(backing->store, address_space);
+    EXPECT_TRUE((const uint8_t *)backing < ram || (const uint8_t *)backing >= ram + RAM_SIZE);
+
+    uint8_t other[PAGE_SIZE * PAGE_TABLE_SIZE];
+    ASSERT_EQ(task_set_backing(pid, &memory_backing_ops, other), 0);
+    EXPECT_EQ(get_task_backing(task)->store, other);
+
+    ASSERT_EQ(destroy_task(pid), 0);
+    EXPECT_EQ(get_task_backing(task)->ops, &unbound_backing_ops);
+    EXPECT_EQ(get_task_backing(nullptr), nullptr);
 }
@@ -0,0 +1,155 @@
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "test_ram.h"
+
+extern "C" {
+#include "pager.h"
+#include "task.h"
+#include "wss.h"
+}
+
+class WssTest : public RamTestBase
+{
+  protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(init_taskMgr(), 0);
+        tPageTableEntry page_table[PAGE_TABLE_SIZE];
+        memset(page_table, 0, sizeof(page_table));
+        for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+        {
+            page_table[id].r = 0x1;
+        }
+        memset(address_space, 0xab, sizeof(address_space));
+        pid = create_task(page_table, 2, address_space);
+        ASSERT_GE(pid, 0);
+        task = get_task_struct(pid);
+        ASSERT_NE(task, nullptr);
+    }
+
+    void TearDown() override
+    {
+        destroy_taskMgr();
+    }
+
+    int pid;
+    tTaskStruct *task;
+    uint8_t address_space[PAGE_SIZE * PAGE_TABLE_SIZE];
+};
+
+TEST(WssTest_NoTaskMgr, TickFails)
+{
+    EXPECT_EQ(wss_tick(), -1);
+}
+
+TEST_F(WssTest, UnknownTask)
+{
+    EXPECT_EQ(wss_get_estimate(pid + 1), -1);
+    EXPECT_EQ(wss_set_tuning(pid + 1, 0, 1), -1);
+}
+
+TEST_F(WssTest, InvalidTuningBounds)
+{
+    EXPECT_EQ(wss_set_tuning(pid, 3, 2), -2);
+}
+
+TEST_F(WssTest, NewTaskHasEmptyWorkingSet)
+{
+    EXPECT_EQ(wss_get_estimate(pid), 0);
+    EXPECT_EQ(wss_tick(), 0);
+    EXPECT_EQ(wss_get_estimate(pid), 0);
+}
+
+TEST_F(WssTest, EstimateCountsFaultedPages)
+{
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    ASSERT_EQ(wss_tick(), 0);
+    EXPECT_EQ(wss_get_estimate(pid), 2);
+}
+
+TEST_F(WssTest, EstimateSamplesReferenceBits)
+{
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+    ASSERT_EQ(wss_tick(), 0);
+    for (uint8_t tick = 0; tick < WSS_WINDOW * 2; tick++)
+    {
+        task->page_table[1].r_bit = 0x1;
+        ASSERT_EQ(wss_tick(), 0);
+        EXPECT_EQ(task->page_table[1].r_bit, 0x0) << "Expected tick to clear r_bit";
+    }
+    EXPECT_EQ(wss_get_estimate(pid), 1);
+}
+
+TEST_F(WssTest, EstimateForgetsPagesOutsideWindow)
+{
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 1), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 2), 0);
+    for (uint8_t tick = 0; tick < WSS_WINDOW; tick++)
+    {
+        ASSERT_EQ(wss_tick(), 0);
+        EXPECT_EQ(wss_get_estimate(pid), 2);
+    }
+    ASSERT_EQ(wss_tick(), 0);
+    EXPECT_EQ(wss_get_estimate(pid), 0);
+}
+
+TEST_F(WssTest, NoTuningByDefault)
+{
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+    }
+    ASSERT_EQ(wss_tick(), 0);
+    EXPECT_EQ(task->max_frames, 2);
+}
+
+TEST_F(WssTest, TuningGrowsOnHighFaultRate)
+{
+    ASSERT_EQ(wss_set_tuning(pid, 0, 2), 0);
+    for (uint8_t id = 0; id < 5; id++)
+    {
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+    }
+    ASSERT_EQ(wss_tick(), 0);
+    EXPECT_EQ(wss_get_estimate(pid), 5);
+    EXPECT_EQ(task->max_frames, 5) << "Expected max_frames raised to the working set";
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 5), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 6), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 7), 0);
+    ASSERT_EQ(wss_tick(), 0);
+    EXPECT_EQ(task->max_frames, 8) << "Expected max_frames raised to the new estimate";
+}
+
+TEST_F(WssTest, TuningShrinksTowardsEstimate)
+{
+    task->max_frames = 0;
+    ASSERT_EQ(wss_set_tuning(pid, 1, 4), 0);
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 3), 0);
+    for (uint8_t tick = 0; tick < PAGE_TABLE_SIZE * 2; tick++)
+    {
+        task->page_table[3].r_bit = 0x1;
+        ASSERT_EQ(wss_tick(), 0);
+        EXPECT_GE(task->max_frames, 1);
+    }
+    EXPECT_EQ(wss_get_estimate(pid), 1);
+    EXPECT_EQ(task->max_frames, 1);
+}
+
+TEST_F(WssTest, ShrunkLimitIsRespectedByPager)
+{
+    task->max_frames = 0;
+    for (uint8_t id = 0; id < 4; id++)
+    {
+        ASSERT_EQ(page_fault(pid, PAGE_SIZE * id), 0);
+    }
+    task->max_frames = 2;
+    ASSERT_EQ(page_fault(pid, PAGE_SIZE * 4), 0);
+    uint8_t present = 0;
+    for (uint8_t id = 0; id < PAGE_TABLE_SIZE; id++)
+    {
+        present += task->page_table[id].p_bit;
+    }
+    EXPECT_EQ(present, 4) << "Expected no new frame allocated above the limit";
+}